@@ -9,3 +9,6 @@ config :aria_planner,
 config :aria_planner, AriaPlanner.Repo,
   database: Path.join(["priv", "aria_planner_#{Mix.env()}.db"]),
   pool_size: 10
+
+# Set debug: true to log planner debug events (compiled out otherwise)
+config :aria_planner, AriaCore.Planner.Trace, debug: false
@@ -0,0 +1,118 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2025-present K. S. Ernest (iFire) Lee
+
+defmodule AriaCore.Planner.CompiledDomain do
+  @moduledoc """
+  Dispatch tables for lazy plan refinement.
+
+  `compile/2` interns every task, action and goal name, and every multigoal
+  tag, into a dense integer symbol and builds tuples indexed by that symbol:
+  the node type, the name, and the handler (the method list for tasks, goals
+  and multigoals, the action function for actions). Refinement classifies a
+  child node with a single symbol lookup and dispatches through `elem/2`
+  instead of consulting the method and action dictionaries per child.
+
+  A name registered as both a task and an action (or goal) resolves to the
+  task, then the action, then the goal.
+  """
+
+  alias AriaCore.Planner.Actions
+  alias AriaCore.Planner.Methods
+  alias AriaCore.Planner.MultiGoal
+
+  @enforce_keys [:symbols, :multigoal_symbols, :types, :names, :handlers]
+  defstruct [:symbols, :multigoal_symbols, :types, :names, :handlers]
+
+  @type node_type :: :T | :A | :G | :M
+  @type symbol :: non_neg_integer()
+
+  @type t :: %__MODULE__{
+          # task, action and goal name => symbol
+          symbols: %{term() => symbol()},
+          # multigoal tag => symbol
+          multigoal_symbols: %{term() => symbol()},
+          # symbol => node_type()
+          types: tuple(),
+          # symbol => name or multigoal tag
+          names: tuple(),
+          # symbol => [method] for :T, :G and :M, action function for :A
+          handlers: tuple()
+        }
+
+  @doc """
+  Builds the dispatch tables for a domain's methods and actions.
+
+  Method dictionary entries may hold a single function or a list of
+  functions; both compile to a method list.
+  """
+  @spec compile(Methods.t(), Actions.t()) :: t()
+  def compile(methods, actions) do
+    named =
+      Enum.map(dict(methods.task_method_dict), fn {name, fun} -> {:T, name, List.wrap(fun)} end) ++
+        Enum.map(dict(actions.action_dict), fn {name, fun} -> {:A, name, fun} end) ++
+        Enum.map(dict(methods.goal_method_dict), fn {name, fun} -> {:G, name, List.wrap(fun)} end)
+
+    named = Enum.uniq_by(named, fn {_type, name, _handler} -> name end)
+    tagged = Enum.map(dict(methods.multigoal_method_dict), fn {tag, fun} -> {:M, tag, List.wrap(fun)} end)
+    entries = named ++ tagged
+
+    %__MODULE__{
+      symbols: intern(named, 0),
+      multigoal_symbols: intern(tagged, length(named)),
+      types: entries |> Enum.map(&elem(&1, 0)) |> List.to_tuple(),
+      names: entries |> Enum.map(&elem(&1, 1)) |> List.to_tuple(),
+      handlers: entries |> Enum.map(&elem(&1, 2)) |> List.to_tuple()
+    }
+  end
+
+  defp dict(nil), do: %{}
+  defp dict(dict), do: dict
+
+  defp intern(entries, first_symbol) do
+    entries
+    |> Enum.with_index(first_symbol)
+    |> Map.new(fn {{_type, name, _handler}, symbol} -> {name, symbol} end)
+  end
+
+  @doc """
+  Classifies a node's info into its node type and symbol.
+
+  Multigoals without registered methods still classify as `:M`, with a `nil`
+  symbol. Returns `:unknown` for infos naming nothing in the domain.
+  """
+  @spec classify(t(), term()) :: {node_type(), symbol() | nil} | :unknown
+  def classify(%__MODULE__{multigoal_symbols: multigoal_symbols}, %MultiGoal{goal_tag: goal_tag}) do
+    {:M, Map.get(multigoal_symbols, goal_tag)}
+  end
+
+  def classify(%__MODULE__{symbols: symbols, types: types}, node_info)
+      when is_tuple(node_info) and tuple_size(node_info) > 0 do
+    case Map.fetch(symbols, elem(node_info, 0)) do
+      {:ok, symbol} -> {elem(types, symbol), symbol}
+      :error -> :unknown
+    end
+  end
+
+  def classify(%__MODULE__{}, _node_info), do: :unknown
+
+  @doc """
+  Returns the handler for a symbol: the method list for tasks, goals and
+  multigoals, or the action function for actions. A `nil` symbol has no
+  methods.
+  """
+  @spec handler(t(), symbol() | nil) :: [fun()] | fun()
+  def handler(%__MODULE__{}, nil), do: []
+  def handler(%__MODULE__{handlers: handlers}, symbol), do: elem(handlers, symbol)
+
+  @doc """
+  Returns the name (or multigoal tag) interned as `symbol`.
+  """
+  @spec name(t(), symbol()) :: term()
+  def name(%__MODULE__{names: names}, symbol), do: elem(names, symbol)
+
+  @doc """
+  Number of interned symbols.
+  """
+  @spec size(t()) :: non_neg_integer()
+  def size(%__MODULE__{types: types}), do: tuple_size(types)
+end
@@ -0,0 +1,30 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2025-present K. S. Ernest (iFire) Lee
+
+defmodule AriaCore.Planner.Heuristic do
+  @moduledoc """
+  Behaviour for the heuristics that guide the `:best_first`, `:astar` and
+  `:beam` strategies of `AriaCore.Planner.LazyRefinement`.
+
+  A heuristic estimates the cost, in the milliseconds of action durations,
+  still needed to complete a partial plan. It gets the partial plan's state
+  and the nodes left to refine, in plan order: the info tuples of open
+  tasks, goals and actions, and `AriaCore.Planner.MultiGoal`s.
+
+  With `:astar`, an estimate that never exceeds the real remaining cost
+  (with `:weight` 1) makes the first complete plan found a cheapest one.
+
+  ## Example
+
+      defmodule Deliveries do
+        @behaviour AriaCore.Planner.Heuristic
+
+        @impl true
+        def estimate(_state, pending), do: 10 * Enum.count(pending, &match?({"t_deliver", _}, &1))
+      end
+
+      LazyRefinement.run_lazy_refineahead(domain_spec, state_params, plan, strategy: :astar, heuristic: Deliveries)
+  """
+
+  @callback estimate(state :: AriaCore.Planner.State.t(), pending :: [term()]) :: number()
+end
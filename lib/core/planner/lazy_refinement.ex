@@ -5,20 +5,91 @@ defmodule AriaCore.Planner.LazyRefinement do
   @moduledoc """
   Implements the lazy plan refinement logic, executing actions incrementally
   and handling blacklisting, similar to IPyHOP's planning mechanism.
+
+  ## Options
+
+    * `:portfolio` - number of method alternatives of a task, goal or
+      multigoal node explored concurrently, each in its own process with its
+      own copy of the state. The first alternative whose subtree refines
+      completely wins and the others are cancelled. Defaults to `1`, which
+      tries methods one at a time. Only the outermost loop races; the
+      subtrees themselves are refined serially.
+    * `:nogoods` - capacity of the `NogoodTable` of task, goal and multigoal
+      refinements known to fail in a given state. Nodes found there are
+      backtracked from without being refined. Each node's key hashes its
+      arguments once, so domains whose tasks carry the whole domain state
+      should leave the table off. Defaults to `0`, which disables it; a few
+      thousand entries suit domains with small arguments. Raced subtrees
+      start with a table of their own.
+    * `:backjumping` - when `true`, a failed action or goal verification
+      that knows which facts caused it jumps back to the deepest choice
+      point whose subtree wrote them, see `Backtracking`. Verifications
+      blame the facts of their unachieved goals; actions can blame facts by
+      returning `{:error, reason, fact_refs}`. Faster on deep failures but
+      incomplete. Defaults to `false`.
+    * `:strategy` - how the space of partial plans is searched:
+      * `:depth_first` (default) - one partial plan, refined with the first
+        method that applies and backtracked on failure
+      * `:best_first` - every applicable method of a task, goal or
+        multigoal opens a partial plan of its own; the one with the lowest
+        heuristic estimate is refined next, until the next choice
+      * `:astar` - as `:best_first`, ordered by the actions' total
+        `duration` so far plus `:weight` times the estimate
+      * `:beam` - as `:astar`, but only the `:beam_width` best partial
+        plans of each generation are kept
+
+      The frontier is kept by `Search`. Partial plans only branch, so the
+      other strategies ignore `:portfolio`, `:nogoods` and `:backjumping`.
+    * `:heuristic` - module implementing `AriaCore.Planner.Heuristic`.
+      Without one, every estimate is `0`: `:best_first` refines partial
+      plans in the order they were opened and `:astar` is uniform-cost.
+    * `:weight` - weight of the heuristic for `:astar` and `:beam`.
+      Defaults to `1`.
+    * `:beam_width` - partial plans kept per generation by `:beam`.
+      Defaults to `10`.
+    * `:time_limit`, `:max_iterations`, `:max_backtracks`, `:max_memory` -
+      budgets for the call, see `Budget`. When one runs out, the call
+      returns `{:stopped, plan, continuation}` with the partial plan
+      refined so far, and `resume_lazy_refineahead/2` refines on from
+      there. Budgets are checked between iterations, and a `:portfolio`
+      race counts as one. Its workers share the `:time_limit`: a race
+      still running when it expires is cancelled and the call stops
+      before the raced node, to race it again on resume. Unlimited by
+      default.
+
+  A `domain_spec` may list `:derived_facts`, top-level fact keys that are
+  functions of the other facts; they are left out of the state's
+  fingerprint, see `State.new/5`.
+
+  Runs, iterations, refinements, actions and backtracks are reported
+  through `AriaCore.Planner.Trace`.
   """
 
-  require Logger
+  require AriaCore.Planner.Trace
 
   alias AriaCore.Plan
   alias AriaCore.Planner.State
   alias AriaCore.Planner.Methods
   alias AriaCore.Planner.Actions
-  # alias AriaCore.Planner.MultiGoal # Removed unused alias
-  # alias __MODULE__, as: LazyRefinement # Removed unused alias
-
+  alias AriaCore.Planner.CompiledDomain
   alias AriaCore.Planner.LazyRefinement.GraphOperations
   alias AriaCore.Planner.LazyRefinement.Backtracking
+  alias AriaCore.Planner.LazyRefinement.Budget
+  alias AriaCore.Planner.LazyRefinement.NogoodTable
   alias AriaCore.Planner.LazyRefinement.NodeUtils
+  alias AriaCore.Planner.LazyRefinement.Portfolio
+  alias AriaCore.Planner.LazyRefinement.Search
+  alias AriaCore.Planner.LazyRefinement.SolutionGraph
+  alias AriaCore.Planner.Trace
+
+  @beam_width 10
+  # Iterations between truncations of the state's trail
+  @trail_compaction 1024
+
+  @typedoc """
+  Where a run stopped by a budget left off, for `resume_lazy_refineahead/2`.
+  """
+  @opaque continuation :: %{plan: Plan.t(), resume: (keyword() -> tuple())}
 
   # This function will be the core of the lazy refinement process.
   # It will take a plan, an initial state, and other options, and
@@ -33,36 +104,50 @@ defmodule AriaCore.Planner.LazyRefinement do
           },
           plan :: Plan.t(),
           opts :: keyword()
-        ) :: {:ok, Plan.t()} | {:error, String.t()}
-  # Fix unused opts
-  def run_lazy_refineahead(domain_spec, initial_state_params, plan, _opts \\ []) do
-    Logger.info("Starting lazy refinement for plan #{plan.id}")
-
-    # Initialize planning state using the new State.new/4 function
+        ) :: {:ok, Plan.t()} | {:stopped, Plan.t(), continuation()} | {:error, String.t()}
+  def run_lazy_refineahead(domain_spec, initial_state_params, plan, opts \\ []) do
+    # Initialize planning state using the new State.new/5 function
     current_state =
       State.new(
         initial_state_params.current_time,
         initial_state_params.timeline,
         initial_state_params.entity_capabilities,
-        initial_state_params.facts
+        initial_state_params.facts,
+        Map.get(domain_spec, :derived_facts, [])
       )
 
     # Node 0 is the root
-    solution_graph = %{0 => %{info: {:root}, type: :D, status: :NA, successors: []}}
+    solution_graph = SolutionGraph.new(%{info: {:root}, type: :D, status: :NA, successors: []})
     blacklisted_commands = MapSet.new()
 
-    # Extract methods, actions, and initial tasks from domain_spec
-    methods = domain_spec.methods
-    actions = domain_spec.actions
-    initial_tasks = domain_spec.initial_tasks
+    # Compile the domain's methods and actions into dispatch tables once per run
+    domain = CompiledDomain.compile(domain_spec.methods, domain_spec.actions)
+
+    strategy = Keyword.get(opts, :strategy, :depth_first)
+    depth_first? = strategy == :depth_first
+
+    # The loop runs until it is back at `boundary` with nothing left open
+    ctx = %{
+      domain: domain,
+      boundary: 0,
+      portfolio: if(depth_first?, do: Keyword.get(opts, :portfolio, 1), else: 1),
+      nogoods: if(depth_first?, do: Keyword.get(opts, :nogoods, 0), else: 0),
+      backjumping: depth_first? and Keyword.get(opts, :backjumping, false),
+      strategy: strategy,
+      heuristic: Keyword.get(opts, :heuristic),
+      weight: Keyword.get(opts, :weight, 1),
+      beam_width: Keyword.get(opts, :beam_width, @beam_width),
+      # Partial plans cost the time their actions took since then
+      started_at: current_state.current_time,
+      # Budget of the iteration being refined, whose time limit raced workers share
+      budget: nil
+    }
 
     # Add initial tasks to the solution graph
-    # Fix _id
-    id = 0
     parent_node_id = 0
-    # Fix _id
-    {id, solution_graph} =
-      GraphOperations.add_nodes_and_edges(id, parent_node_id, initial_tasks, solution_graph, methods, actions)
+
+    {_last_id, solution_graph} =
+      GraphOperations.add_nodes_and_edges(parent_node_id, domain_spec.initial_tasks, solution_graph, domain)
 
     updated_plan =
       plan
@@ -70,562 +155,664 @@ defmodule AriaCore.Planner.LazyRefinement do
       |> Map.put(:execution_started_at, DateTime.utc_now())
 
     # Start the planning loop
-    # Fix _id
-    {final_state, final_solution_graph, _final_blacklisted_commands, iterations} =
-      planning_loop(id, parent_node_id, current_state, solution_graph, blacklisted_commands, methods, actions)
+    run(updated_plan, fn ->
+      planning_loop(parent_node_id, current_state, solution_graph, blacklisted_commands, Budget.new(opts, 0), ctx)
+    end)
+  end
 
-    # After execution, update plan status
-    # Removed redundant assignment to _final_plan
+  @doc """
+  Refines on from where a run stopped by a budget left off.
+
+  Takes the budget options of `run_lazy_refineahead/4`, which count from
+  this call; the other options stay those of the original run. Returns
+  like `run_lazy_refineahead/4`. A continuation can be resumed more than
+  once, each time from the same point.
+  """
+  @spec resume_lazy_refineahead(continuation(), keyword()) ::
+          {:ok, Plan.t()} | {:stopped, Plan.t(), continuation()} | {:error, String.t()}
+  def resume_lazy_refineahead(%{plan: plan, resume: resume}, opts \\ []) do
+    run(plan, fn -> resume.(opts) end)
+  end
+
+  defp run(plan, loop) do
+    {result, final_state, final_solution_graph, _final_blacklisted_commands, nogoods, _budget, iterations} =
+      Trace.span(:run, %{plan_id: plan.id}, loop)
+
+    Trace.event(:nogoods, NogoodTable.stats(nogoods), %{plan_id: plan.id})
 
     # Extract the solution plan (sequence of actions)
     solution_plan = GraphOperations.extract_solution_plan(final_solution_graph)
 
     # Calculate total planning duration
     planning_duration_ms =
-      Enum.reduce(Map.values(final_solution_graph), 0, fn node, acc ->
-        if node.type == :A and Map.has_key?(node, :duration) do
+      Enum.reduce(SolutionGraph.nodes(final_solution_graph), 0, fn node, acc ->
+        if node.type == :A and is_integer(node.duration) do
           acc + node.duration
         else
           acc
         end
       end)
 
-    # Fix unused final_plan
     final_plan =
-      updated_plan
-      |> Map.put(:execution_status, "completed")
+      plan
+      |> Map.put(:execution_status, execution_status(result))
       |> Map.put(:execution_completed_at, DateTime.utc_now())
       # Store the final graph
-      |> Map.put(:solution_graph_data, final_solution_graph)
+      |> Map.put(:solution_graph_data, SolutionGraph.to_map(final_solution_graph))
       # Store final state snapshot
       |> Map.put(:planner_state_snapshot, Jason.encode!(final_state))
       # Store the extracted plan
-      |> Map.put(:solution_plan, Jason.encode!(solution_plan))
+      |> Map.put(:solution_plan, Jason.encode!(Enum.map(solution_plan, &Tuple.to_list/1)))
       # Store the total duration
       |> Map.put(:planning_duration_ms, planning_duration_ms)
 
-    Logger.info(
-      "Completed lazy refinement for plan #{plan.id} in #{iterations} iterations. Total duration: #{planning_duration_ms}ms."
-    )
+    Trace.debug(:completed, %{
+      plan_id: plan.id,
+      result: result,
+      iterations: iterations,
+      duration_ms: planning_duration_ms
+    })
+
+    case result do
+      {:stopped, reason, resume} ->
+        metrics = Map.put(final_plan.performance_metrics || %{}, :stopped_by, reason)
+        {:stopped, %{final_plan | performance_metrics: metrics}, %{plan: plan, resume: resume}}
+
+      _ ->
+        # Return the final plan
+        {:ok, final_plan}
+    end
+  end
 
-    # Return the final plan
-    {:ok, final_plan}
+  defp execution_status(:ok), do: "completed"
+  defp execution_status({:stopped, _reason, _resume}), do: "stopped"
+  defp execution_status(_result), do: "failed"
+
+  # Helper function to simulate IPyHOP's _planning logic.
+  # Returns {result, state, solution_graph, blacklisted_commands, nogoods, budget, iterations}, with
+  # result :ok, :failure or, when the budget ran out, {:stopped, reason, resume} where resume
+  # takes the budget options to refine on with.
+  defp planning_loop(parent_node_id, current_state, solution_graph, blacklisted_commands, budget, ctx)
+       when ctx.strategy == :depth_first do
+    nogoods = NogoodTable.new(ctx.nogoods)
+    depth_first(parent_node_id, current_state, solution_graph, blacklisted_commands, nogoods, budget, ctx, 0)
   end
 
-  # Helper function to simulate IPyHOP's _planning logic
-  # This will be expanded to handle tasks, actions, goals, multigoals,
-  # backtracking, and state updates.
-  # Fix _id
-  defp planning_loop(id, parent_node_id, current_state, solution_graph, blacklisted_commands, methods, actions) do
-    # Fix _iter
-    iter = 0
-    # Fix _id, _iter
-    planning_loop_recursive(
-      id,
-      parent_node_id,
-      current_state,
-      solution_graph,
-      blacklisted_commands,
-      methods,
-      actions,
-      iter
-    )
+  defp planning_loop(parent_node_id, current_state, solution_graph, blacklisted_commands, budget, ctx) do
+    partial_plan = {:partial, parent_node_id, current_state, solution_graph, blacklisted_commands}
+    frontier = ctx.strategy |> Search.new(ctx.beam_width) |> Search.push(0, partial_plan)
+    search(frontier, partial_plan, budget, ctx, 0)
+  end
+
+  defp depth_first(parent_node_id, state, graph, blacklisted, nogoods, budget, ctx, iter) do
+    case planning_loop_recursive(parent_node_id, state, graph, blacklisted, nogoods, budget, ctx, iter) do
+      {{:stopped, reason, stop_node_id}, state, graph, blacklisted, nogoods, budget, iter} ->
+        resume = fn opts ->
+          depth_first(stop_node_id, state, graph, blacklisted, nogoods, Budget.new(opts, iter), ctx, iter)
+        end
+
+        {{:stopped, reason, resume}, state, graph, blacklisted, nogoods, budget, iter}
+
+      result ->
+        result
+    end
+  end
+
+  # Refines partial plans from the frontier. Each runs the loop until it
+  # fails, reaches a node with a choice of methods, which opens one partial
+  # plan per method, or completes. A complete plan goes back to the
+  # frontier with its final cost and is only returned once it comes out
+  # first, so that A* returns the cheapest plan when its heuristic never
+  # overestimates. A partial plan stopped by the budget goes back to the
+  # frontier as it is.
+  defp search(frontier, last_plan, budget, ctx, iter) do
+    case Search.pop(frontier) do
+      {{:complete, state, graph, blacklisted}, _frontier} ->
+        {:ok, state, graph, blacklisted, NogoodTable.new(0), budget, iter}
+
+      {{:partial, parent_node_id, state, graph, blacklisted} = partial_plan, frontier} ->
+        nogoods = NogoodTable.new(0)
+
+        case planning_loop_recursive(parent_node_id, state, graph, blacklisted, nogoods, budget, ctx, iter) do
+          {:ok, state, graph, blacklisted, _nogoods, budget, iter} ->
+            frontier = Search.push(frontier, priority(state, graph, ctx), {:complete, state, graph, blacklisted})
+            search(frontier, last_plan, budget, ctx, iter)
+
+          {:failure, _state, _graph, _blacklisted, _nogoods, budget, iter} ->
+            search(frontier, partial_plan, budget, ctx, iter)
+
+          {{:stopped, reason, stop_node_id}, state, graph, blacklisted, nogoods, budget, iter} ->
+            stopped_plan = {:partial, stop_node_id, state, graph, blacklisted}
+            frontier = Search.push(frontier, priority(state, graph, ctx), stopped_plan)
+            resume = fn opts -> search(frontier, last_plan, Budget.new(opts, iter), ctx, iter) end
+            {{:stopped, reason, resume}, state, graph, blacklisted, nogoods, budget, iter}
+
+          {{:branch, node_id, choices}, state, graph, blacklisted, _nogoods, budget, iter} ->
+            node = SolutionGraph.get(graph, node_id)
+
+            frontier =
+              Enum.reduce(choices, frontier, fn {method, subnodes}, frontier ->
+                graph = expand(graph, node_id, node, method, subnodes, [], ctx.domain)
+                Search.push(frontier, priority(state, graph, ctx), {:partial, node_id, state, graph, blacklisted})
+              end)
+
+            search(frontier, last_plan, budget, ctx, iter)
+        end
+
+      :empty ->
+        {:partial, _parent_node_id, state, graph, blacklisted} = last_plan
+        {:failure, state, graph, blacklisted, NogoodTable.new(0), budget, iter}
+    end
+  end
+
+  defp priority(state, graph, ctx) do
+    cost = DateTime.diff(state.current_time, ctx.started_at, :millisecond)
+    estimate = if ctx.heuristic, do: ctx.heuristic.estimate(state, GraphOperations.open_nodes(graph)), else: 0
+
+    case ctx.strategy do
+      :best_first -> estimate
+      _ -> cost + ctx.weight * estimate
+    end
   end
 
-  # Fix _id, _iter
   defp planning_loop_recursive(
-         id,
          parent_node_id,
          current_state,
          solution_graph,
          blacklisted_commands,
-         methods,
-         actions,
+         nogoods,
+         budget,
+         ctx,
          iter
        ) do
-    # Find the first Open node (BFS-like)
-    Logger.info("planning_loop_recursive: id=#{id}, parent_node_id=#{parent_node_id}, iter=#{iter}")
+    case Budget.exhausted(budget, iter) do
+      nil ->
+        iterate(parent_node_id, current_state, solution_graph, blacklisted_commands, nogoods, budget, ctx, iter)
+
+      reason ->
+        # Stopped before refining under parent_node_id, which is where to resume
+        Trace.debug(:stopped, %{reason: reason, iteration: iter, node_id: parent_node_id})
+        stopped = {:stopped, reason, parent_node_id}
+        {stopped, current_state, solution_graph, blacklisted_commands, nogoods, budget, iter}
+    end
+  end
 
+  defp iterate(parent_node_id, current_state, solution_graph, blacklisted_commands, nogoods, budget, ctx, iter) do
+    # Find the first Open node (BFS-like)
     case GraphOperations.find_open_node(solution_graph, parent_node_id) do
       {:ok, curr_node_id} ->
-        Logger.info("Iteration #{iter}, Refining node #{inspect(Map.get(solution_graph, curr_node_id).info)}")
-        curr_node = Map.get(solution_graph, curr_node_id)
+        curr_node = SolutionGraph.get(solution_graph, curr_node_id)
+        Trace.debug(:refining, %{iteration: iter, node_id: curr_node_id, info: curr_node.info})
+        started_at = System.monotonic_time()
+
+        # Take a trail checkpoint on first visit; when revisiting after a
+        # backtrack, unwind the fact writes made since that checkpoint
+        {curr_node, current_state, solution_graph} =
+          case curr_node do
+            %{checkpoint: nil} ->
+              curr_node = %{
+                curr_node
+                | checkpoint: State.checkpoint(current_state),
+                  nogood_key: nogood_key(curr_node, current_state, ctx)
+              }
+
+              {curr_node, current_state, SolutionGraph.put(solution_graph, curr_node_id, curr_node)}
+
+            %{checkpoint: checkpoint} ->
+              {curr_node, State.restore(current_state, checkpoint), solution_graph}
+
+            _ ->
+              {curr_node, current_state, solution_graph}
+          end
 
-        # Save current state if first visit
-        solution_graph =
-          if Map.has_key?(curr_node, :state) and is_nil(curr_node.state) do
-            Map.put(solution_graph, curr_node_id, %{curr_node | state: current_state})
-          else
-            solution_graph
+        current_state = compact_trail(current_state, solution_graph, curr_node_id, iter)
+
+        # A task, goal or multigoal that already failed in this state fails again
+        {known_failure?, nogoods} =
+          case Map.get(curr_node, :nogood_key) do
+            nil -> {false, nogoods}
+            key -> NogoodTable.failed?(nogoods, key)
           end
 
-        # Restore state if backtracking
-        current_state =
-          if Map.has_key?(curr_node, :state) and not is_nil(curr_node.state) do
-            curr_node.state
+        transition =
+          if known_failure? do
+            Trace.debug(:known_failure, %{node_id: curr_node_id, info: curr_node.info})
+            {:backtrack, curr_node_id, current_state, solution_graph, blacklisted_commands}
           else
-            current_state
+            ctx = %{ctx | budget: budget}
+            refine(curr_node, curr_node_id, parent_node_id, current_state, solution_graph, blacklisted_commands, ctx)
           end
 
-        case curr_node.type do
-          # Task
-          :T ->
-            case Enum.find_value(curr_node.available_methods, fn method ->
-                   subtasks = apply(method, [current_state | Tuple.to_list(curr_node.info)])
-                   if subtasks != nil, do: {method, subtasks}, else: nil
-                 end) do
-              {selected_method, subtasks} ->
-                Logger.info(
-                  "Task #{inspect(curr_node.info)} successfully refined with method #{inspect(selected_method)}"
-                )
-
-                solution_graph =
-                  Map.put(solution_graph, curr_node_id, %{curr_node | status: :C, selected_method: selected_method})
-
-                # Fix _id
-                {new_id, new_solution_graph} =
-                  GraphOperations.add_nodes_and_edges(id, curr_node_id, subtasks, solution_graph, methods, actions)
-
-                # Fix _id, _iter
-                planning_loop_recursive(
-                  new_id,
-                  curr_node_id,
-                  current_state,
-                  new_solution_graph,
-                  blacklisted_commands,
-                  methods,
-                  actions,
-                  iter + 1
-                )
-
-              _ ->
-                Logger.warning("Task #{inspect(curr_node.info)} refinement failed. Backtracking.")
-
-                {new_parent_node_id, _new_curr_node_id, new_solution_graph, new_current_state, new_blacklisted_commands} =
-                  Backtracking.backtrack(
-                    solution_graph,
-                    parent_node_id,
-                    curr_node_id,
-                    current_state,
-                    blacklisted_commands
-                  )
-
-                # Fix _id, _iter
-                planning_loop_recursive(
-                  id,
-                  new_parent_node_id,
-                  new_current_state,
-                  new_solution_graph,
-                  new_blacklisted_commands,
-                  methods,
-                  actions,
-                  iter + 1
-                )
-            end
-
-          # Action
-          :A ->
-            if MapSet.member?(blacklisted_commands, curr_node.info) do
-              Logger.warning("Action #{inspect(curr_node.info)} is blacklisted. Backtracking.")
-
-              {new_parent_node_id, _new_curr_node_id, new_solution_graph, new_current_state, new_blacklisted_commands} =
-                Backtracking.backtrack(
-                  solution_graph,
-                  parent_node_id,
-                  curr_node_id,
-                  current_state,
-                  blacklisted_commands
-                )
-
-              # Fix _id, _iter
-              planning_loop_recursive(
-                id,
-                new_parent_node_id,
-                new_current_state,
-                new_solution_graph,
-                new_blacklisted_commands,
-                methods,
-                actions,
-                iter + 1
-              )
-            else
-              # Check entity capabilities before executing action
-              # Assuming action functions will check for required capabilities within their logic
-              # For now, directly call the action
-              case apply(curr_node.action, [current_state | Tuple.to_list(curr_node.info)]) do
-                {:ok, _new_state, duration} ->
-                  Logger.info("Action #{inspect(curr_node.info)} successful with duration #{duration}ms.")
-                  # Update current_time in state
-                  new_current_time = DateTime.add(current_state.current_time, duration, :millisecond)
-                  updated_state = %{current_state | current_time: new_current_time}
-
-                  solution_graph =
-                    Map.put(solution_graph, curr_node_id, %{
-                      curr_node
-                      | status: :C,
-                        start_time: current_state.current_time,
-                        end_time: new_current_time,
-                        duration: duration
-                    })
-
-                  # Fix _id, _iter
-                  planning_loop_recursive(
-                    id,
-                    parent_node_id,
-                    updated_state,
-                    solution_graph,
-                    blacklisted_commands,
-                    methods,
-                    actions,
-                    iter + 1
-                  )
-
-                {:error, reason} ->
-                  Logger.warning("Action #{inspect(curr_node.info)} failed: #{reason}. Backtracking.")
-
-                  {new_parent_node_id, _new_curr_node_id, new_solution_graph, new_current_state,
-                   new_blacklisted_commands} =
-                    Backtracking.backtrack(
-                      solution_graph,
-                      parent_node_id,
-                      curr_node_id,
-                      current_state,
-                      blacklisted_commands
-                    )
-
-                  # Fix _id, _iter
-                  planning_loop_recursive(
-                    id,
-                    new_parent_node_id,
-                    new_current_state,
-                    new_solution_graph,
-                    new_blacklisted_commands,
-                    methods,
-                    actions,
-                    iter + 1
-                  )
-              end
-            end
-
-          # Goal
-          :G ->
-            # Support new goal format: {predicate_table, [subject_id, desired_val]}
-            # and legacy format: {subject_id, predicate_table, desired_val}
-            {is_achieved, goal_info} =
-              case curr_node.info do
-                {predicate_table, args} when is_list(args) ->
-                  [subject_id, desired_val] = args
-                  achieved = State.get_fact_by_predicate(current_state, predicate_table, subject_id) == desired_val
-                  {achieved, {predicate_table, args}}
-
-                {subject_id, predicate_table, desired_val} when is_binary(subject_id) or is_atom(subject_id) ->
-                  # Legacy format support
-                  achieved = State.get_fact(current_state, subject_id, predicate_table) == desired_val
-                  {achieved, {subject_id, predicate_table, desired_val}}
-
-                _ ->
-                  # Unknown format, treat as not achieved
-                  {false, curr_node.info}
-              end
-
-            if is_achieved do
-              Logger.info("Goal #{inspect(goal_info)} already achieved.")
-              solution_graph = Map.put(solution_graph, curr_node_id, %{curr_node | status: :C})
-              # Add empty subgoals for verification # Fix _id
-              {new_id, new_solution_graph} =
-                GraphOperations.add_nodes_and_edges(id, curr_node_id, [], solution_graph, methods, actions)
-
-              # Fix _id, _iter
-              planning_loop_recursive(
-                new_id,
-                curr_node_id,
-                current_state,
-                new_solution_graph,
-                blacklisted_commands,
-                methods,
-                actions,
-                iter + 1
-              )
-            else
-              case Enum.find_value(curr_node.available_methods, fn method ->
-                     subgoals = apply(method, [current_state | Tuple.to_list(curr_node.info)])
-                     if subgoals != nil, do: {method, subgoals}, else: nil
-                   end) do
-                {selected_method, subgoals} ->
-                  Logger.info(
-                    "Goal #{inspect(curr_node.info)} successfully refined with method #{inspect(selected_method)}"
-                  )
-
-                  solution_graph =
-                    Map.put(solution_graph, curr_node_id, %{curr_node | status: :C, selected_method: selected_method})
-
-                  # Fix _id
-                  {new_id, new_solution_graph} =
-                    GraphOperations.add_nodes_and_edges(id, curr_node_id, subgoals, solution_graph, methods, actions)
-
-                  # Fix _id, _iter
-                  planning_loop_recursive(
-                    new_id,
-                    curr_node_id,
-                    current_state,
-                    new_solution_graph,
-                    blacklisted_commands,
-                    methods,
-                    actions,
-                    iter + 1
-                  )
-
-                _ ->
-                  Logger.warning("Goal #{inspect(curr_node.info)} refinement failed. Backtracking.")
-
-                  {new_parent_node_id, _new_curr_node_id, new_solution_graph, new_current_state,
-                   new_blacklisted_commands} =
-                    Backtracking.backtrack(
-                      solution_graph,
-                      parent_node_id,
-                      curr_node_id,
-                      current_state,
-                      blacklisted_commands
-                    )
-
-                  # Fix _id, _iter
-                  planning_loop_recursive(
-                    id,
-                    new_parent_node_id,
-                    new_current_state,
-                    new_solution_graph,
-                    new_blacklisted_commands,
-                    methods,
-                    actions,
-                    iter + 1
-                  )
-              end
-            end
-
-          # MultiGoal
-          :M ->
-            if NodeUtils.goals_not_achieved(curr_node.info, current_state) == [] do
-              Logger.info("MultiGoal #{inspect(curr_node.info)} already achieved.")
-              solution_graph = Map.put(solution_graph, curr_node_id, %{curr_node | status: :C})
-              # Add empty subgoals for verification # Fix _id
-              {new_id, new_solution_graph} =
-                GraphOperations.add_nodes_and_edges(id, curr_node_id, [], solution_graph, methods, actions)
-
-              # Fix _id, _iter
-              planning_loop_recursive(
-                new_id,
-                curr_node_id,
-                current_state,
-                new_solution_graph,
-                blacklisted_commands,
-                methods,
-                actions,
-                iter + 1
-              )
-            else
-              case Enum.find_value(curr_node.available_methods, fn method ->
-                     subgoals = apply(method, [current_state, curr_node.info])
-                     if subgoals != nil, do: {method, subgoals}, else: nil
-                   end) do
-                {selected_method, subgoals} ->
-                  Logger.info(
-                    "MultiGoal #{inspect(curr_node.info)} successfully refined with method #{inspect(selected_method)}"
-                  )
-
-                  solution_graph =
-                    Map.put(solution_graph, curr_node_id, %{curr_node | status: :C, selected_method: selected_method})
-
-                  # Fix _id
-                  {new_id, new_solution_graph} =
-                    GraphOperations.add_nodes_and_edges(id, curr_node_id, subgoals, solution_graph, methods, actions)
-
-                  # Fix _id, _iter
-                  planning_loop_recursive(
-                    new_id,
-                    curr_node_id,
-                    current_state,
-                    new_solution_graph,
-                    blacklisted_commands,
-                    methods,
-                    actions,
-                    iter + 1
-                  )
-
-                _ ->
-                  Logger.warning("MultiGoal #{inspect(curr_node.info)} refinement failed. Backtracking.")
-
-                  {new_parent_node_id, _new_curr_node_id, new_solution_graph, new_current_state,
-                   new_blacklisted_commands} =
-                    Backtracking.backtrack(
-                      solution_graph,
-                      parent_node_id,
-                      curr_node_id,
-                      current_state,
-                      blacklisted_commands
-                    )
-
-                  # Fix _id, _iter
-                  planning_loop_recursive(
-                    id,
-                    new_parent_node_id,
-                    new_current_state,
-                    new_solution_graph,
-                    new_blacklisted_commands,
-                    methods,
-                    actions,
-                    iter + 1
-                  )
-              end
-            end
-
-          # Verify Goal
-          :VG ->
-            goal_node = Map.get(solution_graph, parent_node_id)
-            # Support new goal format: {predicate_table, [subject_id, desired_val]}
-            # and legacy format: {subject_id, predicate_table, desired_val}
-            is_achieved =
-              case goal_node.info do
-                {predicate_table, args} when is_list(args) ->
-                  [subject_id, desired_val] = args
-                  State.get_fact_by_predicate(current_state, predicate_table, subject_id) == desired_val
-
-                {subject_id, predicate_table, desired_val} when is_binary(subject_id) or is_atom(subject_id) ->
-                  # Legacy format support
-                  State.get_fact(current_state, subject_id, predicate_table) == desired_val
-
-                _ ->
-                  # Unknown format, treat as not achieved
-                  false
-              end
-
-            if is_achieved do
-              Logger.info("Goal #{inspect(goal_node.info)} verified successfully.")
-              solution_graph = Map.put(solution_graph, curr_node_id, %{curr_node | status: :C})
-              # Fix _id, _iter
-              planning_loop_recursive(
-                id,
-                parent_node_id,
-                current_state,
-                solution_graph,
-                blacklisted_commands,
-                methods,
-                actions,
-                iter + 1
-              )
-            else
-              Logger.warning("Goal #{inspect(goal_node.info)} verification failed. Backtracking.")
-
-              {new_parent_node_id, _new_curr_node_id, new_solution_graph, new_current_state, new_blacklisted_commands} =
-                Backtracking.backtrack(
-                  solution_graph,
-                  parent_node_id,
-                  curr_node_id,
-                  current_state,
-                  blacklisted_commands
-                )
-
-              # Fix _id, _iter
-              planning_loop_recursive(
-                id,
-                new_parent_node_id,
-                new_current_state,
-                new_solution_graph,
-                new_blacklisted_commands,
-                methods,
-                actions,
-                iter + 1
-              )
-            end
-
-          # Verify MultiGoal
-          :VM ->
-            multigoal_node = Map.get(solution_graph, parent_node_id)
-
-            if NodeUtils.goals_not_achieved(multigoal_node.info, current_state) == [] do
-              Logger.info("MultiGoal #{inspect(multigoal_node.info)} verified successfully.")
-              solution_graph = Map.put(solution_graph, curr_node_id, %{curr_node | status: :C})
-              # Fix _id, _iter
-              planning_loop_recursive(
-                id,
-                parent_node_id,
-                current_state,
-                solution_graph,
-                blacklisted_commands,
-                methods,
-                actions,
-                iter + 1
-              )
-            else
-              Logger.warning("MultiGoal #{inspect(multigoal_node.info)} verification failed. Backtracking.")
-
-              {new_parent_node_id, _new_curr_node_id, new_solution_graph, new_current_state, new_blacklisted_commands} =
-                Backtracking.backtrack(
-                  solution_graph,
-                  parent_node_id,
-                  curr_node_id,
-                  current_state,
-                  blacklisted_commands
-                )
-
-              # Fix _id, _iter
-              planning_loop_recursive(
-                id,
-                new_parent_node_id,
-                new_current_state,
-                new_solution_graph,
-                new_blacklisted_commands,
-                methods,
-                actions,
-                iter + 1
-              )
-            end
-
-          # Other node types (D)
-          _ ->
-            # For now, just fail and backtrack
-            {new_parent_node_id, _new_curr_node_id, new_solution_graph, new_current_state, new_blacklisted_commands} =
-              Backtracking.backtrack(solution_graph, parent_node_id, curr_node_id, current_state, blacklisted_commands)
-
-            # Fix _id, _iter
-            planning_loop_recursive(
-              id,
-              new_parent_node_id,
-              new_current_state,
-              new_solution_graph,
-              new_blacklisted_commands,
-              methods,
-              actions,
-              iter + 1
-            )
-        end
+        # The recursion continues from here, so the iteration is reported as
+        # a single event rather than a span around the rest of the search
+        Trace.event(:iteration, %{duration: System.monotonic_time() - started_at}, %{
+          iteration: iter,
+          node_id: curr_node_id,
+          type: curr_node.type,
+          transition: elem(transition, 0)
+        })
+
+        continue(transition, parent_node_id, nogoods, budget, ctx, iter)
 
       :no_open_node ->
-        # If no open node found, try to move up the tree (backtrack to parent's parent)
-        case Map.get(solution_graph, parent_node_id) do
-          # If parent is root, planning complete
-          %{type: :D} ->
-            # Fix _iter
-            {current_state, solution_graph, blacklisted_commands, iter}
-
-          _ ->
-            # Move to predecessor of parent_node_id
-            # This assumes a simple tree structure where each node has one predecessor
-            new_parent_node_id = GraphOperations.find_predecessor(solution_graph, parent_node_id)
-            # Fix _id, _iter
-            planning_loop_recursive(
-              id,
-              new_parent_node_id,
-              current_state,
-              solution_graph,
-              blacklisted_commands,
-              methods,
-              actions,
-              iter + 1
-            )
+        if parent_node_id == ctx.boundary do
+          # Back where the loop started (the root, or a subtree being raced): done
+          {:ok, current_state, solution_graph, blacklisted_commands, nogoods, budget, iter}
+        else
+          # Move to predecessor of parent_node_id
+          new_parent_node_id = GraphOperations.find_predecessor(solution_graph, parent_node_id)
+          planning_loop_recursive(
+            new_parent_node_id,
+            current_state,
+            solution_graph,
+            blacklisted_commands,
+            nogoods,
+            budget,
+            ctx,
+            iter + 1
+          )
         end
     end
   end
 
+  # Drops the trail below the oldest checkpoint that can still be restored.
+  # Backtracking only reopens ancestors with methods left, so only theirs can.
+  defp compact_trail(state, graph, node_id, iter) when rem(iter, @trail_compaction) == 0,
+    do: State.truncate_trail(state, live_mark(graph, node_id, state.trail_length))
+
+  defp compact_trail(state, _graph, _node_id, _iter), do: state
+
+  defp live_mark(_graph, nil, mark), do: mark
+
+  defp live_mark(graph, node_id, mark) do
+    mark =
+      case SolutionGraph.get(graph, node_id) do
+        %{type: type, available_methods: [_ | _], checkpoint: checkpoint}
+        when type in [:T, :G, :M] and checkpoint != nil ->
+          min(mark, State.trail_position(checkpoint))
+
+        _node ->
+          mark
+      end
+
+    live_mark(graph, GraphOperations.find_predecessor(graph, node_id), mark)
+  end
+
+  # Refinement of a single node returns one of these transitions:
+  #   {:descend, node_id, ...} - children were added under node_id, refine them next
+  #   {:next, ...}             - node closed, keep refining the current parent's children
+  #   {:join, ..., iterations} - a raced subtree completed in a worker, keep refining the current parent
+  #   {:backtrack, node_id, ...} - node failed
+  #   {:branch, node_id, choices, ...} - several methods apply, the search opens a partial plan for each
+  defp continue({:descend, node_id, state, graph, blacklisted}, _parent_node_id, nogoods, budget, ctx, iter),
+    do: planning_loop_recursive(node_id, state, graph, blacklisted, nogoods, budget, ctx, iter + 1)
+
+  defp continue({:next, state, graph, blacklisted}, parent_node_id, nogoods, budget, ctx, iter),
+    do: planning_loop_recursive(parent_node_id, state, graph, blacklisted, nogoods, budget, ctx, iter + 1)
+
+  defp continue({:join, state, graph, blacklisted, iterations}, parent_node_id, nogoods, budget, ctx, iter),
+    do: planning_loop_recursive(parent_node_id, state, graph, blacklisted, nogoods, budget, ctx, iter + 1 + iterations)
+
+  defp continue({:branch, node_id, choices, state, graph, blacklisted}, _parent_node_id, nogoods, budget, _ctx, iter),
+    do: {{:branch, node_id, choices}, state, graph, blacklisted, nogoods, budget, iter + 1}
+
+  defp continue({:backtrack, curr_node_id, state, graph, blacklisted}, parent_node_id, nogoods, budget, ctx, iter) do
+    opts = [backjumping: ctx.backjumping]
+    budget = Budget.backtracked(budget)
+
+    {new_parent_node_id, _new_curr_node_id, new_graph, new_state, new_blacklisted, nogoods} =
+      Trace.span(:backtrack, %{node_id: curr_node_id, parent_node_id: parent_node_id}, fn ->
+        Backtracking.backtrack(graph, parent_node_id, curr_node_id, state, blacklisted, nogoods, opts)
+      end)
+
+    # Backtracking failed the loop's boundary node (or removed it): nothing left to try
+    case SolutionGraph.get(new_graph, ctx.boundary) do
+      %{status: :F} ->
+        {:failure, new_state, new_graph, new_blacklisted, nogoods, budget, iter + 1}
+
+      nil ->
+        {:failure, new_state, new_graph, new_blacklisted, nogoods, budget, iter + 1}
+
+      _ ->
+        planning_loop_recursive(
+          new_parent_node_id,
+          new_state,
+          new_graph,
+          new_blacklisted,
+          nogoods,
+          budget,
+          ctx,
+          iter + 1
+        )
+    end
+  end
+
+  # Only task, goal and multigoal refinements are remembered when they fail
+  defp nogood_key(%{type: type, info: info}, state, %{nogoods: capacity})
+       when type in [:T, :G, :M] and capacity > 0,
+       do: NogoodTable.key(type, info, state)
+
+  defp nogood_key(_node, _state, _ctx), do: nil
+
+  # Task
+  defp refine(
+         %{type: :T} = curr_node,
+         curr_node_id,
+         _parent_node_id,
+         current_state,
+         solution_graph,
+         blacklisted,
+         ctx
+       ) do
+    args = [current_state | Tuple.to_list(curr_node.info)]
+    refine_with_methods(curr_node, curr_node_id, args, current_state, solution_graph, blacklisted, ctx)
+  end
+
+  # Action
+  defp refine(
+         %{type: :A} = curr_node,
+         curr_node_id,
+         _parent_node_id,
+         current_state,
+         solution_graph,
+         blacklisted,
+         _ctx
+       ) do
+    if MapSet.member?(blacklisted, curr_node.info) do
+      Trace.debug(:action_blacklisted, %{node_id: curr_node_id, info: curr_node.info})
+      {:backtrack, curr_node_id, current_state, solution_graph, blacklisted}
+    else
+      # Action functions check the entity capabilities they require themselves
+      result =
+        Trace.span(:action, %{node_id: curr_node_id, info: curr_node.info}, fn ->
+          apply(curr_node.action, [current_state | Tuple.to_list(curr_node.info)])
+        end)
+
+      case result do
+        {:ok, new_state, duration} ->
+          Trace.debug(:action_succeeded, %{node_id: curr_node_id, info: curr_node.info, duration: duration})
+          # Adopt the action's effects (recorded on the trail) and update current_time
+          new_current_time = DateTime.add(current_state.current_time, duration, :millisecond)
+          updated_state = %{new_state | current_time: new_current_time}
+
+          solution_graph =
+            SolutionGraph.put(solution_graph, curr_node_id, %{
+              curr_node
+              | status: :C,
+                start_time: current_state.current_time,
+                end_time: new_current_time,
+                duration: duration
+            })
+
+          {:next, updated_state, solution_graph, blacklisted}
+
+        {:error, reason} ->
+          Trace.debug(:action_failed, %{node_id: curr_node_id, info: curr_node.info, reason: reason})
+          {:backtrack, curr_node_id, current_state, solution_graph, blacklisted}
+
+        {:error, reason, conflict} ->
+          Trace.debug(:action_failed, %{node_id: curr_node_id, info: curr_node.info, reason: reason})
+          {:backtrack, curr_node_id, current_state, blame(solution_graph, curr_node_id, conflict), blacklisted}
+      end
+    end
+  end
+
+  # Goal
+  defp refine(
+         %{type: :G} = curr_node,
+         curr_node_id,
+         _parent_node_id,
+         current_state,
+         solution_graph,
+         blacklisted,
+         ctx
+       ) do
+    if goal_achieved?(curr_node.info, current_state) do
+      Trace.debug(:already_achieved, %{node_id: curr_node_id, info: curr_node.info})
+      solution_graph = SolutionGraph.put(solution_graph, curr_node_id, %{curr_node | status: :C})
+      # Add empty subgoals for verification
+      {_last_id, solution_graph} = GraphOperations.add_nodes_and_edges(curr_node_id, [], solution_graph, ctx.domain)
+      {:descend, curr_node_id, current_state, solution_graph, blacklisted}
+    else
+      args = [current_state | Tuple.to_list(curr_node.info)]
+      refine_with_methods(curr_node, curr_node_id, args, current_state, solution_graph, blacklisted, ctx)
+    end
+  end
+
+  # MultiGoal
+  defp refine(
+         %{type: :M} = curr_node,
+         curr_node_id,
+         _parent_node_id,
+         current_state,
+         solution_graph,
+         blacklisted,
+         ctx
+       ) do
+    if NodeUtils.goals_not_achieved(curr_node.info, current_state) == [] do
+      Trace.debug(:already_achieved, %{node_id: curr_node_id, info: curr_node.info})
+      solution_graph = SolutionGraph.put(solution_graph, curr_node_id, %{curr_node | status: :C})
+      # Add empty subgoals for verification
+      {_last_id, solution_graph} = GraphOperations.add_nodes_and_edges(curr_node_id, [], solution_graph, ctx.domain)
+      {:descend, curr_node_id, current_state, solution_graph, blacklisted}
+    else
+      args = [current_state, curr_node.info]
+      refine_with_methods(curr_node, curr_node_id, args, current_state, solution_graph, blacklisted, ctx)
+    end
+  end
+
+  # Verify Goal
+  defp refine(
+         %{type: :VG} = curr_node,
+         curr_node_id,
+         parent_node_id,
+         current_state,
+         solution_graph,
+         blacklisted,
+         _ctx
+       ) do
+    goal_node = SolutionGraph.get(solution_graph, parent_node_id)
+
+    if goal_achieved?(goal_node.info, current_state) do
+      Trace.debug(:verified, %{node_id: parent_node_id, info: goal_node.info})
+      {:next, current_state, SolutionGraph.put(solution_graph, curr_node_id, %{curr_node | status: :C}), blacklisted}
+    else
+      Trace.debug(:verification_failed, %{node_id: parent_node_id, info: goal_node.info})
+      conflict = NodeUtils.goal_facts([goal_node.info])
+      {:backtrack, curr_node_id, current_state, blame(solution_graph, curr_node_id, conflict), blacklisted}
+    end
+  end
+
+  # Verify MultiGoal
+  defp refine(
+         %{type: :VM} = curr_node,
+         curr_node_id,
+         parent_node_id,
+         current_state,
+         solution_graph,
+         blacklisted,
+         _ctx
+       ) do
+    multigoal_node = SolutionGraph.get(solution_graph, parent_node_id)
+
+    case NodeUtils.goals_not_achieved(multigoal_node.info, current_state) do
+      [] ->
+        Trace.debug(:verified, %{node_id: parent_node_id, info: multigoal_node.info})
+        {:next, current_state, SolutionGraph.put(solution_graph, curr_node_id, %{curr_node | status: :C}), blacklisted}
+
+      unachieved ->
+        Trace.debug(:verification_failed, %{node_id: parent_node_id, info: multigoal_node.info})
+        conflict = NodeUtils.goal_facts(unachieved)
+        {:backtrack, curr_node_id, current_state, blame(solution_graph, curr_node_id, conflict), blacklisted}
+    end
+  end
+
+  # Other node types (D): for now, just fail and backtrack
+  defp refine(_curr_node, curr_node_id, _parent_node_id, current_state, solution_graph, blacklisted, _ctx) do
+    {:backtrack, curr_node_id, current_state, solution_graph, blacklisted}
+  end
+
+  # Records the facts a failing node blames, for backjumping
+  defp blame(solution_graph, _node_id, nil), do: solution_graph
+
+  defp blame(solution_graph, node_id, conflict) do
+    node = SolutionGraph.get(solution_graph, node_id)
+    SolutionGraph.put(solution_graph, node_id, Map.put(node, :conflict, conflict))
+  end
+
+  # Support new goal format: {predicate_table, [subject_id, desired_val]}
+  # and legacy format: {subject_id, predicate_table, desired_val}
+  defp goal_achieved?({predicate_table, [subject_id, desired_val]}, current_state) do
+    State.get_fact_by_predicate(current_state, predicate_table, subject_id) == desired_val
+  end
+
+  defp goal_achieved?({subject_id, predicate_table, desired_val}, current_state)
+       when is_binary(subject_id) or is_atom(subject_id) do
+    State.get_fact(current_state, subject_id, predicate_table) == desired_val
+  end
+
+  # Unknown format, treat as not achieved
+  defp goal_achieved?(_goal_info, _current_state), do: false
+
+  defp refine_with_methods(curr_node, curr_node_id, args, current_state, solution_graph, blacklisted, ctx)
+       when ctx.strategy != :depth_first do
+    choices =
+      Trace.span(:refine, refine_metadata(curr_node, curr_node_id), fn ->
+        Enum.flat_map(curr_node.available_methods, fn method ->
+          case apply(method, args) do
+            nil -> []
+            subnodes -> [{method, subnodes}]
+          end
+        end)
+      end)
+
+    case choices do
+      [] ->
+        Trace.debug(:refinement_failed, %{node_id: curr_node_id, info: curr_node.info})
+        {:backtrack, curr_node_id, current_state, solution_graph, blacklisted}
+
+      [{method, subnodes}] ->
+        Trace.debug(:refined, %{node_id: curr_node_id, info: curr_node.info, method: method})
+        solution_graph = expand(solution_graph, curr_node_id, curr_node, method, subnodes, [], ctx.domain)
+        {:descend, curr_node_id, current_state, solution_graph, blacklisted}
+
+      _ ->
+        Trace.debug(:branched, %{node_id: curr_node_id, info: curr_node.info, choices: length(choices)})
+        {:branch, curr_node_id, choices, current_state, solution_graph, blacklisted}
+    end
+  end
+
+  defp refine_with_methods(%{available_methods: [_, _ | _]} = curr_node, curr_node_id, args, state, graph, bl, ctx)
+       when ctx.portfolio > 1 do
+    refine_in_portfolio(curr_node, curr_node_id, args, state, graph, bl, ctx)
+  end
+
+  defp refine_with_methods(curr_node, curr_node_id, args, current_state, solution_graph, blacklisted, ctx) do
+    result =
+      Trace.span(:refine, refine_metadata(curr_node, curr_node_id), fn ->
+        try_methods(curr_node.available_methods, args)
+      end)
+
+    case result do
+      {selected_method, subnodes, remaining_methods} ->
+        Trace.debug(:refined, %{node_id: curr_node_id, info: curr_node.info, method: selected_method})
+
+        solution_graph =
+          expand(solution_graph, curr_node_id, curr_node, selected_method, subnodes, remaining_methods, ctx.domain)
+
+        {:descend, curr_node_id, current_state, solution_graph, blacklisted}
+
+      nil ->
+        Trace.debug(:refinement_failed, %{node_id: curr_node_id, info: curr_node.info})
+        {:backtrack, curr_node_id, current_state, solution_graph, blacklisted}
+    end
+  end
+
+  # Races the node's method alternatives. Each worker refines the node with
+  # one method and then runs the loop bounded at the node until its subtree
+  # is complete or fails; the winning worker's graph and state replace ours.
+  # Workers and the race stop at the caller's time limit.
+  defp refine_in_portfolio(curr_node, curr_node_id, args, current_state, solution_graph, blacklisted, ctx) do
+    worker_ctx = %{ctx | boundary: curr_node_id, portfolio: 1}
+
+    explore = fn method ->
+      case apply(method, args) do
+        nil ->
+          :failure
+
+        subnodes ->
+          graph = expand(solution_graph, curr_node_id, curr_node, method, subnodes, [], ctx.domain)
+          nogoods = NogoodTable.new(ctx.nogoods)
+          # Workers only share the caller's time limit; the race counts as one iteration
+          budget = Budget.deadline(ctx.budget)
+          state = current_state
+
+          case planning_loop_recursive(curr_node_id, state, graph, blacklisted, nogoods, budget, worker_ctx, 0) do
+            {:ok, state, graph, worker_blacklisted, _nogoods, _budget, iterations} ->
+              {:ok, {state, graph, worker_blacklisted, iterations}}
+
+            {:failure, _state, _graph, _worker_blacklisted, _nogoods, _budget, _iterations} ->
+              :failure
+
+            {{:stopped, :time, _node_id}, _state, _graph, _worker_blacklisted, _nogoods, _budget, _iterations} ->
+              :timeout
+          end
+      end
+    end
+
+    result =
+      Trace.span(:refine, refine_metadata(curr_node, curr_node_id), fn ->
+        Portfolio.race(curr_node.available_methods, ctx.portfolio, explore, Budget.time_left(ctx.budget))
+      end)
+
+    case result do
+      {:ok, selected_method, {state, graph, worker_blacklisted, iterations}, untried_methods} ->
+        Trace.debug(:refined, %{node_id: curr_node_id, info: curr_node.info, method: selected_method})
+
+        # Alternatives cancelled mid-race stay available for a later backtrack
+        node = SolutionGraph.get(graph, curr_node_id)
+        graph = SolutionGraph.put(graph, curr_node_id, %{node | available_methods: untried_methods})
+        {:join, state, graph, worker_blacklisted, iterations}
+
+      :failure ->
+        Trace.debug(:refinement_failed, %{node_id: curr_node_id, info: curr_node.info})
+        {:backtrack, curr_node_id, current_state, solution_graph, blacklisted}
+
+      :timeout ->
+        # The node stays open; the time limit has passed, so the loop stops before it
+        Trace.debug(:race_timed_out, %{node_id: curr_node_id, info: curr_node.info})
+        {:next, current_state, solution_graph, blacklisted}
+    end
+  end
+
+  # Closes the node with `method`, keeping `remaining_methods` for a retry, and adds its subnodes under it
+  defp expand(solution_graph, node_id, node, method, subnodes, remaining_methods, domain) do
+    solution_graph =
+      SolutionGraph.put(solution_graph, node_id, %{
+        node
+        | status: :C,
+          selected_method: method,
+          available_methods: remaining_methods
+      })
+
+    {_last_id, solution_graph} = GraphOperations.add_nodes_and_edges(node_id, subnodes, solution_graph, domain)
+    solution_graph
+  end
+
+  defp refine_metadata(curr_node, curr_node_id),
+    do: %{node_id: curr_node_id, type: curr_node.type, info: curr_node.info}
+
+  # Tries the node's remaining methods in order. Returns the first method that
+  # refines the node, its subnodes, and the methods left for a later retry.
+  defp try_methods([], _args), do: nil
+
+  defp try_methods([method | remaining_methods], args) do
+    case apply(method, args) do
+      nil -> try_methods(remaining_methods, args)
+      subnodes -> {method, subnodes, remaining_methods}
+    end
+  end
+
   # Helper function for blacklisting commands
   def blacklist_command(blacklisted_commands, command) do
     MapSet.put(blacklisted_commands, command)
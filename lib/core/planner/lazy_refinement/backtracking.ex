@@ -4,83 +4,159 @@
 defmodule AriaCore.Planner.LazyRefinement.Backtracking do
   @moduledoc """
   Helper functions for backtracking in lazy plan refinement.
+
+  Task, goal and multigoal nodes that fail for good, with no methods left,
+  are recorded in the run's `NogoodTable`.
+
+  ## Backjumping
+
+  By default the nearest ancestor with methods left is retried. With the
+  `:backjumping` option, a failed node that carries a `:conflict` (the
+  facts blamed for its failure, as `AriaCore.Planner.State.fact_ref()`s)
+  makes the walk retry the deepest ancestor whose current subtree wrote
+  one of those facts instead, as found on the state's trail. Ancestors in
+  between did not write them, so they are failed along the way. Once the
+  walk has jumped over one with methods left, the ancestors above it have
+  not been proven to fail and are not recorded as nogoods. The ancestor
+  it retries is marked `jumped`, so neither it nor its ancestors are
+  recorded when it runs out of methods in a later backtrack. When no
+  ancestor with methods left wrote the facts, or the failure carries no
+  conflict, the nearest one is retried as usual.
+
+  Backjumping assumes a method only fixes the facts its own subtree has
+  already written. A skipped alternative that would have written them
+  itself is not tried, so the mode can miss plans that chronological
+  backtracking finds.
   """
 
-  require Logger
+  require AriaCore.Planner.Trace
 
+  alias AriaCore.Planner.State
   alias AriaCore.Planner.LazyRefinement.GraphOperations
+  alias AriaCore.Planner.LazyRefinement.NogoodTable
+  alias AriaCore.Planner.LazyRefinement.SolutionGraph
+  alias AriaCore.Planner.Trace
 
   # Helper function for backtracking
-  def backtrack(solution_graph, parent_node_id, curr_node_id, current_state, blacklisted_commands) do
-    Logger.info("Backtracking from node #{curr_node_id}")
-    curr_node = Map.get(solution_graph, curr_node_id)
+  def backtrack(
+        solution_graph,
+        parent_node_id,
+        curr_node_id,
+        current_state,
+        blacklisted_commands,
+        nogoods,
+        opts \\ []
+      ) do
+    curr_node = SolutionGraph.get(solution_graph, curr_node_id)
     # Mark current node as failed
-    solution_graph = Map.put(solution_graph, curr_node_id, %{curr_node | status: :F})
+    solution_graph = SolutionGraph.put(solution_graph, curr_node_id, %{curr_node | status: :F})
+    nogoods = remember(nogoods, curr_node)
 
     # Remove descendants of the failed node
     solution_graph = GraphOperations.remove_descendants(solution_graph, curr_node_id)
 
+    # Ancestor to retry instead of the nearest one, if any
+    target =
+      if Keyword.get(opts, :backjumping, false),
+        do: jump_target(solution_graph, parent_node_id, curr_node, current_state)
+
+    if target, do: Trace.debug(:backjump, %{node_id: curr_node_id, target: target})
+
     # Find the nearest ancestor that can be refined (has available methods or actions)
     # This is a simplified version of IPyHOP's _backtrack
     new_parent_node_id = parent_node_id
     # Fix unused new_curr_node_id
     new_curr_node_id = curr_node_id
 
-    # Traverse up the tree to find a node that can be retried
+    # Traverse up the tree to find a node that can be retried; the walk
+    # always ends at a retryable node or past the root
     # Fix unused _c_id
-    Enum.reduce_while(
-      0..parent_node_id,
-      {new_parent_node_id, new_curr_node_id, solution_graph, current_state, blacklisted_commands},
-      fn _i, {p_id, _c_id, sg, cs, bc} ->
-        node = Map.get(sg, p_id)
-
-        case node.type do
-          # Task
-          :T ->
-            if Enum.empty?(node.available_methods) do
-              # No more methods, this task also fails, continue backtracking
-              {:cont,
-               {GraphOperations.find_predecessor(sg, p_id), p_id, Map.put(sg, p_id, %{node | status: :F}), cs, bc}}
-            else
-              # Found a task with available methods, retry it
-              {:halt,
-               {GraphOperations.find_predecessor(sg, p_id), p_id, Map.put(sg, p_id, %{node | status: :O}), cs, bc}}
-            end
+    # The last field tells whether the walk has jumped over a node with methods left,
+    # now or in the backtrack that retried the failed node
+    jumped = Map.get(curr_node, :jumped, false)
 
-          # Goal
-          :G ->
-            if Enum.empty?(node.available_methods) do
-              # No more methods, this goal also fails, continue backtracking
-              {:cont,
-               {GraphOperations.find_predecessor(sg, p_id), p_id, Map.put(sg, p_id, %{node | status: :F}), cs, bc}}
-            else
-              # Found a goal with available methods, retry it
-              {:halt,
-               {GraphOperations.find_predecessor(sg, p_id), p_id, Map.put(sg, p_id, %{node | status: :O}), cs, bc}}
-            end
+    {p_id, c_id, sg, cs, bc, ng, _jumped} =
+      Enum.reduce_while(
+        Stream.repeatedly(fn -> :step end),
+        {new_parent_node_id, new_curr_node_id, solution_graph, current_state, blacklisted_commands, nogoods, jumped},
+        fn
+          # Walked past the root: nothing left to retry
+          _i, {nil, c_id, sg, cs, bc, ng, jumped} ->
+            {:halt, {0, c_id, sg, cs, bc, ng, jumped}}
+
+          _i, {p_id, _c_id, sg, cs, bc, ng, jumped} ->
+            node = SolutionGraph.get(sg, p_id)
+            up = GraphOperations.find_predecessor(sg, p_id)
+
+            case node.type do
+              # Task, Goal, MultiGoal
+              type when type in [:T, :G, :M] ->
+                cond do
+                  Enum.empty?(node.available_methods) ->
+                    # No more methods, this node also fails, continue backtracking. Above a
+                    # jumped-over node that is only assumed, so it is not remembered
+                    jumped = jumped or Map.get(node, :jumped, false)
+                    ng = if jumped, do: ng, else: remember(ng, node)
+                    {:cont, {up, p_id, mark(sg, p_id, node, :F), cs, bc, ng, jumped}}
+
+                  target != nil and p_id != target ->
+                    # Jumped over; its failure is not proven, so it is not remembered
+                    {:cont, {up, p_id, mark(sg, p_id, node, :F), cs, bc, ng, true}}
 
-          # MultiGoal
-          :M ->
-            if Enum.empty?(node.available_methods) do
-              # No more methods, this multigoal also fails, continue backtracking
-              {:cont,
-               {GraphOperations.find_predecessor(sg, p_id), p_id, Map.put(sg, p_id, %{node | status: :F}), cs, bc}}
-            else
-              # Found a multigoal with available methods, retry it
-              {:halt,
-               {GraphOperations.find_predecessor(sg, p_id), p_id, Map.put(sg, p_id, %{node | status: :O}), cs, bc}}
+                  true ->
+                    # Found a node with available methods, retry it from scratch with the next one.
+                    # Once jumped to, it keeps the mark for the backtracks to come
+                    node = if jumped, do: Map.put(node, :jumped, true), else: node
+                    sg = sg |> mark(p_id, node, :O) |> GraphOperations.remove_descendants(p_id)
+                    {:halt, {up, p_id, sg, cs, bc, ng, jumped}}
+                end
+
+              # Actions don't have alternative methods, so they always fail and cause backtracking.
+              # Other node types (D, VG, VM) behave the same way.
+              _ ->
+                {:cont, {up, p_id, mark(sg, p_id, node, :F), cs, bc, ng, jumped}}
             end
+        end
+      )
 
-          # Action
-          :A ->
-            # Actions don't have alternative methods, so they always fail and cause backtracking
-            {:cont, {GraphOperations.find_predecessor(sg, p_id), p_id, Map.put(sg, p_id, %{node | status: :F}), cs, bc}}
+    {p_id, c_id, sg, cs, bc, ng}
+  end
 
-          # Other node types (D, VG, VM)
-          _ ->
-            {:cont, {GraphOperations.find_predecessor(sg, p_id), p_id, Map.put(sg, p_id, %{node | status: :F}), cs, bc}}
+  # Deepest ancestor with methods left whose subtree wrote a fact in the failed node's conflict
+  defp jump_target(solution_graph, parent_node_id, failed_node, state) do
+    case Map.get(failed_node, :conflict) do
+      [_ | _] = facts ->
+        case State.last_write(state, facts) do
+          0 -> nil
+          position -> writer(solution_graph, parent_node_id, position)
         end
-      end
-    )
+
+      _ ->
+        nil
+    end
+  end
+
+  defp writer(_solution_graph, nil, _position), do: nil
+
+  defp writer(solution_graph, node_id, position) do
+    case SolutionGraph.get(solution_graph, node_id) do
+      # Its checkpoint precedes the write, so the write happened in its subtree
+      %{type: type, available_methods: [_ | _], checkpoint: checkpoint}
+      when type in [:T, :G, :M] and checkpoint != nil ->
+        if State.trail_position(checkpoint) < position,
+          do: node_id,
+          else: writer(solution_graph, GraphOperations.find_predecessor(solution_graph, node_id), position)
+
+      _node ->
+        writer(solution_graph, GraphOperations.find_predecessor(solution_graph, node_id), position)
+    end
+  end
+
+  defp remember(nogoods, %{jumped: true}), do: nogoods
+  defp remember(nogoods, %{nogood_key: key}) when key != nil, do: NogoodTable.put(nogoods, key)
+  defp remember(nogoods, _node), do: nogoods
+
+  defp mark(solution_graph, node_id, node, status) do
+    SolutionGraph.put(solution_graph, node_id, %{node | status: status})
   end
 end
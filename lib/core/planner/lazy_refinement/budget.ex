@@ -0,0 +1,90 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2025-present K. S. Ernest (iFire) Lee
+
+defmodule AriaCore.Planner.LazyRefinement.Budget do
+  @moduledoc """
+  Limits on one call into lazy plan refinement.
+
+  The planning loop checks `exhausted/2` before every iteration and stops
+  at the first limit reached:
+
+    * `:time_limit` - wall-clock milliseconds
+    * `:max_iterations` - loop iterations
+    * `:max_backtracks` - backtracks
+    * `:max_memory` - bytes used by the planning process, as reported by
+      `Process.info/2`
+
+  Unset limits are not checked. Limits count from the call that set them,
+  so a resumed run gets a fresh budget. `deadline/1` hands the time limit
+  on to work done for the call in other processes.
+  """
+
+  defstruct [:deadline, :iteration_limit, :max_backtracks, :max_memory, backtracks: 0]
+
+  @type reason :: :time | :iterations | :backtracks | :memory
+
+  @type t :: %__MODULE__{
+          # System.monotonic_time(:millisecond) to stop at
+          deadline: integer() | nil,
+          # Iteration count to stop at
+          iteration_limit: non_neg_integer() | nil,
+          max_backtracks: non_neg_integer() | nil,
+          max_memory: non_neg_integer() | nil,
+          backtracks: non_neg_integer()
+        }
+
+  @doc """
+  Creates the budget given by `opts` for a call starting at iteration `iterations`.
+  """
+  @spec new(keyword(), non_neg_integer()) :: t()
+  def new(opts, iterations) do
+    %__MODULE__{
+      deadline: offset(System.monotonic_time(:millisecond), Keyword.get(opts, :time_limit)),
+      iteration_limit: offset(iterations, Keyword.get(opts, :max_iterations)),
+      max_backtracks: Keyword.get(opts, :max_backtracks),
+      max_memory: Keyword.get(opts, :max_memory)
+    }
+  end
+
+  @doc """
+  Returns a budget with only the time limit of `budget`, which other
+  processes can check against the same deadline.
+  """
+  @spec deadline(t()) :: t()
+  def deadline(%__MODULE__{deadline: deadline}), do: %__MODULE__{deadline: deadline}
+
+  @doc """
+  Returns the milliseconds left before the time limit, or `:infinity`.
+  """
+  @spec time_left(t()) :: timeout()
+  def time_left(%__MODULE__{deadline: nil}), do: :infinity
+  def time_left(%__MODULE__{deadline: deadline}), do: max(deadline - System.monotonic_time(:millisecond), 0)
+
+  @doc """
+  Counts a backtrack.
+  """
+  @spec backtracked(t()) :: t()
+  def backtracked(%__MODULE__{} = budget), do: %{budget | backtracks: budget.backtracks + 1}
+
+  @doc """
+  Returns the limit reached at iteration `iterations`, or `nil`.
+  """
+  @spec exhausted(t(), non_neg_integer()) :: reason() | nil
+  def exhausted(%__MODULE__{} = budget, iterations) do
+    cond do
+      budget.iteration_limit != nil and iterations >= budget.iteration_limit -> :iterations
+      budget.max_backtracks != nil and budget.backtracks >= budget.max_backtracks -> :backtracks
+      budget.deadline != nil and System.monotonic_time(:millisecond) >= budget.deadline -> :time
+      budget.max_memory != nil and memory() >= budget.max_memory -> :memory
+      true -> nil
+    end
+  end
+
+  defp offset(_start, nil), do: nil
+  defp offset(start, amount) when is_integer(amount) and amount >= 0, do: start + amount
+
+  defp memory do
+    {:memory, bytes} = Process.info(self(), :memory)
+    bytes
+  end
+end
@@ -6,31 +6,35 @@ defmodule AriaCore.Planner.LazyRefinement.GraphOperations do
   Helper functions for manipulating the solution graph in lazy plan refinement.
   """
 
-  require Logger
-
   # alias AriaCore.Planner.State  # Unused - removed to fix compilation warning
-  alias AriaCore.Planner.MultiGoal
+  alias AriaCore.Planner.CompiledDomain
   alias AriaCore.Planner.LazyRefinement.NodeUtils
-
-  # Helper function to add nodes and edges to the solution graph
-  def add_nodes_and_edges(id, parent_node_id, children_node_info_list, solution_graph, methods, actions) do
-    {new_id, current_graph} =
-      Enum.reduce(children_node_info_list, {id, solution_graph}, fn child_node_info, {current_id, current_graph} ->
-        new_id = current_id + 1
-        node_type = get_node_type(child_node_info, methods, actions)
-
+  alias AriaCore.Planner.LazyRefinement.SolutionGraph
+
+  # Helper function to add nodes and edges to the solution graph.
+  # Children are classified and bound to their handlers through the
+  # domain's compiled dispatch tables. Returns the last node id handed out.
+  def add_nodes_and_edges(parent_node_id, children_node_info_list, solution_graph, %CompiledDomain{} = domain) do
+    child_nodes =
+      Enum.map(children_node_info_list, fn child_node_info ->
         node_attrs = %{
           info: child_node_info,
-          type: node_type,
+          type: :unknown,
+          # Interned name of the task, action, goal or multigoal
+          symbol: nil,
           # Open
           status: :O,
           tag: :new,
           successors: [],
-          # Initialize state
-          state: nil,
+          # Trail checkpoint taken on first visit
+          checkpoint: nil,
+          # NogoodTable key of the node's refinement, taken with the checkpoint
+          nogood_key: nil,
+          # Retried by a backjump, so its failure is never proven; see Backtracking
+          jumped: false,
           # Initialize selected_method
           selected_method: nil,
-          # Initialize available_methods
+          # Methods not yet tried
           available_methods: nil,
           # Initialize action
           action: nil,
@@ -42,166 +46,107 @@ defmodule AriaCore.Planner.LazyRefinement.GraphOperations do
           duration: nil
         }
 
-        node_attrs =
-          case node_type do
-            :T ->
-              %{
-                node_attrs
-                | state: nil,
-                  selected_method: nil,
-                  available_methods: methods.task_method_dict[elem(child_node_info, 0)]
-              }
-
-            :A ->
-              %{node_attrs | action: actions.action_dict[elem(child_node_info, 0)]}
-
-            :G ->
-              %{
-                node_attrs
-                | state: nil,
-                  selected_method: nil,
-                  available_methods: methods.goal_method_dict[elem(child_node_info, 0)]
-              }
-
-            :M ->
-              %{
-                node_attrs
-                | state: nil,
-                  selected_method: nil,
-                  available_methods: methods.multigoal_method_dict[child_node_info.goal_tag]
-              }
-
-            _ ->
-              node_attrs
-          end
-
-        updated_graph = Map.put(current_graph, new_id, node_attrs)
+        case CompiledDomain.classify(domain, child_node_info) do
+          {:A, symbol} ->
+            %{node_attrs | type: :A, symbol: symbol, action: CompiledDomain.handler(domain, symbol)}
 
-        # Add edge from parent to new node
-        parent_node = Map.get(updated_graph, parent_node_id)
-
-        updated_graph =
-          Map.put(updated_graph, parent_node_id, %{parent_node | successors: parent_node.successors ++ [new_id]})
+          {node_type, symbol} ->
+            %{
+              node_attrs
+              | type: node_type,
+                symbol: symbol,
+                available_methods: CompiledDomain.handler(domain, symbol)
+            }
 
-        {new_id, updated_graph}
+          :unknown ->
+            node_attrs
+        end
       end)
 
     # Add verification nodes for Goals and MultiGoals
-    parent_node = Map.get(current_graph, parent_node_id)
-
-    {final_id, final_graph} =
-      case parent_node.type do
-        :G ->
-          new_id = new_id + 1
-
-          updated_graph =
-            Map.put(current_graph, new_id, %{info: :VerifyGoal, type: :VG, status: :O, tag: :new, successors: []})
-
-          updated_graph =
-            Map.put(updated_graph, parent_node_id, %{parent_node | successors: parent_node.successors ++ [new_id]})
-
-          {new_id, updated_graph}
-
-        :M ->
-          new_id = new_id + 1
-
-          updated_graph =
-            Map.put(current_graph, new_id, %{info: :VerifyMultiGoal, type: :VM, status: :O, tag: :new, successors: []})
-
-          updated_graph =
-            Map.put(updated_graph, parent_node_id, %{parent_node | successors: parent_node.successors ++ [new_id]})
-
-          {new_id, updated_graph}
-
-        _ ->
-          {new_id, current_graph}
+    child_nodes =
+      case SolutionGraph.get(solution_graph, parent_node_id).type do
+        :G -> child_nodes ++ [%{info: :VerifyGoal, type: :VG, status: :O, tag: :new, successors: []}]
+        :M -> child_nodes ++ [%{info: :VerifyMultiGoal, type: :VM, status: :O, tag: :new, successors: []}]
+        _ -> child_nodes
       end
 
-    {final_id, final_graph}
-  end
-
-  defp get_node_type(node_info, methods, actions) do
-    cond do
-      is_struct(node_info, MultiGoal) -> :M
-      is_tuple(node_info) and elem(node_info, 0) in methods.task_method_dict -> :T
-      is_tuple(node_info) and elem(node_info, 0) in actions.action_dict -> :A
-      is_tuple(node_info) and elem(node_info, 0) in methods.goal_method_dict -> :G
-      # Should not happen if all types are covered
-      true -> :unknown
-    end
+    SolutionGraph.add_children(solution_graph, parent_node_id, child_nodes)
   end
 
   def extract_solution_plan(solution_graph) do
     # Perform a DFS traversal starting from the root (node 0)
     # and collect actions in preorder.
-    do_extract_solution_plan(solution_graph, 0, [])
+    solution_graph
+    |> do_extract_solution_plan(0, [])
+    |> Enum.reverse()
   end
 
   defp do_extract_solution_plan(solution_graph, node_id, acc) do
-    node = Map.get(solution_graph, node_id)
-    if node == nil, do: acc
+    case SolutionGraph.get(solution_graph, node_id) do
+      nil ->
+        acc
 
-    # Add action to accumulator if it's an action node
-    new_acc = if node.type == :A, do: acc ++ [node.info], else: acc
+      node ->
+        # Add action to accumulator if it's an action node
+        new_acc = if node.type == :A, do: [node.info | acc], else: acc
 
-    # Recursively visit successors
-    Enum.reduce(node.successors || [], new_acc, fn successor_id, current_acc ->
-      do_extract_solution_plan(solution_graph, successor_id, current_acc)
-    end)
+        # Recursively visit successors
+        Enum.reduce(node.successors || [], new_acc, fn successor_id, current_acc ->
+          do_extract_solution_plan(solution_graph, successor_id, current_acc)
+        end)
+    end
   end
 
-  def find_open_node(solution_graph, parent_node_id) do
-    Logger.info("find_open_node: parent_node_id=#{parent_node_id}")
+  # Infos of the open task, action, goal and multigoal nodes, in plan order
+  def open_nodes(solution_graph) do
+    solution_graph
+    |> do_open_nodes(0, [])
+    |> Enum.reverse()
+  end
 
-    case Map.get(solution_graph, parent_node_id) do
-      %{successors: successors} when is_list(successors) ->
-        Logger.info("find_open_node: successors=#{inspect(successors)}")
+  defp do_open_nodes(solution_graph, node_id, acc) do
+    case SolutionGraph.get(solution_graph, node_id) do
+      nil ->
+        acc
+
+      node ->
+        acc = if node.status == :O and node.type in [:T, :A, :G, :M], do: [node.info | acc], else: acc
+        Enum.reduce(node.successors || [], acc, &do_open_nodes(solution_graph, &1, &2))
+    end
+  end
 
-        Enum.find_value(successors, fn node_id ->
-          node = Map.get(solution_graph, node_id)
-          Logger.info("find_open_node: checking node #{node_id}, status=#{node.status}")
-          if node.status == :O, do: {:ok, node_id}
+  def find_open_node(solution_graph, parent_node_id) do
+    case SolutionGraph.get(solution_graph, parent_node_id) do
+      %{successors: successors} when is_list(successors) ->
+        Enum.find_value(successors, :no_open_node, fn node_id ->
+          if SolutionGraph.get(solution_graph, node_id).status == :O, do: {:ok, node_id}
         end)
 
       _ ->
-        Logger.info("find_open_node: no successors or parent_node_id not found")
         :no_open_node
     end
   end
 
   def find_predecessor(solution_graph, node_id) do
-    Enum.find_value(solution_graph, fn {id, node} ->
-      if Enum.member?(node.successors || [], node_id), do: id
-    end)
+    SolutionGraph.parent(solution_graph, node_id)
   end
 
   def remove_descendants(solution_graph, node_id) do
     descendants_to_remove = get_descendants(solution_graph, node_id)
-    Enum.reduce(descendants_to_remove, solution_graph, fn id, sg -> Map.delete(sg, id) end)
-  end
+    solution_graph = Enum.reduce(descendants_to_remove, solution_graph, &SolutionGraph.delete(&2, &1))
 
-  defp get_descendants(solution_graph, node_id) do
-    do_get_descendants(solution_graph, [node_id], MapSet.new())
-    # Don't remove the node itself, only its descendants
-    |> MapSet.delete(node_id)
-    |> MapSet.to_list()
+    # Drop the dangling edges so the node can be refined again from scratch
+    case SolutionGraph.get(solution_graph, node_id) do
+      %{successors: [_ | _]} = node -> SolutionGraph.put(solution_graph, node_id, %{node | successors: []})
+      _ -> solution_graph
+    end
   end
 
-  defp do_get_descendants(solution_graph, current_nodes, visited) do
-    Enum.reduce(current_nodes, visited, fn node_id, acc ->
-      if MapSet.member?(acc, node_id) do
-        acc
-      else
-        node = Map.get(solution_graph, node_id)
-        new_visited = MapSet.put(acc, node_id)
-
-        if node != nil and Map.has_key?(node, :successors) do
-          do_get_descendants(solution_graph, node.successors, new_visited)
-        else
-          new_visited
-        end
-      end
-    end)
+  defp get_descendants(solution_graph, node_id) do
+    solution_graph
+    |> SolutionGraph.successors(node_id)
+    |> Enum.flat_map(fn child_id -> [child_id | get_descendants(solution_graph, child_id)] end)
   end
 
   def goals_not_achieved(multigoal_info, current_state) do
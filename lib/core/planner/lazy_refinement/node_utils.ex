@@ -7,18 +7,6 @@ defmodule AriaCore.Planner.LazyRefinement.NodeUtils do
   """
 
   alias AriaCore.Planner.State
-  alias AriaCore.Planner.MultiGoal
-
-  def get_node_type(node_info, methods, actions) do
-    cond do
-      is_struct(node_info, MultiGoal) -> :M
-      is_tuple(node_info) and elem(node_info, 0) in methods.task_method_dict -> :T
-      is_tuple(node_info) and elem(node_info, 0) in actions.action_dict -> :A
-      is_tuple(node_info) and elem(node_info, 0) in methods.goal_method_dict -> :G
-      # Should not happen if all types are covered
-      true -> :unknown
-    end
-  end
 
   def goals_not_achieved(multigoal_info, current_state) do
     Enum.reduce(multigoal_info.goals, [], fn goal, acc ->
@@ -47,4 +35,19 @@ defmodule AriaCore.Planner.LazyRefinement.NodeUtils do
       end
     end)
   end
+
+  @doc """
+  Returns the facts the given goals are about, as `State.fact_ref()`s, or
+  `nil` when a goal is in an unknown format.
+  """
+  @spec goal_facts(list()) :: [State.fact_ref()] | nil
+  def goal_facts(goals) do
+    Enum.reduce_while(goals, [], fn
+      # New format: facts[predicate_table][subject_id]
+      {predicate_table, [subject_id, _desired_val]}, acc -> {:cont, [{predicate_table, subject_id} | acc]}
+      # Legacy format: facts[subject_id][predicate_table]
+      {subject_id, predicate_table, _desired_val}, acc -> {:cont, [{subject_id, predicate_table} | acc]}
+      _goal, _acc -> {:halt, nil}
+    end)
+  end
 end
@@ -0,0 +1,122 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2025-present K. S. Ernest (iFire) Lee
+
+defmodule AriaCore.Planner.LazyRefinement.NogoodTable do
+  @moduledoc """
+  Bounded table of task, goal and multigoal refinements known to fail.
+
+  A refinement's outcome only depends on the node's info, the state it is
+  refined in and the blacklisted commands, which only ever grow during a
+  run. Once a node has failed with all of its methods, another node with
+  the same info reached in the same state fails too, so the planner can
+  backtrack from it at once instead of exploring the same subtree again.
+
+  Entries are keyed by `key/3`, the node's type, name and a hash of its
+  arguments plus the state's fingerprint. Hashing the arguments costs in
+  proportion to their size, so the table only pays off when they are
+  small. The table holds at most `capacity` entries and evicts with the
+  clock algorithm: each entry has a reference bit set when it is hit, and
+  the hand gives referenced entries a second chance before evicting the
+  first unreferenced one. A capacity of `0` disables the table.
+  """
+
+  import Bitwise
+
+  alias AriaCore.Planner.State
+
+  @half_range 1 <<< 32
+
+  @enforce_keys [:capacity]
+  defstruct capacity: 0, entries: %{}, clock: :queue.new(), hits: 0, misses: 0
+
+  # Node type, task or goal name, arguments hash and state fingerprint
+  @type key :: {atom(), term(), non_neg_integer(), non_neg_integer()}
+
+  @type t :: %__MODULE__{
+          capacity: non_neg_integer(),
+          # key => reference bit
+          entries: %{key() => boolean()},
+          # Keys in clock order, the hand at the front
+          clock: :queue.queue(key()),
+          hits: non_neg_integer(),
+          misses: non_neg_integer()
+        }
+
+  @doc """
+  Creates an empty table holding at most `capacity` entries.
+  """
+  @spec new(non_neg_integer()) :: t()
+  def new(capacity) when is_integer(capacity) and capacity >= 0, do: %__MODULE__{capacity: capacity}
+
+  @doc """
+  Key of refining a node of `type` with `info` in `state`.
+
+  The key covers everything an action or method may read, through the
+  state's incrementally maintained `State.fingerprint/1`. The trail is left
+  out, as it records how the state was reached rather than what it is.
+
+  The arguments are hashed once here rather than on every lookup, as they
+  may be large: a domain's root task can carry a whole state snapshot.
+  """
+  @spec key(atom(), term(), State.t()) :: key()
+  def key(type, info, %State{} = state) do
+    {name, args} = split(info)
+    {type, name, args_hash(args), State.fingerprint(state)}
+  end
+
+  # A task or goal is a tuple led by its name; anything else is hashed whole
+  defp split(info) when is_tuple(info) and tuple_size(info) > 0, do: {elem(info, 0), Tuple.delete_at(info, 0)}
+  defp split(info), do: {nil, info}
+
+  # 64 bits from two salted :erlang.phash2/2 halves, as in State
+  defp args_hash(args), do: :erlang.phash2({:args, args}, @half_range) <<< 32 ||| :erlang.phash2(args, @half_range)
+
+  @doc """
+  Checks whether `key` is known to fail, counting a hit or a miss.
+  """
+  @spec failed?(t(), key()) :: {boolean(), t()}
+  def failed?(%__MODULE__{capacity: 0} = table, _key), do: {false, table}
+
+  def failed?(%__MODULE__{} = table, key) do
+    if Map.has_key?(table.entries, key) do
+      {true, %{table | entries: Map.put(table.entries, key, true), hits: table.hits + 1}}
+    else
+      {false, %{table | misses: table.misses + 1}}
+    end
+  end
+
+  @doc """
+  Records that refining under `key` fails, evicting an entry when full.
+  """
+  @spec put(t(), key()) :: t()
+  def put(%__MODULE__{capacity: 0} = table, _key), do: table
+
+  def put(%__MODULE__{} = table, key) do
+    cond do
+      Map.has_key?(table.entries, key) ->
+        table
+
+      map_size(table.entries) < table.capacity ->
+        %{table | entries: Map.put(table.entries, key, false), clock: :queue.in(key, table.clock)}
+
+      true ->
+        table |> evict() |> put(key)
+    end
+  end
+
+  @doc """
+  Number of entries, hits and misses.
+  """
+  @spec stats(t()) :: %{size: non_neg_integer(), hits: non_neg_integer(), misses: non_neg_integer()}
+  def stats(%__MODULE__{} = table), do: %{size: map_size(table.entries), hits: table.hits, misses: table.misses}
+
+  # Advances the hand past referenced entries, clearing their bit, and drops the first unreferenced one
+  defp evict(table) do
+    {{:value, key}, clock} = :queue.out(table.clock)
+
+    case Map.fetch!(table.entries, key) do
+      true -> evict(%{table | entries: Map.put(table.entries, key, false), clock: :queue.in(key, clock)})
+      false -> %{table | entries: Map.delete(table.entries, key), clock: clock}
+    end
+  end
+end
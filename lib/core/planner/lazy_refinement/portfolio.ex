@@ -0,0 +1,99 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2025-present K. S. Ernest (iFire) Lee
+
+defmodule AriaCore.Planner.LazyRefinement.Portfolio do
+  @moduledoc """
+  Concurrent exploration of method alternatives in lazy plan refinement.
+
+  `race/3` explores the first `width` candidates, each in its own process.
+  The first one to succeed wins and the others are killed. When the whole
+  batch fails, the next `width` candidates are raced, until one succeeds or
+  the candidates run out, so failures are still found in method order.
+
+  A race given a timeout is cancelled when it expires, or as soon as a
+  candidate reports `:timeout` because it ran out of the same time.
+  """
+
+  @type explore_fun :: (term() -> {:ok, term()} | :failure | :timeout)
+
+  @doc """
+  Races `candidates` in batches of `width`, for at most `timeout`
+  milliseconds in all.
+
+  Returns the winning candidate, its result, and the candidates that were
+  never finished (cancelled in the winning batch, or not yet started), in
+  their original order.
+  """
+  @spec race([term()], pos_integer(), explore_fun(), timeout()) ::
+          {:ok, term(), term(), [term()]} | :failure | :timeout
+  def race(candidates, width, explore, timeout \\ :infinity)
+
+  def race(candidates, width, explore, :infinity), do: race_until(candidates, width, explore, :infinity)
+
+  def race(candidates, width, explore, timeout),
+    do: race_until(candidates, width, explore, System.monotonic_time(:millisecond) + timeout)
+
+  defp race_until([], _width, _explore, _deadline), do: :failure
+
+  defp race_until(candidates, width, explore, deadline) do
+    {batch, rest} = Enum.split(candidates, width)
+
+    case race_batch(batch, explore, deadline) do
+      {:ok, winner, result, cancelled} -> {:ok, winner, result, cancelled ++ rest}
+      :failure -> race_until(rest, width, explore, deadline)
+      :timeout -> :timeout
+    end
+  end
+
+  defp race_batch(batch, explore, deadline) do
+    token = make_ref()
+    coordinator = self()
+
+    tasks =
+      batch
+      |> Enum.with_index()
+      |> Enum.map(fn {candidate, index} ->
+        Task.async(fn -> send(coordinator, {__MODULE__, token, index, explore.(candidate)}) end)
+      end)
+
+    result = await_first(token, List.to_tuple(batch), length(batch), MapSet.new(), deadline)
+
+    Enum.each(tasks, &Task.shutdown(&1, :brutal_kill))
+    flush(token)
+    result
+  end
+
+  defp await_first(_token, _batch, 0, _failed, _deadline), do: :failure
+
+  defp await_first(token, batch, pending, failed, deadline) do
+    receive do
+      {__MODULE__, ^token, index, {:ok, result}} ->
+        cancelled =
+          for {candidate, other} <- Enum.with_index(Tuple.to_list(batch)),
+              other != index and not MapSet.member?(failed, other),
+              do: candidate
+
+        {:ok, elem(batch, index), result, cancelled}
+
+      {__MODULE__, ^token, index, :failure} ->
+        await_first(token, batch, pending - 1, MapSet.put(failed, index), deadline)
+
+      {__MODULE__, ^token, _index, :timeout} ->
+        :timeout
+    after
+      time_left(deadline) -> :timeout
+    end
+  end
+
+  defp time_left(:infinity), do: :infinity
+  defp time_left(deadline), do: max(deadline - System.monotonic_time(:millisecond), 0)
+
+  # Drop results of workers that finished after the winner
+  defp flush(token) do
+    receive do
+      {__MODULE__, ^token, _index, _result} -> flush(token)
+    after
+      0 -> :ok
+    end
+  end
+end
@@ -0,0 +1,72 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2025-present K. S. Ernest (iFire) Lee
+
+defmodule AriaCore.Planner.LazyRefinement.Search do
+  @moduledoc """
+  Frontier of partial plans for the guided strategies of lazy plan
+  refinement.
+
+  `:best_first` and `:astar` keep every partial plan in one priority queue
+  (a `:gb_sets` ordered by priority, ties first in, first out) and always
+  expand the lowest. `:beam` expands generation by generation: the plans
+  pushed while one generation is expanded form the next, of which only the
+  `width` lowest are kept.
+  """
+
+  @enforce_keys [:strategy, :width]
+  defstruct [:strategy, :width, queue: :gb_sets.new(), next: [], seq: 0]
+
+  @type strategy :: :best_first | :astar | :beam
+
+  @type t :: %__MODULE__{
+          strategy: strategy(),
+          # Plans kept per generation, for :beam
+          width: pos_integer(),
+          # {priority, seq, plan} to expand, lowest first
+          queue: :gb_sets.set({number(), non_neg_integer(), term()}),
+          # Plans of the next generation, for :beam
+          next: [{number(), non_neg_integer(), term()}],
+          # Insertion counter; orders equal priorities and keeps plans from being compared
+          seq: non_neg_integer()
+        }
+
+  @doc """
+  Creates an empty frontier. `width` is only used by `:beam`.
+  """
+  @spec new(strategy(), pos_integer()) :: t()
+  def new(strategy, width) when strategy in [:best_first, :astar, :beam] and is_integer(width) and width > 0,
+    do: %__MODULE__{strategy: strategy, width: width}
+
+  def new(strategy, width) do
+    raise ArgumentError, "unknown search strategy #{inspect(strategy)} or beam width #{inspect(width)}"
+  end
+
+  @doc """
+  Adds `plan` with `priority`; lower priorities are expanded first.
+  """
+  @spec push(t(), number(), term()) :: t()
+  def push(%__MODULE__{strategy: :beam} = frontier, priority, plan),
+    do: %{frontier | next: [{priority, frontier.seq, plan} | frontier.next], seq: frontier.seq + 1}
+
+  def push(%__MODULE__{} = frontier, priority, plan),
+    do: %{frontier | queue: :gb_sets.add({priority, frontier.seq, plan}, frontier.queue), seq: frontier.seq + 1}
+
+  @doc """
+  Takes the next plan to expand, or returns `:empty`.
+  """
+  @spec pop(t()) :: {term(), t()} | :empty
+  def pop(%__MODULE__{queue: queue} = frontier) do
+    cond do
+      not :gb_sets.is_empty(queue) ->
+        {{_priority, _seq, plan}, queue} = :gb_sets.take_smallest(queue)
+        {plan, %{frontier | queue: queue}}
+
+      frontier.next != [] ->
+        generation = frontier.next |> Enum.sort() |> Enum.take(frontier.width) |> :gb_sets.from_list()
+        pop(%{frontier | queue: generation, next: []})
+
+      true ->
+        :empty
+    end
+  end
+end
@@ -0,0 +1,128 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2025-present K. S. Ernest (iFire) Lee
+
+defmodule AriaCore.Planner.LazyRefinement.SolutionGraph do
+  @moduledoc """
+  Array-backed solution graph for lazy plan refinement.
+
+  Node ids are dense integers handed out in creation order, so the node table
+  and the parent links are kept in `:array` tables indexed by id instead of a
+  map keyed by id. Every node keeps its ordered `successors` list; children of
+  a node are appended in a single batch per refinement, and `parent/2` answers
+  predecessor queries without scanning the graph.
+
+  Removed nodes leave a `nil` hole in the tables. Ids are never reused, which
+  keeps the ids handed out by `GraphOperations.add_nodes_and_edges/4` stable.
+  """
+
+  @enforce_keys [:nodes, :parents, :next_id]
+  defstruct [:nodes, :parents, :next_id]
+
+  @type node_id :: non_neg_integer()
+
+  @type t :: %__MODULE__{
+          # node_id => node attributes map
+          nodes: :array.array(map() | nil),
+          # node_id => parent node_id (nil for the root and removed nodes)
+          parents: :array.array(node_id() | nil),
+          # Next id to hand out
+          next_id: node_id()
+        }
+
+  @doc """
+  Creates a graph holding only the given root node with id 0.
+  """
+  @spec new(map()) :: t()
+  def new(root_node) do
+    %__MODULE__{
+      nodes: :array.set(0, root_node, :array.new(default: nil)),
+      parents: :array.new(default: nil),
+      next_id: 1
+    }
+  end
+
+  @doc """
+  Returns the node stored under `node_id`, or `nil` if there is none.
+  """
+  @spec get(t(), node_id()) :: map() | nil
+  def get(%__MODULE__{nodes: nodes}, node_id), do: :array.get(node_id, nodes)
+
+  @doc """
+  Replaces the node stored under `node_id`.
+  """
+  @spec put(t(), node_id(), map()) :: t()
+  def put(%__MODULE__{nodes: nodes} = graph, node_id, node), do: %{graph | nodes: :array.set(node_id, node, nodes)}
+
+  @doc """
+  Returns the parent id of `node_id` in O(1), or `nil` for the root.
+  """
+  @spec parent(t(), node_id()) :: node_id() | nil
+  def parent(%__MODULE__{parents: parents}, node_id), do: :array.get(node_id, parents)
+
+  @doc """
+  Returns the ordered successor ids of `node_id`.
+  """
+  @spec successors(t(), node_id()) :: [node_id()]
+  def successors(graph, node_id) do
+    case get(graph, node_id) do
+      %{successors: successors} when is_list(successors) -> successors
+      _ -> []
+    end
+  end
+
+  @doc """
+  Appends `child_nodes` under `parent_id` in order.
+
+  The new ids are `graph.next_id` onwards. The parent's successor list is
+  extended once for the whole batch. Returns the last id handed out (or
+  `graph.next_id - 1` when `child_nodes` is empty) and the updated graph.
+  """
+  @spec add_children(t(), node_id(), [map()]) :: {node_id(), t()}
+  def add_children(%__MODULE__{} = graph, _parent_id, []), do: {graph.next_id - 1, graph}
+
+  def add_children(%__MODULE__{} = graph, parent_id, child_nodes) do
+    {next_id, nodes, parents, new_ids} =
+      Enum.reduce(child_nodes, {graph.next_id, graph.nodes, graph.parents, []}, fn node, acc ->
+        {id, nodes, parents, ids} = acc
+        {id + 1, :array.set(id, node, nodes), :array.set(id, parent_id, parents), [id | ids]}
+      end)
+
+    parent_node = :array.get(parent_id, nodes)
+    parent_node = %{parent_node | successors: parent_node.successors ++ Enum.reverse(new_ids)}
+
+    {next_id - 1, %{graph | nodes: :array.set(parent_id, parent_node, nodes), parents: parents, next_id: next_id}}
+  end
+
+  @doc """
+  Removes `node_id` from the node table and drops its parent link.
+
+  The parent's successor list is left untouched; callers removing a subtree
+  clear it on the subtree root themselves.
+  """
+  @spec delete(t(), node_id()) :: t()
+  def delete(%__MODULE__{nodes: nodes, parents: parents} = graph, node_id) do
+    %{graph | nodes: :array.reset(node_id, nodes), parents: :array.reset(node_id, parents)}
+  end
+
+  @doc """
+  Returns the live nodes in id order.
+  """
+  @spec nodes(t()) :: [map()]
+  def nodes(%__MODULE__{nodes: nodes}) do
+    :array.sparse_foldr(fn _id, node, acc -> [node | acc] end, [], nodes)
+  end
+
+  @doc """
+  Number of live nodes.
+  """
+  @spec size(t()) :: non_neg_integer()
+  def size(%__MODULE__{nodes: nodes}), do: :array.sparse_foldl(fn _id, _node, acc -> acc + 1 end, 0, nodes)
+
+  @doc """
+  Converts the graph to the `%{node_id => node}` map form stored on plans.
+  """
+  @spec to_map(t()) :: %{node_id() => map()}
+  def to_map(%__MODULE__{nodes: nodes}) do
+    :array.sparse_foldl(fn id, node, acc -> Map.put(acc, id, node) end, %{}, nodes)
+  end
+end
@@ -4,8 +4,45 @@
 defmodule AriaCore.Planner.State do
   @moduledoc """
   Represents the planner's state, including current time, timeline, and entity capabilities.
+
+  Fact writes made through `update_fact/4` and `update/2` are recorded on a
+  trail (undo log). `checkpoint/1` marks the current trail position and
+  `restore/2` unwinds the writes made since then, so backtracking costs
+  O(changes since the choice point) instead of keeping a full copy of the
+  facts per choice point. Restoring is only valid on a state derived from
+  the checkpointed one through these functions.
+
+  Positions on the trail count every write since `new/5`. Once no
+  checkpoint below a position will be restored any more,
+  `truncate_trail/2` drops the entries before it, so a long run only keeps
+  the writes its live checkpoints can still undo.
+
+  The state also carries `hash`, a 64-bit Zobrist-style fingerprint of the
+  facts: the XOR of a hash of every leaf of the nested fact maps, keyed by
+  its path. Writes diff the maps they replace down to the changed leaves
+  and adjust it by those alone, and checkpoints restore it, so `equal?/2`
+  only compares facts whose hashes agree. Top-level entries given to
+  `new/5` as derived, such as indexes computed from the other facts, are
+  left out of it. `context_hash` does the same for the timeline and entity
+  capabilities: it is recomputed only when `update/2` replaces them, which
+  is how they should be changed, so `fingerprint/1` covers the whole state
+  without rehashing it.
   """
-  defstruct [:current_time, :timeline, :entity_capabilities, :facts]
+
+  import Bitwise
+
+  defstruct [
+    :current_time,
+    :timeline,
+    :entity_capabilities,
+    :facts,
+    hash: 0,
+    context_hash: 0,
+    derived: MapSet.new(),
+    trail: [],
+    trail_length: 0,
+    trail_base: 0
+  ]
 
   @type t :: %__MODULE__{
           current_time: DateTime.t(),
@@ -14,43 +51,253 @@ defmodule AriaCore.Planner.State do
           # Capabilities of entities in the domain
           entity_capabilities: map(),
           # subject_id => %{predicate_table => fact_value}
-          facts: %{String.t() => %{atom() => term()}}
+          facts: %{String.t() => %{atom() => term()}},
+          # XOR of the hashes of all facts but the derived ones, see value_hash/2
+          hash: non_neg_integer(),
+          # Hash of the timeline and entity capabilities, see context_hash/2
+          context_hash: non_neg_integer(),
+          # Top-level fact keys left out of `hash`, as they are functions of the other facts
+          derived: MapSet.t(),
+          # Undo log of fact writes, newest first
+          trail: [trail_entry()],
+          # Position after the newest write: writes recorded since new/5
+          trail_length: non_neg_integer(),
+          # Position of the oldest write still on the trail; older ones were truncated
+          trail_base: non_neg_integer()
         }
 
-  @spec new(DateTime.t(), map(), map(), map()) :: t()
-  def new(current_time, timeline, entity_capabilities, facts),
-    do: %__MODULE__{
+  # Previous value of the overwritten slot, as returned by Map.fetch/2
+  @type trail_entry ::
+          {:fact, String.t(), atom(), {:ok, term()} | :error}
+          | {:subject, String.t(), {:ok, term()} | :error}
+
+  # A fact as `update_fact/4` addresses it: the top-level key of `facts` and the key within it
+  @type fact_ref :: {term(), term()}
+
+  # Trail position and hashes plus the non-fact fields, which are kept by reference
+  @opaque checkpoint :: {non_neg_integer(), non_neg_integer(), non_neg_integer(), DateTime.t(), map(), map()}
+
+  # Each half of a fact hash comes from its own salted :erlang.phash2/2
+  @half_range 1 <<< 32
+
+  @doc """
+  Creates a state. The top-level fact entries named in `derived` are left
+  out of the fingerprint; they must be functions of the other facts.
+  """
+  @spec new(DateTime.t(), map(), map(), map(), [term()]) :: t()
+  def new(current_time, timeline, entity_capabilities, facts, derived \\ []) do
+    state = %__MODULE__{
       current_time: current_time,
       timeline: timeline,
       entity_capabilities: entity_capabilities,
-      facts: facts
+      facts: facts,
+      context_hash: context_hash(timeline, entity_capabilities),
+      derived: MapSet.new(derived)
     }
 
+    Enum.reduce(facts, state, fn {subject_id, value}, state ->
+      rehash(state, subject_id, fn -> value_hash(subject_id, value) end)
+    end)
+  end
+
+  @doc """
+  Returns the 64-bit fingerprint of the state: its facts, current time,
+  timeline and entity capabilities.
+
+  States that are `equal?/2` have equal fingerprints; the converse holds
+  with high probability only.
+  """
+  @spec fingerprint(t()) :: non_neg_integer()
+  def fingerprint(%__MODULE__{hash: hash, context_hash: context_hash, current_time: current_time}),
+    do: hash |> bxor(context_hash) |> bxor(half_hashes({:current_time, current_time}))
+
+  @doc """
+  Whether two states hold the same facts at the same time, with the same
+  timeline and entity capabilities. The trails are not compared.
+
+  States whose fingerprints differ are told apart without looking at their
+  facts.
+  """
+  @spec equal?(t(), t()) :: boolean()
+  def equal?(%__MODULE__{hash: hash} = state, %__MODULE__{hash: hash} = other) do
+    state.facts == other.facts and state.current_time == other.current_time and state.timeline == other.timeline and
+      state.entity_capabilities == other.entity_capabilities
+  end
+
+  def equal?(%__MODULE__{}, %__MODULE__{}), do: false
+
+  @doc """
+  Returns a state that can be modified independently of `state`.
+
+  Facts are immutable terms, so the copy shares them with the original and
+  costs O(1); later writes to either state do not affect the other.
+  """
   @spec copy(t()) :: t()
-  def copy(state) do
-    %{state | facts: deep_copy_map(state.facts)}
+  def copy(state), do: state
+
+  @doc """
+  Marks the current trail position so that `restore/2` can return to it.
+  """
+  @spec checkpoint(t()) :: checkpoint()
+  def checkpoint(%__MODULE__{} = state) do
+    {state.trail_length, state.hash, state.context_hash, state.current_time, state.timeline, state.entity_capabilities}
   end
 
-  defp deep_copy_map(map) when is_map(map) do
-    Enum.reduce(map, %{}, fn {key, value}, acc ->
-      Map.put(acc, key, deep_copy_map(value))
-    end)
+  @doc """
+  Unwinds the fact writes recorded since `checkpoint` was taken.
+  """
+  @spec restore(t(), checkpoint()) :: t()
+  def restore(
+        %__MODULE__{trail_length: trail_length, trail_base: trail_base} = state,
+        {mark, hash, context_hash, current_time, timeline, entity_capabilities}
+      )
+      when mark >= trail_base and mark <= trail_length do
+    {trail, facts} = unwind(state.trail, trail_length - mark, state.facts)
+
+    %{
+      state
+      | facts: facts,
+        hash: hash,
+        context_hash: context_hash,
+        trail: trail,
+        trail_length: mark,
+        current_time: current_time,
+        timeline: timeline,
+        entity_capabilities: entity_capabilities
+    }
+  end
+
+  def restore(%__MODULE__{} = state, {mark, _hash, _context_hash, _current_time, _timeline, _entity_capabilities})
+      when mark < state.trail_base do
+    raise ArgumentError, "checkpoint precedes the truncated trail; its writes can no longer be undone"
   end
 
-  defp deep_copy_map(list) when is_list(list) do
-    Enum.map(list, &deep_copy_map/1)
+  def restore(%__MODULE__{}, {_mark, _hash, _context_hash, _current_time, _timeline, _entity_capabilities}) do
+    raise ArgumentError, "checkpoint is ahead of the state's trail; the state was not derived from it"
   end
 
-  defp deep_copy_map(other), do: other
+  @doc """
+  Returns the trail position `checkpoint` marks, the number of writes
+  recorded when it was taken.
+  """
+  @spec trail_position(checkpoint()) :: non_neg_integer()
+  def trail_position({mark, _hash, _context_hash, _current_time, _timeline, _entity_capabilities}), do: mark
+
+  @doc """
+  Returns the trail position of the newest recorded write to any of
+  `facts`, or `0` if none is on the trail. A write to a whole top-level
+  entry counts as a write to every fact under it.
+
+  A checkpoint precedes that write when its `trail_position/1` is smaller.
+  """
+  @spec last_write(t(), [fact_ref()]) :: non_neg_integer()
+  def last_write(%__MODULE__{trail: trail, trail_length: trail_length}, facts) do
+    find_write(trail, trail_length, MapSet.new(facts), MapSet.new(facts, &elem(&1, 0)))
+  end
 
-  @spec update(t(), t()) :: t()
+  defp find_write([], _position, _facts, _subjects), do: 0
+
+  defp find_write([{:fact, subject_id, predicate_table, _previous} | rest], position, facts, subjects) do
+    if MapSet.member?(facts, {subject_id, predicate_table}),
+      do: position,
+      else: find_write(rest, position - 1, facts, subjects)
+  end
+
+  defp find_write([{:subject, subject_id, _previous} | rest], position, facts, subjects) do
+    if MapSet.member?(subjects, subject_id), do: position, else: find_write(rest, position - 1, facts, subjects)
+  end
+
+  @doc """
+  Drops the trail entries before position `mark`, which must not be ahead
+  of the trail. Checkpoints below `mark` can no longer be restored; later
+  ones still can, and positions are unchanged.
+  """
+  @spec truncate_trail(t(), non_neg_integer()) :: t()
+  def truncate_trail(%__MODULE__{trail_base: trail_base} = state, mark) when mark <= trail_base, do: state
+
+  def truncate_trail(%__MODULE__{trail_length: trail_length} = state, mark) when mark <= trail_length,
+    do: %{state | trail: Enum.take(state.trail, trail_length - mark), trail_base: mark}
+
+  @doc """
+  Number of writes kept on the trail.
+  """
+  @spec trail_size(t()) :: non_neg_integer()
+  def trail_size(%__MODULE__{} = state), do: state.trail_length - state.trail_base
+
+  defp unwind(trail, 0, facts), do: {trail, facts}
+  defp unwind([entry | rest], count, facts), do: unwind(rest, count - 1, undo(entry, facts))
+
+  defp undo({:fact, subject_id, predicate_table, {:ok, value}}, facts),
+    do: Map.update!(facts, subject_id, &Map.put(&1, predicate_table, value))
+
+  defp undo({:fact, subject_id, predicate_table, :error}, facts),
+    do: Map.update!(facts, subject_id, &Map.delete(&1, predicate_table))
+
+  defp undo({:subject, subject_id, {:ok, value}}, facts), do: Map.put(facts, subject_id, value)
+  defp undo({:subject, subject_id, :error}, facts), do: Map.delete(facts, subject_id)
+
+  defp push_trail(state, entry), do: %{state | trail: [entry | state.trail], trail_length: state.trail_length + 1}
+
+  @spec update(t(), t() | map()) :: t()
   def update(state, new_state) do
-    Map.merge(state, new_state, fn
-      :facts, old_facts, new_facts -> Map.merge(old_facts, new_facts, &recursive_map_merge/3)
-      _key, _old_value, new_value -> new_value
+    dropped = [:__struct__, :facts, :hash, :context_hash, :derived, :trail, :trail_length, :trail_base]
+    state = rehash_context(state, Map.merge(state, Map.drop(new_state, dropped)))
+
+    Enum.reduce(Map.get(new_state, :facts, %{}), state, fn {subject_id, new_facts}, acc ->
+      case Map.fetch(acc.facts, subject_id) do
+        {:ok, old_facts} when is_map(old_facts) and is_map(new_facts) ->
+          Enum.reduce(new_facts, acc, fn {predicate_table, new_value}, acc ->
+            merged_value =
+              case Map.fetch(old_facts, predicate_table) do
+                {:ok, old_value} -> recursive_map_merge(predicate_table, old_value, new_value)
+                :error -> new_value
+              end
+
+            update_fact(acc, subject_id, predicate_table, merged_value)
+          end)
+
+        _previous ->
+          put_subject(acc, subject_id, new_facts)
+      end
     end)
   end
 
+  @doc """
+  Replaces the whole top-level entry `subject_id` of the facts with
+  `value`, recording the previous one as a single trail entry.
+
+  Unlike `update/2`, nothing is merged: keys missing from `value` are gone
+  afterwards, and a struct such as a `MapSet` replaces the old value
+  instead of being merged into it. Only the leaves under the entry that
+  changed are rehashed.
+  """
+  @spec put_subject(t(), term(), term()) :: t()
+  def put_subject(%__MODULE__{} = state, subject_id, value) do
+    previous = Map.fetch(state.facts, subject_id)
+
+    state
+    |> push_trail({:subject, subject_id, previous})
+    |> Map.put(:facts, Map.put(state.facts, subject_id, value))
+    |> rehash(subject_id, fn -> value_delta(subject_id, previous, value) end)
+  end
+
+  @doc """
+  Removes the top-level entry `subject_id` of the facts, recording it on the trail.
+  """
+  @spec delete_subject(t(), term()) :: t()
+  def delete_subject(%__MODULE__{} = state, subject_id) do
+    case Map.fetch(state.facts, subject_id) do
+      {:ok, value} = previous ->
+        state
+        |> push_trail({:subject, subject_id, previous})
+        |> Map.put(:facts, Map.delete(state.facts, subject_id))
+        |> rehash(subject_id, fn -> value_hash(subject_id, value) end)
+
+      :error ->
+        state
+    end
+  end
+
   defp recursive_map_merge(_key, old_value, new_value) when is_map(old_value) and is_map(new_value) do
     Map.merge(old_value, new_value, &recursive_map_merge/3)
   end
@@ -58,24 +305,72 @@ defmodule AriaCore.Planner.State do
   defp recursive_map_merge(_key, _old_value, new_value), do: new_value
 
   @doc """
-  Updates a specific fact in the state.
+  Updates a specific fact in the state, recording the previous value on the trail.
   """
   @spec update_fact(t(), String.t(), atom(), term()) :: t()
   def update_fact(state, subject_id, predicate_table, fact_value) do
-    %{
-      state
-      | facts:
-          Map.update(
-            state.facts,
-            subject_id,
-            %{predicate_table => fact_value},
-            fn existing_facts ->
-              Map.put(existing_facts, predicate_table, fact_value)
-            end
-          )
-    }
+    case Map.fetch(state.facts, subject_id) do
+      {:ok, existing_facts} ->
+        previous = Map.fetch(existing_facts, predicate_table)
+
+        state
+        |> push_trail({:fact, subject_id, predicate_table, previous})
+        |> Map.put(:facts, Map.put(state.facts, subject_id, Map.put(existing_facts, predicate_table, fact_value)))
+        |> rehash(subject_id, fn -> value_delta({subject_id, predicate_table}, previous, fact_value) end)
+
+      :error ->
+        state
+        |> push_trail({:subject, subject_id, :error})
+        |> Map.put(:facts, Map.put(state.facts, subject_id, %{predicate_table => fact_value}))
+        |> rehash(subject_id, fn -> value_hash(subject_id, %{predicate_table => fact_value}) end)
+    end
   end
 
+  # Derived facts are left out of the hash
+  defp rehash(%__MODULE__{derived: derived} = state, subject_id, delta) do
+    if MapSet.member?(derived, subject_id), do: state, else: %{state | hash: bxor(state.hash, delta.())}
+  end
+
+  # A plain map contributes a marker plus the hashes of its entries, one level
+  # down the path, so leaves are hashed on their own; anything else is one leaf
+  defp value_hash(path, value) when is_map(value) and not is_struct(value) do
+    Enum.reduce(value, half_hashes({path, :map}), fn {key, child}, hash ->
+      bxor(hash, value_hash({path, key}, child))
+    end)
+  end
+
+  defp value_hash(path, value), do: half_hashes({path, value})
+
+  # Hash change from replacing the value at `path`; entries left as they were cancel out
+  defp value_delta(path, {:ok, old}, new)
+       when is_map(old) and not is_struct(old) and is_map(new) and not is_struct(new) do
+    delta =
+      Enum.reduce(new, 0, fn {key, value}, hash ->
+        case Map.fetch(old, key) do
+          {:ok, ^value} -> hash
+          previous -> bxor(hash, value_delta({path, key}, previous, value))
+        end
+      end)
+
+    Enum.reduce(old, delta, fn {key, value}, hash ->
+      if Map.has_key?(new, key), do: hash, else: bxor(hash, value_hash({path, key}, value))
+    end)
+  end
+
+  defp value_delta(path, {:ok, old}, new), do: bxor(value_hash(path, old), value_hash(path, new))
+  defp value_delta(path, :error, new), do: value_hash(path, new)
+
+  # Rehashes the timeline and entity capabilities only when they were replaced
+  defp rehash_context(previous, state) do
+    if previous.timeline === state.timeline and previous.entity_capabilities === state.entity_capabilities,
+      do: state,
+      else: %{state | context_hash: context_hash(state.timeline, state.entity_capabilities)}
+  end
+
+  defp context_hash(timeline, entity_capabilities), do: half_hashes({:context, timeline, entity_capabilities})
+
+  defp half_hashes(term), do: :erlang.phash2({:hi, term}, @half_range) <<< 32 ||| :erlang.phash2(term, @half_range)
+
   @doc """
   Retrieves a specific fact from the state.
   """
@@ -94,15 +389,47 @@ defmodule AriaCore.Planner.State do
 
   ## Examples
 
-      # For goal format: {"activity_status", ["activity_1", "completed"]}
-      get_fact_by_predicate(state, "activity_status", "activity_1")
+      # For goal format: {"activity_status", [1, "completed"]}
+      get_fact_by_predicate(state, "activity_status", 1)
       # => "completed"
   """
-  @spec get_fact_by_predicate(t(), String.t(), String.t()) :: term() | nil
+  @spec get_fact_by_predicate(t(), String.t(), term()) :: term() | nil
   def get_fact_by_predicate(state, predicate_table, subject_id) do
     state.facts
     # Return an empty map if predicate_table is not found
     |> Map.get(predicate_table, %{})
     |> Map.get(subject_id)
   end
+
+  @doc false
+  # JSON form of a term: tuples become lists, sets become sorted lists and
+  # map keys that are not strings, atoms or numbers are rendered with inspect/1
+  @spec json_term(term()) :: term()
+  def json_term(%DateTime{} = datetime), do: datetime
+  def json_term(%MapSet{} = set), do: set |> Enum.sort() |> Enum.map(&json_term/1)
+  def json_term(%_{} = struct), do: struct |> Map.from_struct() |> json_term()
+
+  def json_term(map) when is_map(map),
+    do: Map.new(map, fn {key, value} -> {json_key(key), json_term(value)} end)
+
+  def json_term(list) when is_list(list), do: Enum.map(list, &json_term/1)
+  def json_term(tuple) when is_tuple(tuple), do: tuple |> Tuple.to_list() |> json_term()
+  def json_term(term), do: term
+
+  defp json_key(key) when is_binary(key) or is_atom(key) or is_number(key), do: key
+  defp json_key(key), do: inspect(key)
+
+  defimpl Jason.Encoder do
+    def encode(state, opts) do
+      Jason.Encode.map(
+        %{
+          current_time: state.current_time,
+          timeline: AriaCore.Planner.State.json_term(state.timeline),
+          entity_capabilities: AriaCore.Planner.State.json_term(state.entity_capabilities),
+          facts: AriaCore.Planner.State.json_term(state.facts)
+        },
+        opts
+      )
+    end
+  end
 end
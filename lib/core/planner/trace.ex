@@ -0,0 +1,80 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2025-present K. S. Ernest (iFire) Lee
+
+defmodule AriaCore.Planner.Trace do
+  @moduledoc """
+  Tracing surface for lazy plan refinement.
+
+  ## Telemetry
+
+  Always emitted. With no handler attached an event costs one ETS lookup;
+  no strings are built and metadata only references existing terms.
+
+    * `[:aria_planner, :lazy_refinement, :run, :start | :stop | :exception]` -
+      one planning run. Metadata: `:plan_id`.
+    * `[:aria_planner, :lazy_refinement, :iteration]` - one refinement step.
+      Measurements: `:duration` (native units). Metadata: `:iteration`,
+      `:node_id`, `:type`, `:transition`.
+    * `[:aria_planner, :lazy_refinement, :refine, :start | :stop | :exception]` -
+      applying the methods of a task, goal or multigoal node. Metadata:
+      `:node_id`, `:type`, `:info`.
+    * `[:aria_planner, :lazy_refinement, :action, :start | :stop | :exception]` -
+      executing an action. Metadata: `:node_id`, `:info`.
+    * `[:aria_planner, :lazy_refinement, :backtrack, :start | :stop | :exception]` -
+      backtracking from a failed node. Metadata: `:node_id`, `:parent_node_id`.
+    * `[:aria_planner, :lazy_refinement, :nogoods]` - the run's table of
+      refinements known to fail, once it is over. Measurements: `:size`,
+      `:hits`, `:misses`. Metadata: `:plan_id`.
+
+  ## Debug events
+
+  `debug/2` calls are compiled out unless enabled with
+
+      config :aria_planner, AriaCore.Planner.Trace, debug: true
+
+  When enabled they are logged at debug level, and the message is only
+  formatted if the logger accepts debug messages.
+  """
+
+  @prefix [:aria_planner, :lazy_refinement]
+  @debug Application.compile_env(:aria_planner, [__MODULE__, :debug], false)
+
+  @doc """
+  Records a debug event. Expands to nothing unless debug tracing is enabled
+  at compile time; neither argument is evaluated in that case.
+  """
+  defmacro debug(event, metadata) do
+    if @debug do
+      quote do
+        require Logger
+        Logger.debug(fn -> AriaCore.Planner.Trace.format(unquote(event), unquote(metadata)) end)
+      end
+    else
+      # Wrapped in an anonymous function to avoid unused variable warnings
+      quote do
+        _ = fn -> {unquote(event), unquote(metadata)} end
+        :ok
+      end
+    end
+  end
+
+  @doc false
+  @spec format(atom(), map()) :: String.t()
+  def format(event, metadata), do: "#{event} #{inspect(metadata)}"
+
+  @doc """
+  Runs `fun` inside a `:telemetry` span named `[:aria_planner, :lazy_refinement, name]`.
+  """
+  @spec span(atom(), map(), (-> result)) :: result when result: term()
+  def span(name, metadata, fun) do
+    :telemetry.span(@prefix ++ [name], metadata, fn -> {fun.(), metadata} end)
+  end
+
+  @doc """
+  Emits `[:aria_planner, :lazy_refinement, name]` with the given measurements.
+  """
+  @spec event(atom(), map(), map()) :: :ok
+  def event(name, measurements, metadata) do
+    :telemetry.execute(@prefix ++ [name], measurements, metadata)
+  end
+end
@@ -0,0 +1,327 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2025-present K. S. Ernest (iFire) Lee
+
+defmodule AriaPlanner.Domains.AircraftDisassembly.ActivityModel do
+  @moduledoc """
+  Read-only, struct-of-arrays view of an aircraft disassembly instance.
+
+  Built once by `StateInitialization.initialize_state/1` and stored under
+  the state's `:model` key. Per-activity and per-resource data live in
+  tuples indexed by the 1-based activity, resource or location number, so
+  every accessor is a constant-time `elem/2`:
+
+    * `sreq` - one tuple of required resource counts per activity, by skill
+    * `mastery` - one skill bitmask per resource, bit `s - 1` set when the
+      resource masters skill `s`
+    * `skill_resources` - one resource bitset per skill, bit `r - 1` set when
+      resource `r` masters it
+    * `useful_resources` - one resource bitset per activity; every resource
+      when the instance does not restrict it
+    * `predecessors`, `successors` - activity lists per activity
+    * `unavailable` - `{start, end}` hour periods per resource
+    * `breakpoints`, `busy` - the same periods indexed by time: the sorted
+      period boundaries, and for each span between consecutive boundaries
+      the bitset of resources unavailable throughout it
+  """
+
+  import Bitwise
+
+  @type bitset :: non_neg_integer()
+
+  @type t :: %__MODULE__{
+          num_activities: non_neg_integer(),
+          num_resources: non_neg_integer(),
+          num_skills: non_neg_integer(),
+          durations: tuple(),
+          locations: tuple(),
+          occupancy: tuple(),
+          mass: tuple(),
+          location_capacities: tuple(),
+          sreq: tuple(),
+          mastery: tuple(),
+          skill_resources: tuple(),
+          useful_resources: tuple(),
+          predecessors: tuple(),
+          successors: tuple(),
+          unavailable: tuple(),
+          breakpoints: tuple(),
+          busy: tuple()
+        }
+
+  defstruct num_activities: 0,
+            num_resources: 0,
+            num_skills: 0,
+            durations: {},
+            locations: {},
+            occupancy: {},
+            mass: {},
+            location_capacities: {},
+            sreq: {},
+            mastery: {},
+            skill_resources: {},
+            useful_resources: {},
+            predecessors: {},
+            successors: {},
+            unavailable: {},
+            breakpoints: {},
+            busy: {}
+
+  @doc """
+  Builds the model from an initialized state map, or returns the one it
+  already carries.
+  """
+  @spec of(map()) :: t()
+  def of(%{model: %__MODULE__{} = model}), do: model
+  def of(state) when is_map(state), do: new(state)
+
+  @doc """
+  Builds the model from the list-valued fields of a state map.
+  """
+  @spec new(map()) :: t()
+  def new(state) when is_map(state) do
+    num_activities = Map.get(state, :num_activities, 0)
+    num_resources = Map.get(state, :num_resources, 0)
+    num_skills = Map.get(state, :nSkills, 3)
+    precedences = Map.get(state, :precedences, [])
+
+    sreq = state |> list(:sreq) |> chunk(num_skills, num_activities, 0)
+
+    mastery =
+      state
+      |> list(:mastery)
+      |> chunk(num_skills, num_resources, false)
+      |> Tuple.to_list()
+      |> Enum.map(&skill_mask/1)
+
+    unavailable = unavailable(state, num_resources)
+
+    %__MODULE__{
+      num_activities: num_activities,
+      num_resources: num_resources,
+      num_skills: num_skills,
+      durations: indexed(list(state, :durations), num_activities, 0),
+      locations: indexed(list(state, :locations), num_activities, 1),
+      occupancy: indexed(list(state, :occupancy), num_activities, 1),
+      mass: indexed(list(state, :mass), num_activities, 0),
+      location_capacities: List.to_tuple(list(state, :location_capacities)),
+      sreq: sreq,
+      mastery: List.to_tuple(mastery),
+      skill_resources: skill_resources(mastery, num_skills),
+      useful_resources: useful_resources(Map.get(state, :useful_res), num_activities, num_resources),
+      predecessors: adjacency(for({pred, succ} <- precedences, do: {succ, pred}), num_activities),
+      successors: adjacency(precedences, num_activities),
+      unavailable: unavailable
+    }
+    |> index_unavailability()
+  end
+
+  @doc "Duration of `activity` in hours."
+  @spec duration(t(), pos_integer()) :: non_neg_integer()
+  def duration(%__MODULE__{durations: durations}, activity), do: at(durations, activity, 0)
+
+  @doc "Location of `activity`."
+  @spec location(t(), pos_integer()) :: pos_integer()
+  def location(%__MODULE__{locations: locations}, activity), do: at(locations, activity, 1)
+
+  @doc "Location capacity units `activity` occupies."
+  @spec occupancy(t(), pos_integer()) :: non_neg_integer()
+  def occupancy(%__MODULE__{occupancy: occupancy}, activity), do: at(occupancy, activity, 1)
+
+  @doc "Mass removed by `activity`."
+  @spec mass(t(), pos_integer()) :: integer()
+  def mass(%__MODULE__{mass: mass}, activity), do: at(mass, activity, 0)
+
+  @doc "Capacity of `location`."
+  @spec location_capacity(t(), pos_integer()) :: non_neg_integer()
+  def location_capacity(%__MODULE__{location_capacities: capacities}, location), do: at(capacities, location, 1)
+
+  @doc "Number of resources mastering `skill` that `activity` requires."
+  @spec skill_requirement(t(), pos_integer(), pos_integer()) :: non_neg_integer()
+  def skill_requirement(%__MODULE__{sreq: sreq}, activity, skill) do
+    case at(sreq, activity, {}) do
+      requirements when skill <= tuple_size(requirements) -> elem(requirements, skill - 1)
+      _ -> 0
+    end
+  end
+
+  @doc "Whether `resource` masters `skill`."
+  @spec has_skill?(t(), pos_integer(), pos_integer()) :: boolean()
+  def has_skill?(%__MODULE__{mastery: mastery}, resource, skill),
+    do: (at(mastery, resource, 0) &&& 1 <<< (skill - 1)) != 0
+
+  @doc "Bitset of the resources mastering `skill`."
+  @spec skill_resources(t(), pos_integer()) :: bitset()
+  def skill_resources(%__MODULE__{skill_resources: resources}, skill), do: at(resources, skill, 0)
+
+  @doc "Bitset of the resources useful to `activity`."
+  @spec useful_resources(t(), pos_integer()) :: bitset()
+  def useful_resources(%__MODULE__{useful_resources: resources}, activity), do: at(resources, activity, 0)
+
+  @doc "Activities that must complete before `activity` starts."
+  @spec predecessors(t(), pos_integer()) :: [pos_integer()]
+  def predecessors(%__MODULE__{predecessors: predecessors}, activity), do: at(predecessors, activity, [])
+
+  @doc "Activities that must wait for `activity` to complete."
+  @spec successors(t(), pos_integer()) :: [pos_integer()]
+  def successors(%__MODULE__{successors: successors}, activity), do: at(successors, activity, [])
+
+  @doc "`{start, end}` hours during which `resource` is unavailable."
+  @spec unavailable_periods(t(), pos_integer()) :: [{integer(), integer()}]
+  def unavailable_periods(%__MODULE__{unavailable: unavailable}, resource), do: at(unavailable, resource, [])
+
+  @doc """
+  Bitset of the resources with no unavailability overlapping `[from, to)`.
+
+  Only the time spans between `from` and `to` are visited, found by binary
+  search over the period boundaries.
+  """
+  @spec available_resources(t(), integer(), integer()) :: bitset()
+  def available_resources(%__MODULE__{breakpoints: breakpoints, busy: busy} = model, from, to) when from < to do
+    span = first_span(breakpoints, from, 0, tuple_size(breakpoints) - 1)
+    ((1 <<< model.num_resources) - 1) &&& ~~~busy_between(breakpoints, busy, span, to, 0)
+  end
+
+  # An instant is only blocked by periods strictly around it
+  def available_resources(%__MODULE__{unavailable: unavailable, num_resources: num_resources}, from, to) do
+    Enum.reduce(1..num_resources//1, 0, fn resource, bits ->
+      free = Enum.all?(elem(unavailable, resource - 1), fn {start, stop} -> to <= start or from >= stop end)
+      if free, do: bits ||| 1 <<< (resource - 1), else: bits
+    end)
+  end
+
+  @doc "Members of a bitset, ascending."
+  @spec members(bitset()) :: [pos_integer()]
+  def members(bits), do: members(bits, 1, [])
+
+  defp members(0, _index, acc), do: Enum.reverse(acc)
+  defp members(bits, index, acc) when (bits &&& 1) == 1, do: members(bits >>> 1, index + 1, [index | acc])
+  defp members(bits, index, acc), do: members(bits >>> 1, index + 1, acc)
+
+  defp at(tuple, index, _default) when index >= 1 and index <= tuple_size(tuple), do: elem(tuple, index - 1)
+  defp at(_tuple, _index, default), do: default
+
+  defp list(state, key) do
+    case Map.get(state, key) do
+      list when is_list(list) -> list
+      _ -> []
+    end
+  end
+
+  # Pads or truncates to exactly `count` entries
+  defp indexed(list, count, default) do
+    list |> Stream.concat(Stream.repeatedly(fn -> default end)) |> Enum.take(count) |> List.to_tuple()
+  end
+
+  # Splits a flattened row-major matrix into one tuple per row
+  defp chunk(_list, 0, rows, _default), do: List.to_tuple(List.duplicate({}, rows))
+
+  defp chunk(list, width, rows, default) do
+    list
+    |> Stream.concat(Stream.repeatedly(fn -> default end))
+    |> Stream.chunk_every(width)
+    |> Enum.take(rows)
+    |> Enum.map(&List.to_tuple/1)
+    |> List.to_tuple()
+  end
+
+  defp skill_mask(skills) do
+    skills
+    |> Tuple.to_list()
+    |> Enum.with_index()
+    |> Enum.reduce(0, fn
+      {true, index}, mask -> mask ||| 1 <<< index
+      {_, _index}, mask -> mask
+    end)
+  end
+
+  defp skill_resources(masks, num_skills) do
+    resources =
+      for skill <- 0..(num_skills - 1)//1 do
+        masks
+        |> Enum.with_index()
+        |> Enum.reduce(0, fn {mask, index}, bits ->
+          if (mask &&& 1 <<< skill) != 0, do: bits ||| 1 <<< index, else: bits
+        end)
+      end
+
+    List.to_tuple(resources)
+  end
+
+  defp useful_resources(useful_res, num_activities, num_resources) do
+    all = (1 <<< num_resources) - 1
+    entries = if is_list(useful_res), do: useful_res, else: []
+
+    entries
+    |> Stream.concat(Stream.repeatedly(fn -> nil end))
+    |> Stream.map(fn
+      %MapSet{} = resources -> bitset(resources)
+      resources when is_list(resources) -> bitset(resources)
+      _ -> all
+    end)
+    |> Enum.take(num_activities)
+    |> List.to_tuple()
+  end
+
+  defp bitset(resources) do
+    Enum.reduce(resources, 0, fn
+      resource, bits when is_integer(resource) and resource >= 1 -> bits ||| 1 <<< (resource - 1)
+      _, bits -> bits
+    end)
+  end
+
+  # Span i runs from breakpoint i to breakpoint i + 1
+  defp index_unavailability(%__MODULE__{unavailable: unavailable} = model) do
+    periods =
+      for {resource_periods, index} <- Enum.with_index(Tuple.to_list(unavailable)),
+          {start, stop} <- resource_periods,
+          start < stop,
+          do: {start, stop, 1 <<< index}
+
+    breakpoints = periods |> Enum.flat_map(fn {start, stop, _bit} -> [start, stop] end) |> Enum.uniq() |> Enum.sort()
+
+    busy =
+      breakpoints
+      |> Enum.zip(Enum.drop(breakpoints, 1))
+      |> Enum.map(fn {from, to} ->
+        Enum.reduce(periods, 0, fn
+          {start, stop, bit}, bits when start <= from and stop >= to -> bits ||| bit
+          _period, bits -> bits
+        end)
+      end)
+
+    %{model | breakpoints: List.to_tuple(breakpoints), busy: List.to_tuple(busy)}
+  end
+
+  # First span ending after `time`: the smallest i with breakpoint i + 1 > time
+  defp first_span(_breakpoints, _time, low, high) when low >= high, do: low
+
+  defp first_span(breakpoints, time, low, high) do
+    mid = div(low + high, 2)
+
+    if elem(breakpoints, mid + 1) > time,
+      do: first_span(breakpoints, time, low, mid),
+      else: first_span(breakpoints, time, mid + 1, high)
+  end
+
+  defp busy_between(breakpoints, busy, span, to, bits) when span < tuple_size(busy) do
+    if elem(breakpoints, span) < to,
+      do: busy_between(breakpoints, busy, span + 1, to, bits ||| elem(busy, span)),
+      else: bits
+  end
+
+  defp busy_between(_breakpoints, _busy, _span, _to, bits), do: bits
+
+  defp adjacency(pairs, count) do
+    grouped = Enum.group_by(pairs, &elem(&1, 0), &elem(&1, 1))
+    List.to_tuple(for index <- 1..count//1, do: Map.get(grouped, index, []))
+  end
+
+  defp unavailable(state, num_resources) do
+    periods =
+      [list(state, :unavailable_resource), list(state, :unavailable_start), list(state, :unavailable_end)]
+      |> Enum.zip()
+      |> Enum.group_by(&elem(&1, 0), fn {_resource, start, stop} -> {start, stop} end)
+
+    List.to_tuple(for resource <- 1..num_resources//1, do: Map.get(periods, resource, []))
+  end
+end
@@ -15,6 +15,7 @@ defmodule AriaPlanner.Domains.AircraftDisassembly.Commands.CompleteActivity do
   - activity_status[activity] = "completed"
   """
 
+  alias AriaPlanner.Domains.AircraftDisassembly.StateHelpers
   alias AriaPlanner.Planner.PlannerMetadata
   alias AriaPlanner.Planner.MetadataHelpers
 
@@ -23,8 +24,7 @@ defmodule AriaPlanner.Domains.AircraftDisassembly.Commands.CompleteActivity do
   def c_complete_activity(state, activity) do
     with :ok <- check_activity_in_progress(state, activity) do
       # Update state: set activity status to "completed" using facts
-      activity_id = "activity_#{activity}"
-      new_state = update_activity_status(state, activity_id, "completed")
+      new_state = StateHelpers.put_activity_status(state, activity, "completed")
 
       # Return planner metadata - completion is instant
       metadata = MetadataHelpers.instant_metadata("worker", [:disassembly])
@@ -39,8 +39,7 @@ defmodule AriaPlanner.Domains.AircraftDisassembly.Commands.CompleteActivity do
 
   @spec check_activity_in_progress(map(), integer()) :: :ok | {:error, String.t()}
   defp check_activity_in_progress(state, activity) do
-    activity_id = "activity_#{activity}"
-    status = get_activity_status(state, activity_id)
+    status = StateHelpers.get_activity_status(state, activity)
 
     if status == "in_progress" do
       :ok
@@ -48,37 +47,4 @@ defmodule AriaPlanner.Domains.AircraftDisassembly.Commands.CompleteActivity do
       {:error, "Activity #{activity} is not in progress (status: #{status})"}
     end
   end
-
-  @spec get_activity_status(map(), String.t()) :: String.t()
-  defp get_activity_status(state, activity_id) do
-    # Use planner's state facts system
-    case Map.get(state, :facts, %{}) do
-      facts when is_map(facts) ->
-        case Map.get(facts, "activity_status", %{}) do
-          status_map when is_map(status_map) ->
-            Map.get(status_map, activity_id, "not_started")
-
-          _ ->
-            "not_started"
-        end
-
-      _ ->
-        # Fallback to old state structure
-        Map.get(
-          state.activity_status || %{},
-          String.to_integer(String.replace(activity_id, "activity_", "")),
-          "not_started"
-        )
-    end
-  end
-
-  @spec update_activity_status(map(), String.t(), String.t()) :: map()
-  defp update_activity_status(state, activity_id, status) do
-    # Update using planner's state facts system
-    facts = Map.get(state, :facts, %{})
-    activity_status_facts = Map.get(facts, "activity_status", %{})
-    updated_activity_status = Map.put(activity_status_facts, activity_id, status)
-    updated_facts = Map.put(facts, "activity_status", updated_activity_status)
-    Map.put(state, :facts, updated_facts)
-  end
 end
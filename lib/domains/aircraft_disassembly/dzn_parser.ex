@@ -3,268 +3,333 @@
 
 defmodule AriaPlanner.Domains.AircraftDisassembly.DznParser do
   @moduledoc """
-  Parser for MiniZinc .dzn data files using ABNF grammar via abnf_parsec.
+  Streaming parser for MiniZinc .dzn data files.
+
+  Files are read in fixed-size chunks and tokenized with binary pattern
+  matching; tokens feed a push-down builder that assembles each value as
+  its closing bracket arrives, so neither the file nor a token list is ever
+  held in memory. A token split across two chunks is carried over to the
+  next one.
+
+  Values decode to:
+
+    * integers, floats, booleans and strings
+    * `<>` (absent) as `nil`
+    * `[...]` arrays as lists, `{...}` sets as `MapSet`s and `a..b` as ranges;
+      a range with a non-integer bound, such as an index set `1..n`, as
+      `{:range, low, high}`
+    * `arrayNd(index_sets..., [...])` as the flat list of its elements
+    * `[| ... | ... |]` two-dimensional literals as a list of row lists
+    * identifiers used as values (enum members) as strings
   """
 
-  use AbnfParsec,
-    abnf: """
-    file = *(assignment / comment / whitespace)
-
-    assignment = identifier "=" value ";"
-    identifier = ALPHA *(ALPHA / DIGIT / "_")
-    value = integer / array / set / array2d / boolean
-
-    integer = ["-"] 1*DIGIT
-    boolean = "true" / "false"
-    array = "[" *(value ",") [value] "]"
-    set = "{" *(value ",") [value] "}"
-    array2d = "array2d" "(" identifier "," identifier "," array ")"
-
-    comment = ";" *(VCHAR / WSP)
-    whitespace = 1*(SP / HTAB / CRLF)
-
-    ALPHA = %x41-5A / %x61-7A
-    DIGIT = %x30-39
-    VCHAR = %x21-7E
-    SP = %x20
-    HTAB = %x09
-    CRLF = %x0D.0A
-    WSP = SP / HTAB
-    """,
-    parse: :file
+  @chunk_size 65_536
+
+  @type value ::
+          integer()
+          | float()
+          | boolean()
+          | String.t()
+          | nil
+          | Range.t()
+          | {:range, value(), value()}
+          | MapSet.t()
+          | [value()]
 
   @doc """
-  Parses a .dzn file and returns a map of parameters using ABNF grammar.
+  Parses a .dzn file and returns a map of parameters keyed as the
+  aircraft-disassembly domain expects.
   """
   @spec parse_file(String.t()) :: {:ok, map()} | {:error, String.t()}
   def parse_file(path) do
-    case File.read(path) do
-      {:ok, content} ->
-        case parse(content) do
-          {:ok, parsed_result, _, _, _, _} ->
-            params = extract_assignments(parsed_result)
-            # If ABNF parsing didn't extract enough fields, fall back to regex
-            if map_size(params) < 3 do
-              # Fallback to regex-based parsing
-              params = parse_all_fields_regex(content)
-              {:ok, params}
-            else
-              {:ok, post_process_all(params)}
-            end
-
-          {:error, _reason, _, _, _, _} ->
-            # Fallback to regex-based parsing if ABNF parsing fails
-            params = parse_all_fields_regex(content)
-            {:ok, params}
-        end
-
-      {:error, reason} ->
-        {:error, "Failed to read file: #{inspect(reason)}"}
+    with {:ok, assignments} <- decode_file(path) do
+      params = Map.new(assignments, fn {name, value} -> {normalize_key(name), value} end)
+      {:ok, post_process_all(params)}
     end
   end
 
-  # Extract assignments from parsed ABNF result
-  defp extract_assignments(parsed_result) do
-    # The parsed result structure: {:file, [assignment: [...], ...]}
-    case parsed_result do
-      {:file, file_content} when is_list(file_content) ->
-        Enum.reduce(file_content, %{}, fn
-          {:assignment, parts, _}, acc when is_list(parts) ->
-            # Extract identifier and value from assignment parts
-            {id, val} = extract_assignment_parts(parts)
-
-            if id != "" and id != nil do
-              key = normalize_key(id)
-              value = normalize_value(extract_value(val))
-              Map.put(acc, key, value)
-            else
-              acc
-            end
-
-          _, acc ->
-            acc
-        end)
-
-      _ ->
-        %{}
-    end
+  @doc """
+  Decodes every assignment of a .dzn file, keyed by identifier, reading it
+  `chunk_size` bytes at a time.
+  """
+  @spec decode_file(Path.t(), pos_integer()) :: {:ok, %{String.t() => value()}} | {:error, String.t()}
+  def decode_file(path, chunk_size \\ @chunk_size) do
+    {rest, parser} =
+      path
+      |> File.stream!(chunk_size)
+      |> Enum.reduce({<<>>, new_parser()}, fn chunk, {rest, parser} -> lex(rest <> chunk, false, parser) end)
+
+    {<<>>, parser} = lex(rest, true, parser)
+    finish(parser)
+  rescue
+    e in File.Error -> {:error, "Failed to read file: #{inspect(e.reason)}"}
+  catch
+    {:dzn_error, message} -> {:error, message}
   end
 
-  defp extract_assignment_parts(parts) do
-    # Parts structure: [{:identifier, ["n", "A", "c", "t", "s"], _}, "=", {:value, [integer: ["1", "6"]], _}, ";"]
-    id = extract_identifier_from_parts(parts)
-    val = extract_value_from_parts(parts)
-    {id, val}
+  @doc """
+  Decodes every assignment of .dzn content, keyed by identifier.
+  """
+  @spec decode(binary()) :: {:ok, %{String.t() => value()}} | {:error, String.t()}
+  def decode(content) when is_binary(content) do
+    {<<>>, parser} = lex(content, true, new_parser())
+    finish(parser)
+  catch
+    {:dzn_error, message} -> {:error, message}
   end
 
-  defp extract_identifier_from_parts(parts) do
-    case Enum.find(parts, fn
-           {:identifier, _, _} -> true
-           _ -> false
-         end) do
-      {:identifier, chars, _} when is_list(chars) ->
-        List.to_string(chars)
+  # Tokenizer. Returns {unconsumed, parser}; the unconsumed tail is a token
+  # cut off by the end of a chunk and is only non-empty when `final?` is false.
 
-      _ ->
-        nil
+  defp lex(<<c, rest::binary>>, final?, parser) when c in [?\s, ?\t, ?\n, ?\r], do: lex(rest, final?, parser)
+
+  defp lex(<<?%, _::binary>> = bin, final?, parser), do: skip_past(bin, "\n", final?, parser)
+  defp lex(<<"/*", _::binary>> = bin, final?, parser), do: skip_past(bin, "*/", final?, parser)
+
+  # A lone byte that may start a two-byte token
+  defp lex(<<c>> = bin, false, parser) when c in [?., ?[, ?|, ?/, ?<], do: {bin, parser}
+
+  defp lex(<<"<>", rest::binary>>, final?, parser), do: lex(rest, final?, step({:value, nil}, parser))
+  defp lex(<<"..", rest::binary>>, final?, parser), do: lex(rest, final?, step(:range, parser))
+  defp lex(<<"[|", rest::binary>>, final?, parser), do: lex(rest, final?, step(:open_rows, parser))
+  defp lex(<<"|]", rest::binary>>, final?, parser), do: lex(rest, final?, step(:close_rows, parser))
+  defp lex(<<c, rest::binary>>, final?, parser) when c in ~c"=;,[]{}()|", do: lex(rest, final?, step(<<c>>, parser))
+
+  defp lex(<<c, _::binary>> = bin, final?, parser) when c in ?0..?9 or c == ?- do
+    case number(bin, final?) do
+      {value, rest} -> lex(rest, final?, step({:value, value}, parser))
+      :incomplete -> {bin, parser}
     end
   end
 
-  defp extract_value_from_parts(parts) do
-    case Enum.find(parts, fn
-           {:value, _, _} -> true
-           _ -> false
-         end) do
-      {:value, val_content, _} ->
-        val_content
+  defp lex(<<c, _::binary>> = bin, final?, parser) when c in ?a..?z or c in ?A..?Z or c == ?_ do
+    case identifier_length(bin, 0) do
+      length when length == byte_size(bin) and not final? ->
+        {bin, parser}
 
-      _ ->
-        nil
+      length ->
+        <<name::binary-size(length), rest::binary>> = bin
+        lex(rest, final?, step(identifier(name), parser))
     end
   end
 
-  defp extract_value({:integer, digits, _}) when is_list(digits) do
-    digits |> List.to_string() |> String.to_integer()
+  defp lex(<<?", rest::binary>> = bin, final?, parser) do
+    case string(rest, []) do
+      {value, rest} -> lex(rest, final?, step({:value, value}, parser))
+      :incomplete when not final? -> {bin, parser}
+      :incomplete -> throw({:dzn_error, "Unterminated string"})
+    end
   end
 
-  defp extract_value({:boolean, "true", _}), do: true
-  defp extract_value({:boolean, "false", _}), do: false
+  defp lex(<<>>, _final?, parser), do: {<<>>, parser}
+  defp lex(<<c, _::binary>>, _final?, _parser), do: throw({:dzn_error, "Unexpected character #{inspect(<<c>>)}"})
 
-  defp extract_value({:array, values, _}) when is_list(values) do
-    Enum.map(values, &extract_value/1)
+  defp skip_past(bin, terminator, final?, parser) do
+    case :binary.match(bin, terminator) do
+      {position, length} ->
+        skip = position + length
+        lex(binary_part(bin, skip, byte_size(bin) - skip), final?, parser)
+
+      :nomatch when final? ->
+        {<<>>, parser}
+
+      :nomatch ->
+        {bin, parser}
+    end
   end
 
-  defp extract_value([{:integer, _digits, _} | _] = int_list) when is_list(int_list) do
-    # List of integers: [{:integer, ["1"], _}, {:integer, ["6"], _}]
-    Enum.map(int_list, fn {:integer, d, _} -> d |> List.to_string() |> String.to_integer() end)
+  defp number(<<?-, rest::binary>>, final?) do
+    case number(rest, final?) do
+      {value, rest} -> {-value, rest}
+      :incomplete -> :incomplete
+    end
   end
 
-  defp extract_value([{:value, _val_content, _} | _] = val_list) when is_list(val_list) do
-    # List of values
-    Enum.map(val_list, fn {:value, v, _} -> extract_value(v) end)
+  defp number(bin, final?), do: integer(bin, bin, 0, 0, final?)
+
+  defp integer(<<c, rest::binary>>, bin, value, length, final?) when c in ?0..?9,
+    do: integer(rest, bin, value * 10 + c - ?0, length + 1, final?)
+
+  defp integer(<<>>, _bin, _value, _length, false), do: :incomplete
+  defp integer(<<".">>, _bin, _value, _length, false), do: :incomplete
+  defp integer(<<".", c, _::binary>>, bin, _value, length, final?) when c in ?0..?9, do: float(bin, length, final?)
+  defp integer(<<c, _::binary>>, bin, _value, length, final?) when c in [?e, ?E], do: float(bin, length, final?)
+  defp integer(_rest, _bin, _value, 0, _final?), do: throw({:dzn_error, "Expected digits"})
+  defp integer(rest, _bin, value, _length, _final?), do: {value, rest}
+
+  defp float(bin, length, final?) do
+    length = float_length(bin, length)
+
+    if length == byte_size(bin) and not final? do
+      :incomplete
+    else
+      <<literal::binary-size(length), rest::binary>> = bin
+
+      case Float.parse(literal) do
+        {value, ""} -> {value, rest}
+        _ -> throw({:dzn_error, "Malformed float #{inspect(literal)}"})
+      end
+    end
   end
 
-  defp extract_value(val) when is_list(val) do
-    # Try to extract as integer list or process recursively
-    case Enum.all?(val, &is_integer/1) do
-      true ->
-        val
+  defp float_length(bin, length) do
+    case bin do
+      <<_::binary-size(length), c, _::binary>> when c in ?0..?9 or c in [?., ?e, ?E, ?+, ?-] ->
+        float_length(bin, length + 1)
+
+      _ ->
+        length
+    end
+  end
 
-      false ->
-        # Check if it's a list of character lists (string)
-        all_binary = fn item -> is_list(item) and Enum.all?(item, fn x -> is_binary(x) end) end
+  defp identifier_length(bin, length) do
+    case bin do
+      <<_::binary-size(length), c, _::binary>> when c in ?a..?z or c in ?A..?Z or c in ?0..?9 or c == ?_ ->
+        identifier_length(bin, length + 1)
 
-        case Enum.all?(val, all_binary) do
-          true -> Enum.map(val, &List.to_string/1)
-          false -> Enum.map(val, &extract_value/1)
-        end
+      _ ->
+        length
     end
   end
 
-  defp extract_value(val), do: val
+  defp identifier("true"), do: {:value, true}
+  defp identifier("false"), do: {:value, false}
+  # Copied so the name does not keep the whole chunk alive
+  defp identifier(name), do: {:identifier, :binary.copy(name)}
 
-  # Fallback regex-based parsing functions
-  defp parse_dzn_int(content, key, params, param_key) do
-    regex = ~r/#{key}\s*=\s*(\d+);/
+  defp string(<<?", rest::binary>>, acc), do: {IO.iodata_to_binary(Enum.reverse(acc)), rest}
+  defp string(<<?\\, c, rest::binary>>, acc), do: string(rest, [unescape(c) | acc])
+  defp string(<<c, rest::binary>>, acc) when c != ?\\, do: string(rest, [c | acc])
+  defp string(_incomplete, _acc), do: :incomplete
 
-    case Regex.run(regex, content) do
-      [_, value] ->
-        Map.put(params, param_key, String.to_integer(value))
+  defp unescape(?n), do: ?\n
+  defp unescape(?t), do: ?\t
+  defp unescape(c), do: c
 
-      nil ->
-        params
+  # Push-down builder. `pending` holds the value just completed until a
+  # separator or closing bracket says where it belongs; `:none` when empty.
+
+  defp new_parser, do: %{stack: [], pending: :none, assignments: %{}}
+
+  defp step({:identifier, name}, %{stack: [], pending: :none} = parser), do: %{parser | stack: [{:name, name}]}
+  defp step("=", %{stack: [{:name, name}]} = parser), do: %{parser | stack: [{:assign, name}]}
+  defp step(";", %{stack: [{:assign, _name}]} = parser) when parser.pending != :none, do: assign(parser)
+
+  defp step({:value, value}, parser), do: complete(value, parser)
+  defp step({:identifier, name}, parser), do: complete({:identifier, name}, parser)
+
+  defp step("(", %{pending: {:identifier, name}} = parser),
+    do: %{parser | stack: [{:call, name, []} | parser.stack], pending: :none}
+
+  defp step("[", parser), do: open({:array, []}, parser)
+  defp step("{", parser), do: open({:set, []}, parser)
+  defp step(:open_rows, parser), do: open({:rows, [], []}, parser)
+
+  defp step(:range, %{pending: {:identifier, _name} = value} = parser), do: %{parser | pending: {:range_from, value}}
+
+  defp step(:range, %{pending: value} = parser) when is_number(value), do: %{parser | pending: {:range_from, value}}
+
+  defp step(",", parser), do: flush(parser)
+
+  defp step("|", parser) do
+    case flush(parser) do
+      %{stack: [{:rows, row, rows} | stack]} = parser -> %{parser | stack: [{:rows, [], end_row(row, rows)} | stack]}
+      _ -> unexpected("|")
     end
   end
 
-  defp parse_dzn_array(content, key, params, param_key) do
-    regex = ~r/#{key}\s*=\s*\[([^\]]+)\];/
+  defp step(token, parser) do
+    case {token, flush(parser)} do
+      {"]", %{stack: [{:array, items} | stack]} = parser} ->
+        complete(Enum.reverse(items), %{parser | stack: stack})
 
-    case Regex.run(regex, content) do
-      [_, values] ->
-        array_values =
-          values
-          |> String.split(",")
-          |> Enum.map(&String.trim/1)
-          |> Enum.map(&String.to_integer/1)
+      {"}", %{stack: [{:set, items} | stack]} = parser} ->
+        complete(items |> Enum.flat_map(&set_members/1) |> MapSet.new(), %{parser | stack: stack})
 
-        Map.put(params, param_key, array_values)
+      {")", %{stack: [{:call, name, args} | stack]} = parser} ->
+        complete(call(name, Enum.reverse(args)), %{parser | stack: stack})
 
-      nil ->
-        params
+      {:close_rows, %{stack: [{:rows, row, rows} | stack]} = parser} ->
+        complete(Enum.reverse(end_row(row, rows)), %{parser | stack: stack})
+
+      _ ->
+        unexpected(token)
     end
   end
 
-  defp parse_dzn_precedence(content, params) do
-    # Parse pred and succ arrays
-    pred_regex = ~r/pred\s*=\s*\[([^\]]*)\];/
-    succ_regex = ~r/succ\s*=\s*\[([^\]]*)\];/
-
-    pred_list =
-      case Regex.run(pred_regex, content) do
-        [_, values] when values != "" ->
-          values
-          |> String.split(",")
-          |> Enum.map(&String.trim/1)
-          |> Enum.map(&String.to_integer/1)
-
-        _ ->
-          []
-      end
+  defp open(frame, %{stack: [top | _], pending: :none} = parser) when elem(top, 0) != :name,
+    do: %{parser | stack: [frame | parser.stack]}
+
+  defp open(_frame, _parser), do: unexpected("opening bracket")
+
+  defp complete(value, %{pending: :none} = parser), do: %{parser | pending: value}
+
+  defp complete(high, %{pending: {:range_from, low}} = parser) when is_integer(low) and is_integer(high),
+    do: %{parser | pending: low..high//1}
 
-    succ_list =
-      case Regex.run(succ_regex, content) do
-        [_, values] when values != "" ->
-          values
-          |> String.split(",")
-          |> Enum.map(&String.trim/1)
-          |> Enum.map(&String.to_integer/1)
+  defp complete(high, %{pending: {:range_from, low}} = parser),
+    do: %{parser | pending: {:range, finish_value(low), finish_value(high)}}
 
-        _ ->
-          []
+  defp complete(value, _parser), do: unexpected(value)
+
+  defp flush(%{pending: :none} = parser), do: parser
+
+  defp flush(%{stack: [frame | stack], pending: value} = parser)
+       when elem(frame, 0) in [:array, :set, :call, :rows] do
+    value = finish_value(value)
+
+    frame =
+      case frame do
+        {:rows, row, rows} -> {:rows, [value | row], rows}
+        {kind, name, args} -> {kind, name, [value | args]}
+        {kind, items} -> {kind, [value | items]}
       end
 
-    # Create precedence pairs
-    precedences = Enum.zip(pred_list, succ_list)
+    %{parser | stack: [frame | stack], pending: :none}
+  end
+
+  defp flush(%{pending: value}), do: unexpected(value)
+
+  defp finish_value({:identifier, name}), do: name
+  defp finish_value({:range_from, _low}), do: unexpected("..")
+  defp finish_value(value), do: value
 
-    Map.put(params, :precedences, precedences)
+  defp end_row([], rows), do: rows
+  defp end_row(row, rows), do: [Enum.reverse(row) | rows]
+
+  defp set_members(%Range{} = range), do: range
+  defp set_members(member), do: [member]
+
+  # arrayNd(index_set, ..., elements)
+  defp call("array" <> _dimensions, [_ | _] = args), do: List.last(args)
+  defp call(name, _args), do: throw({:dzn_error, "Unsupported function #{name}"})
+
+  defp assign(%{stack: [{:assign, name}], pending: value} = parser) do
+    %{parser | stack: [], pending: :none, assignments: Map.put(parser.assignments, name, finish_value(value))}
   end
 
+  # The last assignment's semicolon is optional
+  defp finish(%{stack: [{:assign, _name}]} = parser) when parser.pending != :none, do: finish(assign(parser))
+  defp finish(%{stack: [], pending: :none, assignments: assignments}), do: {:ok, assignments}
+  defp finish(_parser), do: {:error, "Unexpected end of input"}
+
+  defp unexpected(token), do: throw({:dzn_error, "Unexpected #{inspect(token)}"})
+
   # Normalize keys (e.g., "nActs" -> :num_activities)
   defp normalize_key("nActs"), do: :num_activities
   defp normalize_key("nResources"), do: :num_resources
-  defp normalize_key("nPrecs"), do: :nPrecs
-  defp normalize_key("nLocations"), do: :nLocations
   defp normalize_key("dur"), do: :durations
   defp normalize_key("loc"), do: :locations
   defp normalize_key("loc_cap"), do: :location_capacities
-  defp normalize_key("pred"), do: :pred
-  defp normalize_key("succ"), do: :succ
-  defp normalize_key(key) when is_binary(key), do: String.to_atom(key)
-  defp normalize_key(key), do: key
-
-  # Normalize values (convert strings to appropriate types)
-  defp normalize_value("true"), do: true
-  defp normalize_value("false"), do: false
-
-  defp normalize_value(value) when is_binary(value) do
-    case Integer.parse(value) do
-      {int, ""} -> int
-      _ -> value
-    end
-  end
-
-  defp normalize_value(value) when is_list(value) do
-    Enum.map(value, &normalize_value/1)
-  end
-
-  defp normalize_value(value), do: value
+  defp normalize_key("USEFUL_RES"), do: :useful_res
+  defp normalize_key("POTENTIAL_ACT"), do: :potential_act
+  defp normalize_key(key), do: String.to_atom(key)
 
   # Post-process to create precedence pairs and handle all fields
   defp post_process_all(params) do
     params
     |> post_process_precedence()
     |> post_process_unrelated()
-    |> post_process_array2d()
   end
 
   defp post_process_precedence(params) do
@@ -296,180 +361,4 @@ defmodule AriaPlanner.Domains.AircraftDisassembly.DznParser do
         Map.put(params, :unrelated, [])
     end
   end
-
-  defp post_process_array2d(params) do
-    # Handle array2d fields that need special processing
-    # For now, just return params as-is (array2d parsing handled in regex fallback)
-    params
-  end
-
-  # Comprehensive regex-based parsing for all fields
-  defp parse_all_fields_regex(content) do
-    params = %{}
-    # Basic counts
-    params = parse_dzn_int(content, "nActs", params, :num_activities)
-    params = parse_dzn_int(content, "nResources", params, :num_resources)
-    params = parse_dzn_int(content, "nSkills", params, :nSkills)
-    params = parse_dzn_int(content, "nPrecs", params, :nPrecs)
-    params = parse_dzn_int(content, "nUnavailable", params, :nUnavailable)
-    params = parse_dzn_int(content, "nUnrels", params, :nUnrels)
-    params = parse_dzn_int(content, "nLocations", params, :nLocations)
-    params = parse_dzn_int(content, "maxt", params, :maxt)
-
-    # Arrays
-    params = parse_dzn_array(content, "dur", params, :durations)
-    params = parse_dzn_array(content, "loc", params, :locations)
-    params = parse_dzn_array(content, "loc_cap", params, :location_capacities)
-    params = parse_dzn_array(content, "mass", params, :mass)
-    params = parse_dzn_array(content, "maxDiff", params, :maxDiff)
-    params = parse_dzn_array(content, "occupancy", params, :occupancy)
-    params = parse_dzn_array(content, "resource_cost", params, :resource_cost)
-    params = parse_dzn_array(content, "unavailable_resource", params, :unavailable_resource)
-    params = parse_dzn_array(content, "unavailable_start", params, :unavailable_start)
-    params = parse_dzn_array(content, "unavailable_end", params, :unavailable_end)
-
-    # Precedence
-    params = parse_dzn_precedence(content, params)
-
-    # Unrelated activities
-    params = parse_dzn_unrelated(content, params)
-
-    # Sets and complex arrays
-    params = parse_dzn_set_array(content, "USEFUL_RES", params, :useful_res)
-    params = parse_dzn_set_array(content, "POTENTIAL_ACT", params, :potential_act)
-    params = parse_dzn_set(content, "M", params, :M)
-
-    # Array2D fields
-    params = parse_dzn_array2d(content, "sreq", params, :sreq, "ACT", "SKILL")
-    params = parse_dzn_array2d(content, "mastery", params, :mastery, "RESOURCE", "SKILL")
-    params = parse_dzn_array2d(content, "comp_prod", params, :comp_prod, "M", "1..2")
-
-    params
-  end
-
-  defp parse_dzn_unrelated(content, params) do
-    unpred_regex = ~r/unpred\s*=\s*\[([^\]]*)\];/
-    unsucc_regex = ~r/unsucc\s*=\s*\[([^\]]*)\];/
-
-    unpred_list =
-      case Regex.run(unpred_regex, content) do
-        [_, values] when values != "" ->
-          values
-          |> String.split(",")
-          |> Enum.map(&String.trim/1)
-          |> Enum.map(&String.to_integer/1)
-
-        _ ->
-          []
-      end
-
-    unsucc_list =
-      case Regex.run(unsucc_regex, content) do
-        [_, values] when values != "" ->
-          values
-          |> String.split(",")
-          |> Enum.map(&String.trim/1)
-          |> Enum.map(&String.to_integer/1)
-
-        _ ->
-          []
-      end
-
-    unrelated = Enum.zip(unpred_list, unsucc_list)
-    Map.put(params, :unrelated, unrelated)
-  end
-
-  defp parse_dzn_set_array(content, key, params, param_key) do
-    # Parse array of sets like: USEFUL_RES=[{1,2,3}, {4,5}]
-    regex = ~r/#{key}\s*=\s*\[([^\]]+)\];/
-
-    case Regex.run(regex, content) do
-      [_, values] ->
-        # Parse sets within array: {1,2,3}, {4,5}
-        sets =
-          values
-          |> String.split("}, {")
-          |> Enum.map(fn set_str ->
-            set_str
-            |> String.replace("{", "")
-            |> String.replace("}", "")
-            |> String.split(",")
-            |> Enum.map(&String.trim/1)
-            |> Enum.map(&String.to_integer/1)
-            |> MapSet.new()
-          end)
-
-        Map.put(params, param_key, sets)
-
-      nil ->
-        params
-    end
-  end
-
-  defp parse_dzn_set(content, key, params, param_key) do
-    # Parse set like: M = {1, 2}
-    regex = ~r/#{key}\s*=\s*\{([^}]+)\};/
-
-    case Regex.run(regex, content) do
-      [_, values] ->
-        set =
-          values
-          |> String.split(",")
-          |> Enum.map(&String.trim/1)
-          |> Enum.map(&String.to_integer/1)
-          |> MapSet.new()
-
-        Map.put(params, param_key, set)
-
-      nil ->
-        params
-    end
-  end
-
-  defp parse_dzn_array2d(content, key, params, param_key, _dim1, _dim2) do
-    # Parse array2d like: sreq=array2d(ACT, SKILL, [1,1,0,1,1,0,...])
-    # More flexible regex to handle nested structures
-    regex = ~r/#{key}\s*=\s*array2d\s*\([^,]+,\s*[^,]+,\s*\[([^\]]+)\]\s*\)/
-
-    case Regex.run(regex, content) do
-      [_, values] ->
-        # Handle values that might contain nested structures or just simple values
-        array_values =
-          values
-          |> String.split(",")
-          |> Enum.map(&String.trim/1)
-          |> Enum.reject(&(&1 == ""))
-          |> Enum.map(fn val ->
-            val_trimmed = String.trim(val)
-
-            case val_trimmed do
-              "true" ->
-                true
-
-              "false" ->
-                false
-
-              "" ->
-                nil
-
-              _ ->
-                # Try to parse as integer, if it fails, skip it
-                case Integer.parse(val_trimmed) do
-                  {int, ""} -> int
-                  _ -> nil
-                end
-            end
-          end)
-          |> Enum.reject(&is_nil/1)
-
-        if length(array_values) > 0 do
-          Map.put(params, param_key, array_values)
-        else
-          params
-        end
-
-      nil ->
-        params
-    end
-  end
 end
@@ -13,15 +13,11 @@ defmodule AriaPlanner.Domains.AircraftDisassembly.Multigoals.ScheduleActivities
   @spec m_schedule_activities(state :: map()) :: [tuple()]
   def m_schedule_activities(state) do
     # Return goals for all activities to be completed
-    # Use activity_id format for planner's state facts
+    # Activity status facts are keyed by activity number
     num_activities = Map.get(state, :num_activities, 0)
 
-    goals =
-      for activity <- 1..num_activities do
-        activity_id = "activity_#{activity}"
-        {"activity_status", [activity_id, "completed"]}
-      end
-
-    goals
+    for activity <- 1..num_activities//1 do
+      {"activity_status", [activity, "completed"]}
+    end
   end
 end
@@ -0,0 +1,67 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2025-present K. S. Ernest (iFire) Lee
+
+defmodule AriaPlanner.Domains.AircraftDisassembly.PlannerSpec do
+  @moduledoc """
+  Aircraft-disassembly domain wired for `AriaCore.Planner.LazyRefinement`.
+
+  Activities run one after another: `c_start_activity` starts an activity at
+  the domain's current hour, completes it once its duration has elapsed and
+  advances the domain clock by that many hours.
+  """
+
+  alias AriaCore.Planner.{Actions, Methods}
+  alias AriaPlanner.Domains.AircraftDisassembly.ActivityModel
+  alias AriaPlanner.Domains.AircraftDisassembly.Commands.{CompleteActivity, StartActivity}
+  alias AriaPlanner.Domains.AircraftDisassembly.StateHelpers
+  alias AriaPlanner.Domains.AircraftDisassembly.Tasks.ScheduleActivities
+  alias AriaPlanner.Domains.PlannerAdapter
+
+  @hour_ms 3_600_000
+  # Hour 0 of the instance, the same reference StartActivity uses for unavailability periods
+  @epoch ~U[2025-01-01 00:00:00Z]
+
+  @doc """
+  Returns the `domain_spec` for `LazyRefinement.run_lazy_refineahead/4`. The
+  scheduling index is declared derived, so it stays out of the fingerprint.
+  """
+  @spec domain_spec(map()) :: %{
+          methods: Methods.t(),
+          actions: Actions.t(),
+          initial_tasks: list(),
+          derived_facts: [atom()]
+        }
+  def domain_spec(domain_state) do
+    methods =
+      Methods.new()
+      |> Methods.add_task_method("t_schedule_activities", [&schedule_activities/2])
+
+    actions =
+      Actions.new()
+      |> Actions.add_action("c_start_activity", &start_activity/4)
+
+    %{
+      methods: methods,
+      actions: actions,
+      initial_tasks: [{"t_schedule_activities", domain_state}],
+      derived_facts: StateHelpers.derived_keys()
+    }
+  end
+
+  # The task carries the state it was generated from; refinement uses the current one
+  defp schedule_activities(state, _snapshot), do: ScheduleActivities.t_schedule_activities(state.facts)
+
+  defp start_activity(state, activity, hour, assigned_resources) do
+    duration = state.facts |> ActivityModel.of() |> ActivityModel.duration(activity)
+    start_time = @epoch |> DateTime.add(hour * 3600, :second) |> DateTime.to_iso8601()
+
+    result =
+      with {:ok, started, _metadata} <-
+             StartActivity.c_start_activity(state.facts, activity, start_time, assigned_resources),
+           {:ok, completed, _metadata} <- CompleteActivity.c_complete_activity(started, activity) do
+        {:ok, %{completed | current_time: hour + duration}}
+      end
+
+    PlannerAdapter.commit(state, result, duration * @hour_ms)
+  end
+end
@@ -4,10 +4,31 @@
 defmodule AriaPlanner.Domains.AircraftDisassembly.StateHelpers do
   @moduledoc """
   Helper functions for working with aircraft disassembly state.
+
+  Activity status facts are keyed by activity number. Status changes made
+  through `put_activity_status/3` also maintain a scheduling index on the
+  state, so that selecting the next activity never rescans the instance:
+
+    * `:in_degree` - number of uncompleted predecessors per activity
+    * `:ready` - `:gb_sets` of not-started activities whose predecessors are
+      all completed, released when their last predecessor completes
+    * `:location_load` - occupancy of the in-progress activities per location
+    * `:remaining_activities` - number of activities not yet completed
+
+  Activities started through `book_activity/4` are also booked on shared
+  `Timeline`s, so capacity checks query time ranges instead of scanning
+  the other activities:
+
+    * `:location_timeline` - occupancy booked per location
+    * `:resource_timeline` - bookings per resource; a resource is free over
+      a range when nothing is booked on it there
   """
 
+  import Bitwise, only: [&&&: 2, <<<: 2, bxor: 2]
+
+  alias AriaPlanner.Domains.AircraftDisassembly.{ActivityModel, Timeline}
+
   @type state :: map()
-  @type activity_id :: String.t()
   @type activity :: non_neg_integer()
   @type status :: String.t()
 
@@ -16,24 +37,19 @@ defmodule AriaPlanner.Domains.AircraftDisassembly.StateHelpers do
   """
   @spec all_activities_completed?(state()) :: boolean()
   def all_activities_completed?(state) do
-    num_activities = Map.get(state, :num_activities, 0)
-
-    Enum.all?(1..num_activities, fn activity ->
-      activity_id = "activity_#{activity}"
-      get_activity_status(state, activity_id) == "completed"
-    end)
+    with_schedule(state).remaining_activities == 0
   end
 
   @doc """
   Gets the status of an activity.
   """
-  @spec get_activity_status(state(), activity_id()) :: status()
-  def get_activity_status(state, activity_id) do
+  @spec get_activity_status(state(), activity()) :: status()
+  def get_activity_status(state, activity) do
     case Map.get(state, :facts, %{}) do
       facts when is_map(facts) ->
         case Map.get(facts, "activity_status", %{}) do
           status_map when is_map(status_map) ->
-            Map.get(status_map, activity_id, "not_started")
+            Map.get(status_map, activity, "not_started")
 
           _ ->
             "not_started"
@@ -41,24 +57,192 @@ defmodule AriaPlanner.Domains.AircraftDisassembly.StateHelpers do
 
       _ ->
         # Fallback to old state structure
-        Map.get(
-          state.activity_status || %{},
-          String.to_integer(String.replace(activity_id, "activity_", "")),
-          "not_started"
-        )
+        Map.get(state.activity_status || %{}, activity, "not_started")
+    end
+  end
+
+  @doc """
+  Sets the status of an activity.
+  """
+  @spec put_activity_status(state(), activity(), status()) :: state()
+  def put_activity_status(state, activity, status) do
+    previous = get_activity_status(state, activity)
+    state = with_schedule(state)
+    facts = Map.get(state, :facts, %{})
+    activity_status_facts = Map.get(facts, "activity_status", %{})
+    updated_facts = Map.put(facts, "activity_status", Map.put(activity_status_facts, activity, status))
+
+    state
+    |> Map.put(:facts, updated_facts)
+    |> reschedule(ActivityModel.of(state), activity, previous, status)
+  end
+
+  @doc """
+  Returns the keys of the scheduling index added by `with_schedule/1`, all
+  kept alongside the activity statuses to speed up scheduling.
+  """
+  @spec derived_keys() :: [atom()]
+  def derived_keys,
+    do: [:in_degree, :ready, :location_load, :remaining_activities, :location_timeline, :resource_timeline]
+
+  @doc """
+  Returns the state with its scheduling index, building it from the activity
+  statuses when the state does not carry one yet.
+  """
+  @spec with_schedule(state()) :: state()
+  def with_schedule(%{ready: _} = state), do: state
+
+  def with_schedule(state) do
+    model = ActivityModel.of(state)
+    activities = Enum.to_list(1..model.num_activities//1)
+    statuses = Map.new(activities, &{&1, get_activity_status(state, &1)})
+
+    in_degree =
+      Map.new(activities, fn activity ->
+        {activity, Enum.count(ActivityModel.predecessors(model, activity), &(statuses[&1] != "completed"))}
+      end)
+
+    ready = for activity <- activities, statuses[activity] == "not_started", in_degree[activity] == 0, do: activity
+
+    # Activities started without booking have no known time range
+    state =
+      Map.merge(state, %{
+        in_degree: in_degree,
+        ready: :gb_sets.from_list(ready),
+        location_load: %{},
+        remaining_activities: Enum.count(statuses, fn {_activity, status} -> status != "completed" end),
+        location_timeline: %{},
+        resource_timeline: %{}
+      })
+
+    for {activity, "in_progress"} <- statuses, reduce: state do
+      state -> add_load(state, model, activity, 1)
+    end
+  end
+
+  @doc """
+  Occupancy of the activities in progress at `location`.
+  """
+  @spec location_load(state(), pos_integer()) :: non_neg_integer()
+  def location_load(state, location), do: Map.get(with_schedule(state).location_load, location, 0)
+
+  @doc """
+  Books `activity` over `[from, from + duration)`: its occupancy at its
+  location and one unit on each of `resources`.
+  """
+  @spec book_activity(state(), activity(), non_neg_integer(), [pos_integer()]) :: state()
+  def book_activity(state, activity, from, resources) do
+    state = with_schedule(state)
+    model = ActivityModel.of(state)
+    to = from + ActivityModel.duration(model, activity)
+    empty = Timeline.new(Map.get(state, :maxt, 1024))
+
+    location_timeline =
+      Map.update(
+        state.location_timeline,
+        ActivityModel.location(model, activity),
+        Timeline.add(empty, from, to, ActivityModel.occupancy(model, activity)),
+        &Timeline.add(&1, from, to, ActivityModel.occupancy(model, activity))
+      )
+
+    resource_timeline =
+      Enum.reduce(resources, state.resource_timeline, fn resource, timelines ->
+        Map.update(timelines, resource, Timeline.add(empty, from, to, 1), &Timeline.add(&1, from, to, 1))
+      end)
+
+    %{state | location_timeline: location_timeline, resource_timeline: resource_timeline}
+  end
+
+  @doc """
+  Largest occupancy booked at `location` at any instant of `[from, to)`.
+  """
+  @spec location_peak(state(), pos_integer(), non_neg_integer(), non_neg_integer()) :: non_neg_integer()
+  def location_peak(state, location, from, to) do
+    case with_schedule(state).location_timeline do
+      %{^location => timeline} -> Timeline.peak(timeline, from, to)
+      _ -> 0
     end
   end
 
+  @doc """
+  The members of the resource bitset `candidates` with nothing booked over
+  `[from, to)`.
+  """
+  @spec free_resources(state(), ActivityModel.bitset(), non_neg_integer(), non_neg_integer()) ::
+          ActivityModel.bitset()
+  def free_resources(state, candidates, from, to) do
+    timelines = with_schedule(state).resource_timeline
+
+    Enum.reduce(timelines, candidates, fn {resource, timeline}, free ->
+      bit = 1 <<< (resource - 1)
+
+      if (free &&& bit) != 0 and Timeline.peak(timeline, from, to) > 0,
+        do: bxor(free, bit),
+        else: free
+    end)
+  end
+
+  defp reschedule(state, _model, _activity, status, status), do: state
+
+  defp reschedule(state, model, activity, previous, status) do
+    state
+    |> leave(model, activity, previous)
+    |> enter(model, activity, status)
+  end
+
+  defp leave(state, _model, activity, "not_started"), do: %{state | ready: :gb_sets.del_element(activity, state.ready)}
+  defp leave(state, model, activity, "in_progress"), do: add_load(state, model, activity, -1)
+
+  defp leave(state, model, activity, "completed") do
+    state = %{state | remaining_activities: state.remaining_activities + 1}
+
+    Enum.reduce(ActivityModel.successors(model, activity), state, fn successor, state ->
+      %{
+        state
+        | in_degree: Map.update(state.in_degree, successor, 1, &(&1 + 1)),
+          ready: :gb_sets.del_element(successor, state.ready)
+      }
+    end)
+  end
+
+  defp leave(state, _model, _activity, _status), do: state
+
+  defp enter(state, _model, activity, "not_started") do
+    if Map.get(state.in_degree, activity, 0) == 0,
+      do: %{state | ready: :gb_sets.add_element(activity, state.ready)},
+      else: state
+  end
+
+  defp enter(state, model, activity, "in_progress"), do: add_load(state, model, activity, 1)
+
+  defp enter(state, model, activity, "completed") do
+    state = %{state | remaining_activities: state.remaining_activities - 1}
+
+    # Release the successors whose last predecessor this was
+    Enum.reduce(ActivityModel.successors(model, activity), state, fn successor, state ->
+      in_degree = Map.get(state.in_degree, successor, 1) - 1
+      state = %{state | in_degree: Map.put(state.in_degree, successor, in_degree)}
+
+      if in_degree == 0 and get_activity_status(state, successor) == "not_started",
+        do: %{state | ready: :gb_sets.add_element(successor, state.ready)},
+        else: state
+    end)
+  end
+
+  defp enter(state, _model, _activity, _status), do: state
+
+  defp add_load(state, model, activity, sign) do
+    occupancy = sign * ActivityModel.occupancy(model, activity)
+    location = ActivityModel.location(model, activity)
+    %{state | location_load: Map.update(state.location_load, location, occupancy, &(&1 + occupancy))}
+  end
+
   @doc """
   Gets all predecessors of an activity.
   """
   @spec get_predecessors(state(), activity()) :: [activity()]
   def get_predecessors(state, activity) do
-    precedences = Map.get(state, :precedences, [])
-
-    precedences
-    |> Enum.filter(fn {_pred, succ} -> succ == activity end)
-    |> Enum.map(fn {pred, _succ} -> pred end)
+    state |> ActivityModel.of() |> ActivityModel.predecessors(activity)
   end
 
   @doc """
@@ -66,11 +250,7 @@ defmodule AriaPlanner.Domains.AircraftDisassembly.StateHelpers do
   """
   @spec get_successors(state(), activity()) :: [activity()]
   def get_successors(state, activity) do
-    precedences = Map.get(state, :precedences, [])
-
-    precedences
-    |> Enum.filter(fn {pred, _succ} -> pred == activity end)
-    |> Enum.map(fn {_pred, succ} -> succ end)
+    state |> ActivityModel.of() |> ActivityModel.successors(activity)
   end
 
   @doc """
@@ -78,11 +258,6 @@ defmodule AriaPlanner.Domains.AircraftDisassembly.StateHelpers do
   """
   @spec all_predecessors_completed?(state(), activity()) :: boolean()
   def all_predecessors_completed?(state, activity) do
-    predecessors = get_predecessors(state, activity)
-
-    Enum.all?(predecessors, fn pred ->
-      pred_id = "activity_#{pred}"
-      get_activity_status(state, pred_id) == "completed"
-    end)
+    Map.get(with_schedule(state).in_degree, activity, 0) == 0
   end
 end
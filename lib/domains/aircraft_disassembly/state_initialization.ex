@@ -4,8 +4,14 @@
 defmodule AriaPlanner.Domains.AircraftDisassembly.StateInitialization do
   @moduledoc """
   Handles state initialization for the aircraft disassembly domain.
+
+  Besides the instance parameters, the state carries an `ActivityModel`
+  under `:model` for constant-time lookups, activity status facts keyed by
+  activity number and the scheduling index described in `StateHelpers`.
   """
 
+  alias AriaPlanner.Domains.AircraftDisassembly.{ActivityModel, StateHelpers}
+
   @type params :: %{
           optional(:num_activities) => non_neg_integer(),
           optional(:nActs) => non_neg_integer(),
@@ -92,6 +98,7 @@ defmodule AriaPlanner.Domains.AircraftDisassembly.StateInitialization do
           num_resources: num_resources,
           locations: locations,
           num_locations: length(location_capacities),
+          location_capacities: location_capacities,
           facts: facts,
           precedence: precedence,
           resource_assigned: resource_assigned,
@@ -117,7 +124,8 @@ defmodule AriaPlanner.Domains.AircraftDisassembly.StateInitialization do
         |> maybe_put(:unrelated, unrelated)
         |> maybe_put(:occupancy, occupancy)
 
-      {:ok, state}
+      state = Map.put(state, :model, ActivityModel.new(state))
+      {:ok, StateHelpers.with_schedule(state)}
     rescue
       e ->
         error_msg =
@@ -240,12 +248,9 @@ defmodule AriaPlanner.Domains.AircraftDisassembly.StateInitialization do
     end
   end
 
-  @spec build_activity_status_facts(non_neg_integer()) :: %{String.t() => String.t()}
+  @spec build_activity_status_facts(non_neg_integer()) :: %{pos_integer() => String.t()}
   defp build_activity_status_facts(num_activities) when num_activities > 0 do
-    for activity <- 1..num_activities, into: %{} do
-      activity_id = "activity_#{activity}"
-      {activity_id, "not_started"}
-    end
+    for activity <- 1..num_activities, into: %{}, do: {activity, "not_started"}
   end
 
   defp build_activity_status_facts(_), do: %{}
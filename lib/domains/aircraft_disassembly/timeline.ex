@@ -0,0 +1,81 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2025-present K. S. Ernest (iFire) Lee
+
+defmodule AriaPlanner.Domains.AircraftDisassembly.Timeline do
+  @moduledoc """
+  Cumulative occupancy over integer time, as a persistent sparse segment
+  tree.
+
+  `add/4` books an amount over `[from, to)` and `peak/3` returns the largest
+  cumulative amount booked at any instant of `[from, to)`, both in
+  O(log horizon). Nodes are only allocated for booked ranges, and the
+  horizon doubles when a booking reaches past it.
+  """
+
+  @type tree :: nil | {max :: integer(), add :: integer(), left :: tree(), right :: tree()}
+
+  @type t :: %__MODULE__{size: pos_integer(), root: tree()}
+
+  defstruct size: 1024, root: nil
+
+  @doc """
+  Creates an empty timeline covering at least `[0, horizon)`.
+  """
+  @spec new(pos_integer()) :: t()
+  def new(horizon \\ 1024), do: %__MODULE__{size: grow_size(1, horizon)}
+
+  @doc """
+  Adds `amount` to every instant of `[from, to)`.
+  """
+  @spec add(t(), non_neg_integer(), non_neg_integer(), integer()) :: t()
+  def add(%__MODULE__{} = timeline, from, to, _amount) when from >= to, do: timeline
+
+  def add(%__MODULE__{size: size} = timeline, from, to, amount) when to > size,
+    do: timeline |> grow(grow_size(size, to)) |> add(from, to, amount)
+
+  def add(%__MODULE__{size: size, root: root} = timeline, from, to, amount),
+    do: %{timeline | root: add(root, 0, size, from, to, amount)}
+
+  @doc """
+  Largest cumulative amount booked at any instant of `[from, to)`; `0` for
+  an empty range.
+  """
+  @spec peak(t(), non_neg_integer(), non_neg_integer()) :: integer()
+  def peak(%__MODULE__{size: size, root: root}, from, to) when from < to, do: peak(root, 0, size, from, min(to, size))
+  def peak(%__MODULE__{}, _from, _to), do: 0
+
+  defp add(node, low, high, from, to, _amount) when to <= low or high <= from, do: node
+
+  defp add(nil, low, high, from, to, amount) when from <= low and high <= to, do: {amount, amount, nil, nil}
+
+  defp add({max, add, left, right}, low, high, from, to, amount) when from <= low and high <= to,
+    do: {max + amount, add + amount, left, right}
+
+  defp add(node, low, high, from, to, amount) do
+    {_max, add, left, right} = node || {0, 0, nil, nil}
+    mid = div(low + high, 2)
+    left = add(left, low, mid, from, to, amount)
+    right = add(right, mid, high, from, to, amount)
+    {add + max(node_max(left), node_max(right)), add, left, right}
+  end
+
+  defp peak(_node, low, high, from, to) when to <= low or high <= from, do: 0
+  defp peak(nil, _low, _high, _from, _to), do: 0
+  defp peak({max, _add, _left, _right}, low, high, from, to) when from <= low and high <= to, do: max
+
+  defp peak({_max, add, left, right}, low, high, from, to) do
+    mid = div(low + high, 2)
+    add + max(peak(left, low, mid, from, to), peak(right, mid, high, from, to))
+  end
+
+  defp node_max(nil), do: 0
+  defp node_max({max, _add, _left, _right}), do: max
+
+  defp grow(%__MODULE__{size: size} = timeline, size), do: timeline
+
+  defp grow(%__MODULE__{size: size, root: root} = timeline, target),
+    do: grow(%{timeline | size: size * 2, root: root && {node_max(root), 0, root, nil}}, target)
+
+  defp grow_size(size, horizon) when size >= horizon, do: size
+  defp grow_size(size, horizon), do: grow_size(size * 2, horizon)
+end
@@ -0,0 +1,45 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2025-present K. S. Ernest (iFire) Lee
+
+defmodule AriaPlanner.Domains.FoxGeeseCorn.PlannerSpec do
+  @moduledoc """
+  Fox-Geese-Corn domain wired for `AriaCore.Planner.LazyRefinement`.
+
+  Every crossing takes one time unit.
+  """
+
+  alias AriaCore.Planner.{Actions, Methods}
+  alias AriaPlanner.Domains.FoxGeeseCorn.Commands.{CrossEast, CrossWest}
+  alias AriaPlanner.Domains.FoxGeeseCorn.Tasks.TransportAll
+  alias AriaPlanner.Domains.PlannerAdapter
+
+  @crossing_duration 1
+
+  @doc """
+  Returns the `domain_spec` for `LazyRefinement.run_lazy_refineahead/4`.
+  """
+  @spec domain_spec(map()) :: %{methods: Methods.t(), actions: Actions.t(), initial_tasks: list()}
+  def domain_spec(domain_state) do
+    methods =
+      Methods.new()
+      |> Methods.add_task_method("t_transport_all", [&transport_all/2])
+
+    actions =
+      Actions.new()
+      |> Actions.add_action("c_cross_east", &cross_east/4)
+      |> Actions.add_action("c_cross_west", &cross_west/4)
+
+    %{methods: methods, actions: actions, initial_tasks: [{"t_transport_all", domain_state}]}
+  end
+
+  # The task carries the state it was generated from; refinement uses the current one
+  defp transport_all(state, _snapshot), do: TransportAll.t_transport_all(state.facts)
+
+  defp cross_east(state, fox, geese, corn) do
+    PlannerAdapter.commit(state, CrossEast.c_cross_east(state.facts, fox, geese, corn), @crossing_duration)
+  end
+
+  defp cross_west(state, fox, geese, corn) do
+    PlannerAdapter.commit(state, CrossWest.c_cross_west(state.facts, fox, geese, corn), @crossing_duration)
+  end
+end
@@ -0,0 +1,40 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2025-present K. S. Ernest (iFire) Lee
+
+defmodule AriaPlanner.Domains.Neighbours.PlannerSpec do
+  @moduledoc """
+  Neighbours domain wired for `AriaCore.Planner.LazyRefinement`.
+
+  Every assignment takes one time unit.
+  """
+
+  alias AriaCore.Planner.{Actions, Methods}
+  alias AriaPlanner.Domains.Neighbours.Commands.AssignValue
+  alias AriaPlanner.Domains.Neighbours.Tasks.MaximizeGrid
+  alias AriaPlanner.Domains.PlannerAdapter
+
+  @assignment_duration 1
+
+  @doc """
+  Returns the `domain_spec` for `LazyRefinement.run_lazy_refineahead/4`.
+  """
+  @spec domain_spec(map()) :: %{methods: Methods.t(), actions: Actions.t(), initial_tasks: list()}
+  def domain_spec(domain_state) do
+    methods =
+      Methods.new()
+      |> Methods.add_task_method("t_maximize_grid", [&maximize_grid/2])
+
+    actions =
+      Actions.new()
+      |> Actions.add_action("c_assign_value", &assign_value/4)
+
+    %{methods: methods, actions: actions, initial_tasks: [{"t_maximize_grid", domain_state}]}
+  end
+
+  # The task carries the state it was generated from; refinement uses the current one
+  defp maximize_grid(state, _snapshot), do: MaximizeGrid.t_maximize_grid(state.facts)
+
+  defp assign_value(state, row, col, value) do
+    PlannerAdapter.commit(state, AssignValue.c_assign_value(state.facts, row, col, value), @assignment_duration)
+  end
+end
@@ -0,0 +1,60 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2025-present K. S. Ernest (iFire) Lee
+
+defmodule AriaPlanner.Domains.PlannerAdapter do
+  @moduledoc """
+  Glue between the map-based domain commands and `AriaCore.Planner.LazyRefinement`.
+
+  Domain commands take and return the plain state map produced by their
+  `initialize_state/1`. The lazy refinement planner works on an
+  `AriaCore.Planner.State` whose `facts` hold that map, and expects actions
+  to return `{:ok, state, duration_ms}`.
+  """
+
+  alias AriaCore.Planner.State
+
+  @doc """
+  Builds the `initial_state_params` argument of `LazyRefinement.run_lazy_refineahead/4`
+  from a domain state map.
+  """
+  @spec initial_state_params(map()) :: map()
+  def initial_state_params(domain_state) when is_map(domain_state) do
+    %{
+      current_time: DateTime.utc_now(),
+      timeline: %{},
+      entity_capabilities: %{},
+      facts: domain_state
+    }
+  end
+
+  @doc """
+  Applies the result of a domain command to the planner state.
+
+  Each top-level entry the command changed is written wholesale with
+  `State.put_subject/3`, and each one it dropped is deleted, so the
+  planner's trail records the command's effects as one entry per changed
+  key. Entries are replaced rather than merged, so nested keys the command
+  deleted are gone and sets are not unioned with their old value. The
+  fingerprint is only adjusted for the nested facts that changed.
+  """
+  @spec commit(State.t(), {:ok, map()} | {:error, term()}, non_neg_integer()) ::
+          {:ok, State.t(), non_neg_integer()} | {:error, term()}
+  def commit(%State{facts: facts} = state, {:ok, new_facts}, duration) do
+    state =
+      Enum.reduce(new_facts, state, fn {key, value}, state ->
+        case Map.fetch(facts, key) do
+          {:ok, ^value} -> state
+          _changed -> State.put_subject(state, key, value)
+        end
+      end)
+
+    state =
+      Enum.reduce(facts, state, fn {key, _value}, state ->
+        if Map.has_key?(new_facts, key), do: state, else: State.delete_subject(state, key)
+      end)
+
+    {:ok, state, duration}
+  end
+
+  def commit(%State{}, {:error, reason}, _duration), do: {:error, reason}
+end
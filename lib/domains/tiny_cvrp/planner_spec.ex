@@ -0,0 +1,60 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2025-present K. S. Ernest (iFire) Lee
+
+defmodule AriaPlanner.Domains.TinyCvrp.PlannerSpec do
+  @moduledoc """
+  Tiny CVRP domain wired for `AriaCore.Planner.LazyRefinement`.
+
+  Action durations come from `predicted_ETAs` keyed by `{from, to}` when
+  present, and default to one time unit.
+  """
+
+  alias AriaCore.Planner.{Actions, Methods}
+  alias AriaPlanner.Domains.PlannerAdapter
+  alias AriaPlanner.Domains.TinyCvrp.Commands.{ReturnToDepot, VisitCustomer}
+  alias AriaPlanner.Domains.TinyCvrp.Predicates.VehicleAt
+  alias AriaPlanner.Domains.TinyCvrp.Tasks.RouteVehicles
+
+  @depot 1
+
+  @doc """
+  Returns the `domain_spec` for `LazyRefinement.run_lazy_refineahead/4`.
+  """
+  @spec domain_spec(map()) :: %{methods: Methods.t(), actions: Actions.t(), initial_tasks: list()}
+  def domain_spec(domain_state) do
+    methods =
+      Methods.new()
+      |> Methods.add_task_method("t_route_vehicles", [&route_vehicles/2])
+
+    actions =
+      Actions.new()
+      |> Actions.add_action("c_visit_customer", &visit_customer/3)
+      |> Actions.add_action("c_return_to_depot", &return_to_depot/2)
+
+    %{methods: methods, actions: actions, initial_tasks: [{"t_route_vehicles", domain_state}]}
+  end
+
+  @doc """
+  Travel time between two places, from `predicted_ETAs` or one time unit.
+  """
+  @spec travel_time(map(), pos_integer(), pos_integer()) :: non_neg_integer()
+  def travel_time(facts, from, to) do
+    case Map.get(facts, :predicted_ETAs, %{}) do
+      etas when is_map(etas) -> Map.get(etas, {from, to}, 1)
+      _ -> 1
+    end
+  end
+
+  # The task carries the state it was generated from; refinement uses the current one
+  defp route_vehicles(state, _snapshot), do: RouteVehicles.t_route_vehicles(state.facts)
+
+  defp visit_customer(state, vehicle, customer) do
+    duration = travel_time(state.facts, VehicleAt.get(state.facts, vehicle), customer)
+    PlannerAdapter.commit(state, VisitCustomer.c_visit_customer(state.facts, vehicle, customer), duration)
+  end
+
+  defp return_to_depot(state, vehicle) do
+    duration = travel_time(state.facts, VehicleAt.get(state.facts, vehicle), @depot)
+    PlannerAdapter.commit(state, ReturnToDepot.c_return_to_depot(state.facts, vehicle), duration)
+  end
+end
@@ -0,0 +1,80 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2025-present K. S. Ernest (iFire) Lee
+
+defmodule Mix.Tasks.AriaPlanner.Bench do
+  @shortdoc "Benchmarks the planner on the bundled MiniZinc instances"
+
+  @moduledoc """
+  Plans every supported MiniZinc challenge instance under `thirdparty/`
+  and writes the measurements as JSON.
+
+      mix aria_planner.bench
+      mix aria_planner.bench --domain tiny-cvrp --domain neighbours
+      mix aria_planner.bench --output bench/results/main.json --timeout 120000
+
+  ## Options
+
+    * `--domain` - only run this domain's instances; may be repeated
+    * `--output` - JSON file to write. Defaults to
+      `bench/results/<version>-<timestamp>.json`
+    * `--timeout` - milliseconds allowed per instance. Defaults to `60000`
+    * `--portfolio` - method alternatives raced per node. Defaults to `1`
+    * `--root` - directory holding the problem sets. Defaults to `thirdparty`
+
+  See `AriaPlanner.Planner.Benchmark` for what each measurement means.
+  """
+
+  use Mix.Task
+
+  alias AriaPlanner.Planner.Benchmark
+
+  @switches [domain: :keep, output: :string, timeout: :integer, portfolio: :integer, root: :string]
+
+  @impl Mix.Task
+  def run(args) do
+    {opts, _args, invalid} = OptionParser.parse(args, strict: @switches)
+
+    if invalid != [] do
+      Mix.raise("Invalid options: #{inspect(invalid)}")
+    end
+
+    Mix.Task.run("app.config")
+    {:ok, _} = Application.ensure_all_started(:telemetry)
+    Logger.configure(level: :warning)
+
+    only = Keyword.get_values(opts, :domain)
+    root = Keyword.get(opts, :root, "thirdparty")
+    run_opts = [timeout: Keyword.get(opts, :timeout, 60_000), portfolio: Keyword.get(opts, :portfolio, 1)]
+
+    case Benchmark.instances(root, only) do
+      [] ->
+        Mix.raise("No instances found under #{root} for #{inspect(Map.keys(Benchmark.domains()))}")
+
+      instances ->
+        results =
+          Enum.map(instances, fn {domain, path} ->
+            result = Benchmark.run(domain, path, run_opts)
+            Mix.shell().info(format(result))
+            result
+          end)
+
+        report = Benchmark.report(results)
+        output = Keyword.get_lazy(opts, :output, fn -> default_output(report) end)
+        File.mkdir_p!(Path.dirname(output))
+        File.write!(output, Jason.encode_to_iodata!(report, pretty: true))
+        Mix.shell().info("Wrote #{length(results)} results to #{output}")
+    end
+  end
+
+  defp format(result) do
+    "#{result.domain}/#{result.instance}: #{result.status} " <>
+      "wall=#{Float.round(result.wall_time_us / 1000, 1)}ms iterations=#{result.iterations} " <>
+      "backtracks=#{result.backtracks} actions=#{result.actions} " <>
+      "peak_memory=#{div(result.peak_memory_bytes, 1024)}KiB reductions=#{result.reductions}"
+  end
+
+  defp default_output(report) do
+    timestamp = report.recorded_at |> String.replace(~r/[^0-9T]/, "") |> String.slice(0, 15)
+    Path.join(["bench", "results", "#{report.version}-#{timestamp}.json"])
+  end
+end
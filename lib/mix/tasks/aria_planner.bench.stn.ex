@@ -0,0 +1,52 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2025-present K. S. Ernest (iFire) Lee
+
+defmodule Mix.Tasks.AriaPlanner.Bench.Stn do
+  @shortdoc "Benchmarks batch STN solving against per-network path consistency"
+
+  @moduledoc """
+  Solves random STNs one network at a time and as one batch, and prints
+  both timings.
+
+      mix aria_planner.bench.stn
+      mix aria_planner.bench.stn --count 256 --points 300 --seed 7
+
+  ## Options
+
+    * `--count` - networks per run. Defaults to `64`
+    * `--points` - time points per network. Defaults to `200`
+    * `--density` - constraints per time point. Defaults to `3`
+    * `--seed` - random seed. Defaults to `1`
+
+  See `AriaPlanner.Planner.Benchmark.STNBatch` for what each measurement means.
+  """
+
+  use Mix.Task
+
+  alias AriaPlanner.Planner.Benchmark.STNBatch
+
+  @switches [count: :integer, points: :integer, density: :integer, seed: :integer]
+
+  @impl Mix.Task
+  def run(args) do
+    {opts, _args, invalid} = OptionParser.parse(args, strict: @switches)
+
+    if invalid != [] do
+      Mix.raise("Invalid options: #{inspect(invalid)}")
+    end
+
+    Mix.Task.run("app.config")
+
+    result =
+      STNBatch.run(Keyword.get(opts, :count, 64), Keyword.get(opts, :points, 200),
+        seed: Keyword.get(opts, :seed, 1),
+        density: Keyword.get(opts, :density, 3)
+      )
+
+    Mix.shell().info(
+      "#{result.stns} STNs x #{result.points} points (#{result.constraints} constraints): " <>
+        "sequential=#{Float.round(result.sequential_us / 1000, 1)}ms " <>
+        "batch=#{Float.round(result.batch_us / 1000, 1)}ms agree=#{result.agree}"
+    )
+  end
+end
@@ -15,7 +15,9 @@ defmodule AriaPlanner.Planner.Application do
       # Start the Ecto repository
       AriaPlanner.Repo,
       # Domain Registry for dynamic domain discovery
-      AriaPlanner.Planner.DomainRegistry
+      AriaPlanner.Planner.DomainRegistry,
+      # Bounded pool for constraint solving requests
+      AriaPlanner.Solvers.SolverPool
 
       # Membrane Pipeline for command execution (temporarily disabled for UUID generation)
       # %{
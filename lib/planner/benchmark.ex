@@ -0,0 +1,225 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2025-present K. S. Ernest (iFire) Lee
+
+defmodule AriaPlanner.Planner.Benchmark do
+  @moduledoc """
+  Runs `AriaCore.Planner.LazyRefinement` over the MiniZinc challenge
+  instances bundled under `thirdparty/`.
+
+  Every instance is loaded through its domain's `parse_dzn_file` and
+  `initialize_state`, wired into the planner by the domain's `PlannerSpec`,
+  and planned in a fresh process so that its measurements are its own:
+
+    * `wall_time_us` - wall-clock time of the planning run
+    * `iterations` - refinement steps, counted from `:iteration` telemetry events
+    * `backtracks` - backtracks, counted from `:backtrack` telemetry spans
+    * `peak_memory_bytes` - largest process memory observed by sampling the
+      planning process every millisecond
+    * `reductions` - reductions executed by the planning process
+
+  With a `:portfolio` width above one, iterations and backtracks include the
+  racing workers' but memory and reductions are those of the planning
+  process only.
+  """
+
+  alias AriaCore.Planner.LazyRefinement
+  alias AriaPlanner.Domains.{AircraftDisassembly, FoxGeeseCorn, Neighbours, PlannerAdapter, TinyCvrp}
+
+  @probs_dirs ["mznc2024_probs", "mznc2025_probs"]
+
+  @telemetry_events [
+    [:aria_planner, :lazy_refinement, :iteration],
+    [:aria_planner, :lazy_refinement, :backtrack, :stop]
+  ]
+
+  @type result :: %{
+          optional(:error) => String.t(),
+          domain: String.t(),
+          instance: String.t(),
+          status: String.t(),
+          wall_time_us: non_neg_integer(),
+          iterations: non_neg_integer(),
+          backtracks: non_neg_integer(),
+          actions: non_neg_integer(),
+          peak_memory_bytes: non_neg_integer(),
+          reductions: non_neg_integer()
+        }
+
+  @doc """
+  Domains with a planner wiring, keyed by their directory under the
+  MiniZinc problem sets.
+  """
+  @spec domains() :: %{String.t() => {module(), module()}}
+  def domains do
+    %{
+      "aircraft-disassembly" => {AircraftDisassembly, AircraftDisassembly.PlannerSpec},
+      "fox-geese-corn" => {FoxGeeseCorn, FoxGeeseCorn.PlannerSpec},
+      "neighbours" => {Neighbours, Neighbours.PlannerSpec},
+      "tiny-cvrp" => {TinyCvrp, TinyCvrp.PlannerSpec}
+    }
+  end
+
+  @doc """
+  Lists `{domain, path}` for every `.dzn` instance of a supported domain
+  under `root`, sorted by domain then file name.
+  """
+  @spec instances(Path.t(), [String.t()]) :: [{String.t(), Path.t()}]
+  def instances(root, only \\ []) do
+    instances =
+      for probs <- @probs_dirs,
+          domain <- Map.keys(domains()),
+          only == [] or domain in only,
+          path <- Path.wildcard(Path.join([root, probs, domain, "*.dzn"])) do
+        {domain, path}
+      end
+
+    Enum.sort_by(instances, fn {domain, path} -> {domain, Path.basename(path)} end)
+  end
+
+  @doc """
+  Plans one instance and returns its measurements.
+
+  ## Options
+
+    * `:timeout` - milliseconds before the run is killed and reported as
+      `"timeout"`. Defaults to `60_000`.
+    * `:portfolio` - passed through to `LazyRefinement.run_lazy_refineahead/4`.
+  """
+  @spec run(String.t(), Path.t(), keyword()) :: result()
+  def run(domain, path, opts \\ []) do
+    {domain_module, spec_module} = Map.fetch!(domains(), domain)
+    timeout = Keyword.get(opts, :timeout, 60_000)
+
+    result = %{
+      domain: domain,
+      instance: Path.basename(path),
+      status: "error",
+      wall_time_us: 0,
+      iterations: 0,
+      backtracks: 0,
+      actions: 0,
+      peak_memory_bytes: 0,
+      reductions: 0
+    }
+
+    case load(domain_module, path) do
+      {:ok, domain_state} ->
+        spec = spec_module.domain_spec(domain_state)
+        plan = %AriaCore.Plan{id: Path.basename(path), name: domain, persona_id: "benchmark", domain_type: domain}
+        counters = :counters.new(2, [:write_concurrency])
+        handler_id = {__MODULE__, make_ref()}
+        :ok = :telemetry.attach_many(handler_id, @telemetry_events, &__MODULE__.handle_event/4, counters)
+
+        try do
+          measure(result, spec, PlannerAdapter.initial_state_params(domain_state), plan, counters, timeout, opts)
+        after
+          :telemetry.detach(handler_id)
+        end
+
+      {:error, reason} ->
+        Map.put(result, :error, to_string(reason))
+    end
+  end
+
+  @doc false
+  def handle_event([:aria_planner, :lazy_refinement, :iteration], _measurements, _metadata, counters),
+    do: :counters.add(counters, 1, 1)
+
+  def handle_event([:aria_planner, :lazy_refinement, :backtrack, :stop], _measurements, _metadata, counters),
+    do: :counters.add(counters, 2, 1)
+
+  defp load(Neighbours, path) do
+    with {:ok, %{n: n, m: m}} <- Neighbours.parse_dzn_file(path) do
+      Neighbours.initialize_state(n, m)
+    else
+      {:ok, _params} -> {:error, "missing grid dimensions"}
+      error -> error
+    end
+  end
+
+  defp load(domain_module, path) do
+    with {:ok, params} <- domain_module.parse_dzn_file(path) do
+      domain_module.initialize_state(params)
+    end
+  end
+
+  defp measure(result, spec, state_params, plan, counters, timeout, opts) do
+    started_at = System.monotonic_time(:microsecond)
+
+    task =
+      Task.async(fn ->
+        try do
+          {:ok, final_plan} = LazyRefinement.run_lazy_refineahead(spec, state_params, plan, opts)
+          {:reductions, reductions} = Process.info(self(), :reductions)
+          {:ok, final_plan, reductions}
+        rescue
+          e -> {:error, Exception.message(e)}
+        end
+      end)
+
+    {outcome, peak_memory} = await_sampling(task, started_at + timeout * 1000, 0)
+    wall_time_us = System.monotonic_time(:microsecond) - started_at
+
+    result = %{
+      result
+      | wall_time_us: wall_time_us,
+        iterations: :counters.get(counters, 1),
+        backtracks: :counters.get(counters, 2),
+        peak_memory_bytes: peak_memory
+    }
+
+    case outcome do
+      {:ok, {:ok, final_plan, reductions}} ->
+        actions = final_plan.solution_plan |> Jason.decode!() |> length()
+        %{result | status: final_plan.execution_status, actions: actions, reductions: reductions}
+
+      {:ok, {:error, message}} ->
+        Map.put(result, :error, message)
+
+      :timeout ->
+        %{result | status: "timeout"}
+    end
+  end
+
+  # Waits for the task while sampling its memory every millisecond
+  defp await_sampling(%Task{ref: ref, pid: pid} = task, deadline, peak) do
+    peak =
+      case Process.info(pid, :memory) do
+        {:memory, memory} -> max(peak, memory)
+        nil -> peak
+      end
+
+    receive do
+      {^ref, reply} ->
+        Process.demonitor(ref, [:flush])
+        {{:ok, reply}, peak}
+
+      {:DOWN, ^ref, :process, _pid, reason} ->
+        exit(reason)
+    after
+      1 ->
+        if System.monotonic_time(:microsecond) >= deadline do
+          Task.shutdown(task, :brutal_kill)
+          {:timeout, peak}
+        else
+          await_sampling(task, deadline, peak)
+        end
+    end
+  end
+
+  @doc """
+  Wraps results with the environment they were measured in, ready for
+  `Jason.encode!/2`.
+  """
+  @spec report([result()]) :: map()
+  def report(results) do
+    %{
+      version: to_string(Application.spec(:aria_planner, :vsn) || "dev"),
+      elixir: System.version(),
+      otp_release: to_string(:erlang.system_info(:otp_release)),
+      schedulers: System.schedulers_online(),
+      recorded_at: DateTime.to_iso8601(DateTime.utc_now()),
+      results: results
+    }
+  end
+end
@@ -0,0 +1,93 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2025-present K. S. Ernest (iFire) Lee
+
+defmodule AriaPlanner.Planner.Benchmark.STNBatch do
+  @moduledoc """
+  Compares batch STN solving with solving the same networks one by one.
+
+  Generates `count` random networks of `points` time points and solves them
+  twice with the same `STN.PathConsistency` solver:
+
+    * `sequential_us` - one network after the other in the calling process
+    * `batch_us` - all of them through `AriaStnSolver.solve_batch/2`, which
+      spreads the networks over the online schedulers
+
+  The difference is the speedup from batching alone. The map-based
+  Floyd-Warshall the solver replaced is not run, as it no longer exists.
+
+  `agree` reports whether both paths found the same consistency and the
+  same minimal bounds. About a quarter of the networks are made
+  inconsistent so that both outcomes are exercised.
+  """
+
+  alias AriaPlanner.Planner.Temporal.STN.PathConsistency
+
+  @type result :: %{
+          stns: non_neg_integer(),
+          points: pos_integer(),
+          constraints: non_neg_integer(),
+          sequential_us: non_neg_integer(),
+          batch_us: non_neg_integer(),
+          agree: boolean()
+        }
+
+  @doc """
+  Runs the comparison.
+
+  ## Options
+
+    * `:seed` - random seed, so that runs are comparable. Defaults to `1`
+    * `:density` - constraints per time point. Defaults to `3`
+  """
+  @spec run(pos_integer(), pos_integer(), keyword()) :: result()
+  def run(count, points, opts \\ []) when points > 1 do
+    :rand.seed(:exsss, Keyword.get(opts, :seed, 1))
+    density = Keyword.get(opts, :density, 3)
+    networks = for index <- 1..count, do: network(points, density, rem(index, 4) == 0)
+
+    {sequential_us, sequential_results} = :timer.tc(fn -> Enum.map(networks, &PathConsistency.from_constraints/1) end)
+    {batch_us, batch_results} = :timer.tc(fn -> AriaStnSolver.solve_batch(networks) end)
+
+    %{
+      stns: count,
+      points: points,
+      constraints: networks |> Enum.map(&length/1) |> Enum.sum(),
+      sequential_us: sequential_us,
+      batch_us: batch_us,
+      agree: Enum.all?(Enum.zip(sequential_results, batch_results), &same?(&1, points))
+    }
+  end
+
+  # Constraints around a hidden schedule, consistent unless deliberately broken
+  defp network(points, density, broken?) do
+    times = Map.new(0..(points - 1), fn point -> {point, :rand.uniform(1000)} end)
+
+    chain = for point <- 1..(points - 1), do: {point - 1, point}
+    extra = for _ <- 1..(points * (density - 1))//1, do: {:rand.uniform(points) - 1, :rand.uniform(points) - 1}
+
+    constraints =
+      for {from, to} <- chain ++ extra, from != to do
+        distance = times[to] - times[from]
+        {from, to, distance - :rand.uniform(50), distance + :rand.uniform(50)}
+      end
+
+    if broken? do
+      # Disjoint from the bounds on the first link of the chain
+      [{0, 1, _min, max} | _constraints] = constraints
+      [{0, 1, max + 1, max + 10} | constraints]
+    else
+      constraints
+    end
+  end
+
+  defp same?({network, {:inconsistent, _reason}}, _points), do: not PathConsistency.consistent?(network)
+
+  defp same?({network, {:consistent, solved}}, points) do
+    PathConsistency.consistent?(network) and
+      Enum.all?(0..(points - 1), fn from ->
+        Enum.all?(0..(points - 1), fn to ->
+          PathConsistency.distance(network, from, to) == PathConsistency.distance(solved, from, to)
+        end)
+      end)
+  end
+end
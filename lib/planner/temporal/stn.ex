@@ -11,7 +11,7 @@ defmodule AriaPlanner.Planner.Temporal.STN do
   - Temporal constraint management
   - Interval scheduling and conflict detection
   - Time unit conversion and LOD scaling
-  - Pure Elixir constraint solving using Floyd-Warshall algorithm
+  - Incremental path consistency as constraints are added
   - Parallel processing for large STNs
 
   ## Architecture
@@ -19,9 +19,11 @@ defmodule AriaPlanner.Planner.Temporal.STN do
   STNs represent temporal constraints as a network of time points connected by
   distance constraints. The network maintains:
 
-  - **Time Points**: Named temporal anchors (e.g., "action_start", "action_end")
+  - **Time Points**: Named temporal anchors (e.g., "action_start", "action_end"),
+    interned once to dense integer ids (`time_point_id/2`, `time_point_name/2`)
   - **Constraints**: Minimum/maximum time distances between points
-  - **Consistency**: Floyd-Warshall algorithm ensures no constraint violations
+  - **Consistency**: minimal distances between all time points, maintained
+    incrementally by `STN.PathConsistency` on every `add_constraint/4`
 
   ## Level of Detail (LOD)
 
@@ -55,7 +57,15 @@ defmodule AriaPlanner.Planner.Temporal.STN do
       slots = AriaPlanner.Planner.Temporal.STN.find_free_slots(stn, 30, 0, 100)
   """
 
-  alias AriaPlanner.Planner.Temporal.STN.{Operations, Consistency, Scheduling, Units}
+  alias AriaPlanner.Planner.Temporal.STN.{
+    Operations,
+    Consistency,
+    Dispatch,
+    IntervalIndex,
+    PathConsistency,
+    Scheduling,
+    Units
+  }
 
   @type constraint :: {number(), number()}
   @type time_point :: String.t()
@@ -71,7 +81,9 @@ defmodule AriaPlanner.Planner.Temporal.STN do
           time_unit: time_unit(),
           lod_level: lod_level(),
           lod_resolution: lod_resolution(),
-          metadata: map()
+          metadata: map(),
+          network: PathConsistency.t() | nil,
+          intervals: IntervalIndex.t() | nil
         }
 
   defstruct time_points: MapSet.new(),
@@ -80,7 +92,9 @@ defmodule AriaPlanner.Planner.Temporal.STN do
             time_unit: :second,
             lod_level: :medium,
             lod_resolution: 100,
-            metadata: %{}
+            metadata: %{},
+            network: nil,
+            intervals: nil
 
   @doc """
   Creates a new empty Simple Temporal Network.
@@ -89,7 +103,13 @@ defmodule AriaPlanner.Planner.Temporal.STN do
   """
   @spec new() :: t()
   def new do
-    %__MODULE__{time_points: MapSet.new(), constraints: %{}, consistent: true, time_unit: :second}
+    %__MODULE__{
+      time_points: MapSet.new(),
+      constraints: %{},
+      consistent: true,
+      time_unit: :second,
+      network: PathConsistency.from_constraints(%{})
+    }
   end
 
   @doc """
@@ -107,17 +127,28 @@ defmodule AriaPlanner.Planner.Temporal.STN do
       time_unit: time_unit,
       lod_level: lod_level,
       lod_resolution: Units.lod_resolution_for_level(lod_level),
-      metadata: %{}
+      metadata: %{},
+      network: PathConsistency.from_constraints(%{})
     }
   end
 
   # Delegate to Operations module
   defdelegate add_interval(stn, interval), to: Operations
   defdelegate add_constraint(stn, from_point, to_point, constraint), to: Operations
+  defdelegate time_point_id(stn, time_point), to: Operations
+  defdelegate time_point_name(stn, id), to: Operations
 
   # Delegate to Consistency module
   defdelegate consistent?(stn), to: Consistency
 
+  @doc """
+  Builds the dispatchable form of the STN, with earliest and latest times
+  for every time point, for committing time points as they happen. See
+  `STN.Dispatch`.
+  """
+  @spec dispatchable(t(), keyword()) :: {:ok, Dispatch.t()} | {:error, term()}
+  def dispatchable(stn, opts \\ []), do: Dispatch.new(stn, opts)
+
   # Delegate to Scheduling module
   defdelegate get_intervals(stn), to: Scheduling
   defdelegate get_overlapping_intervals(stn, query_start, query_end), to: Scheduling
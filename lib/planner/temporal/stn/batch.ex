@@ -0,0 +1,72 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2025-present K. S. Ernest (iFire) Lee
+
+defmodule AriaPlanner.Planner.Temporal.STN.Batch do
+  @moduledoc """
+  Solves many finished STN distance graphs at once.
+
+  Each network is solved by `STN.PathConsistency`, which only relaxes the
+  paths a new constraint can shorten, and chunks of networks are solved
+  concurrently on all schedulers. An `%STN{}` reuses the network it
+  already maintains when that is in sync with its constraints.
+
+  Use `STN.PathConsistency` to maintain one network as constraints arrive;
+  use this to solve many networks in one go.
+  """
+
+  alias AriaPlanner.Planner.Temporal.STN
+  alias AriaPlanner.Planner.Temporal.STN.PathConsistency
+
+  @type network :: STN.t() | map() | [{term(), term(), number(), number()}]
+  @type result :: {:consistent, PathConsistency.t()} | {:inconsistent, String.t()} | {:error, :timeout}
+
+  @doc """
+  Solves every network and returns, in order, its minimal network or why
+  it has none. Networks in a chunk that overran `:timeout` get
+  `{:error, :timeout}`; the other chunks' results are kept.
+
+  Networks are `%STN{}` structs, `%{{from, to} => {min, max}}` constraint
+  maps or `[{from, to, min, max}]` lists.
+
+  ## Options
+
+    * `:chunk_size` - networks solved by one task. Defaults to spreading
+      the batch evenly over the online schedulers
+    * `:timeout` - milliseconds allowed per chunk. Defaults to `:infinity`
+  """
+  @spec solve_batch([network()], keyword()) :: [result()]
+  def solve_batch(networks, opts \\ [])
+  def solve_batch([], _opts), do: []
+
+  def solve_batch(networks, opts) do
+    chunk_size = Keyword.get_lazy(opts, :chunk_size, fn -> ceil(length(networks) / System.schedulers_online()) end)
+
+    chunks = Enum.chunk_every(networks, chunk_size)
+
+    chunks
+    |> Task.async_stream(fn chunk -> Enum.map(chunk, &solve/1) end,
+      timeout: Keyword.get(opts, :timeout, :infinity),
+      on_timeout: :kill_task
+    )
+    |> Enum.zip(chunks)
+    |> Enum.flat_map(fn
+      {{:ok, results}, _chunk} -> results
+      {{:exit, :timeout}, chunk} -> Enum.map(chunk, fn _network -> {:error, :timeout} end)
+    end)
+  end
+
+  defp solve(%STN{} = stn) do
+    stn.time_points
+    |> Enum.sort()
+    |> Enum.reduce(PathConsistency.sync(stn.network, stn.constraints), &PathConsistency.add_point(&2, &1))
+    |> result()
+  end
+
+  defp solve(constraints), do: constraints |> PathConsistency.from_constraints() |> result()
+
+  defp result(network) do
+    if PathConsistency.consistent?(network),
+      do: {:consistent, network},
+      else: {:inconsistent, "Negative cycle detected"}
+  end
+end
@@ -3,45 +3,34 @@
 
 defmodule AriaPlanner.Planner.Temporal.STN.Consistency do
   @moduledoc """
-  STN consistency validation using AriaStnSolver.
+  STN consistency validation.
 
-  This module provides a simple, unified interface for STN consistency checking.
-  All constraint validation goes through AriaStnSolver for reliability and consistency.
+  An STN is consistent when its distance graph has no negative cycle.
+  `STN.PathConsistency` maintains the minimal network as constraints are
+  added, so checking an STN built through `STN.add_constraint/4` is a
+  lookup. An STN whose constraints were replaced wholesale (rescaled, or
+  built by hand) has its network rebuilt from them first.
   """
 
   alias AriaPlanner.Planner.Temporal.STN
+  alias AriaPlanner.Planner.Temporal.STN.PathConsistency
 
   @doc """
   Checks if the STN is temporally consistent.
-
-  Uses AriaStnSolver for all constraint validation - simple and reliable.
   """
   @spec consistent?(STN.t() | {:error, String.t()}) :: boolean()
   def consistent?({:error, _reason}), do: false
 
-  def consistent?(stn) when is_struct(stn) do
-    # For ALL STNs, use AriaStnSolver for consistent constraint validation
-    # Convert STN format to AriaStnSolver format first
-    stn_list = stn_to_constraints_list(stn)
-
-    case AriaStnSolver.check_consistency(stn_list) do
-      {:consistent, _} -> true
-      {:inconsistent, _} -> false
-    end
+  def consistent?(%STN{} = stn) do
+    stn.consistent and PathConsistency.consistent?(network(stn))
   end
 
   def consistent?(_), do: false
 
-  # Convert STN struct constraints to list format for AriaStnSolver
-  # STN format: %{"a", "b"} => {min, max}
-  # AriaStnSolver format: [{:a, :b, min, max}, ...]
-  @spec stn_to_constraints_list(STN.t()) :: [AriaStnSolver.constraint()]
-  defp stn_to_constraints_list(stn) do
-    for {{from, to}, {min, max}} <- stn.constraints do
-      # Convert string keys to atoms (safe conversion)
-      from_atom = String.to_atom(from)
-      to_atom = String.to_atom(to)
-      {from_atom, to_atom, min, max}
-    end
-  end
+  @doc """
+  Returns the STN's minimal network, rebuilding it if it no longer matches
+  the STN's constraints.
+  """
+  @spec network(STN.t()) :: PathConsistency.t()
+  def network(%STN{network: network, constraints: constraints}), do: PathConsistency.sync(network, constraints)
 end
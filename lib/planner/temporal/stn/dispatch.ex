@@ -0,0 +1,300 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2025-present K. S. Ernest (iFire) Lee
+
+defmodule AriaPlanner.Planner.Temporal.STN.Dispatch do
+  @moduledoc """
+  Dispatchable form of an STN, for committing time points as they happen.
+
+  Built from the minimal network, it keeps every time point's window of
+  earliest and latest times and only the edges execution needs:
+
+    * Each rigid component, time points at fixed distances from each other,
+      is collapsed onto its earliest member, its leader. Other members hang
+      off the leader by their two rigid edges.
+    * Among leaders, a non-negative edge `A -> C` is dropped when some
+      non-negative `B -> C` has `d(A, B) + d(B, C) = d(A, C)`, and a negative
+      edge `A -> C` is dropped when some negative `A -> B` has
+      `d(A, B) + d(B, C) = d(A, C)`.
+
+  `observe/3` commits a time point at a time within its window and tightens
+  only its neighbours' windows, in O(degree). A time point is enabled once
+  its leader, or for a leader every time point it must follow, has been
+  observed. Observing enabled time points within their windows, in
+  non-decreasing time, always completes to a schedule satisfying every
+  constraint.
+
+  Windows are relative to the `:origin` time point, observed at `0`, or,
+  without one, to execution starting at `0`.
+  """
+
+  alias AriaPlanner.Planner.Temporal.STN
+  alias AriaPlanner.Planner.Temporal.STN.{Consistency, PathConsistency}
+
+  @type point :: PathConsistency.point()
+  @type time :: number()
+  @type window :: {time() | :neg_infinity, time() | :infinity}
+
+  @type t :: %__MODULE__{
+          network: PathConsistency.t(),
+          leaders: %{optional(non_neg_integer()) => non_neg_integer()},
+          outgoing: %{optional(non_neg_integer()) => [{non_neg_integer(), number()}]},
+          incoming: %{optional(non_neg_integer()) => [{non_neg_integer(), number()}]},
+          windows: %{optional(non_neg_integer()) => window()},
+          executed: %{optional(non_neg_integer()) => time()},
+          now: time()
+        }
+
+  defstruct network: nil, leaders: %{}, outgoing: %{}, incoming: %{}, windows: %{}, executed: %{}, now: 0
+
+  @doc """
+  Builds the dispatchable form of an `%STN{}`, a `PathConsistency` network,
+  or a constraint map or list.
+
+  ## Options
+
+    * `:origin` - time point that windows are relative to. It is observed at
+      time `0`, so every other time point must be able to follow it
+  """
+  @spec new(STN.t() | PathConsistency.t() | map() | list(), keyword()) :: {:ok, t()} | {:error, term()}
+  def new(source, opts \\ []) do
+    network = network(source)
+    origin = Keyword.get(opts, :origin)
+
+    cond do
+      not PathConsistency.consistent?(network) ->
+        {:error, "Negative cycle detected"}
+
+      origin != nil and PathConsistency.id(network, origin) == nil ->
+        {:error, :unknown_time_point}
+
+      true ->
+        origin_id = origin && PathConsistency.id(network, origin)
+        ids = Map.keys(network.names)
+        leaders = Map.new(ids, fn id -> {id, leader(network, id, origin_id)} end)
+        edges = member_edges(network, leaders) ++ leader_edges(network, leaders)
+
+        dispatch = %__MODULE__{
+          network: network,
+          leaders: leaders,
+          outgoing: Enum.group_by(edges, &elem(&1, 0), fn {_from, to, weight} -> {to, weight} end),
+          incoming: Enum.group_by(edges, &elem(&1, 1), fn {from, _to, weight} -> {from, weight} end),
+          windows: Map.new(ids, fn id -> {id, initial_window(network, id, origin_id)} end)
+        }
+
+        if origin, do: observe(dispatch, origin, 0), else: {:ok, dispatch}
+    end
+  end
+
+  @doc """
+  Commits `point` as having happened at `time`.
+
+  Fails without changing the dispatch if the point is unknown, already
+  observed, not yet enabled, or `time` is before the last observation or
+  outside the point's window.
+  """
+  @spec observe(t(), point(), time()) :: {:ok, t()} | {:error, atom()}
+  def observe(%__MODULE__{network: network} = dispatch, point, time) do
+    id = PathConsistency.id(network, point)
+
+    cond do
+      id == nil -> {:error, :unknown_time_point}
+      Map.has_key?(dispatch.executed, id) -> {:error, :already_executed}
+      not enabled_id?(dispatch, id) -> {:error, :not_enabled}
+      time < dispatch.now -> {:error, :in_the_past}
+      not within?(Map.fetch!(dispatch.windows, id), time) -> {:error, :outside_window}
+      true -> {:ok, execute(dispatch, id, time)}
+    end
+  end
+
+  @doc """
+  Current `{earliest, latest}` window of `point`, or of its observed time.
+  """
+  @spec window(t(), point()) :: window() | nil
+  def window(%__MODULE__{network: network, executed: executed, windows: windows}, point) do
+    id = PathConsistency.id(network, point)
+
+    case executed do
+      %{^id => time} -> {time, time}
+      _ -> Map.get(windows, id)
+    end
+  end
+
+  @doc """
+  Time points that may be observed next, in time point id order.
+  """
+  @spec enabled(t()) :: [point()]
+  def enabled(%__MODULE__{network: network} = dispatch) do
+    for id <- Enum.sort(Map.keys(dispatch.windows)),
+        not Map.has_key?(dispatch.executed, id),
+        enabled_id?(dispatch, id),
+        do: PathConsistency.name(network, id)
+  end
+
+  @doc """
+  Observed time points and their times.
+  """
+  @spec executed(t()) :: %{optional(point()) => time()}
+  def executed(%__MODULE__{network: network, executed: executed}),
+    do: Map.new(executed, fn {id, time} -> {PathConsistency.name(network, id), time} end)
+
+  @doc """
+  Edges kept for dispatching, as `{from, to, max}` meaning
+  `t(to) - t(from) <= max`.
+  """
+  @spec edges(t()) :: [{point(), point(), number()}]
+  def edges(%__MODULE__{network: network, outgoing: outgoing}) do
+    for {from, targets} <- outgoing, {to, weight} <- targets do
+      {PathConsistency.name(network, from), PathConsistency.name(network, to), weight}
+    end
+  end
+
+  @doc """
+  Completes the dispatch as early as possible: repeatedly observes the
+  enabled time point that can happen first, at the earliest time it can.
+  """
+  @spec schedule(t()) :: {:ok, %{optional(point()) => time()}} | {:error, atom()}
+  def schedule(%__MODULE__{} = dispatch) do
+    case enabled(dispatch) do
+      [] ->
+        {:ok, executed(dispatch)}
+
+      points ->
+        point = Enum.min_by(points, &earliest(dispatch, &1))
+
+        case observe(dispatch, point, earliest(dispatch, point)) do
+          {:ok, dispatch} -> schedule(dispatch)
+          error -> error
+        end
+    end
+  end
+
+  defp network(%STN{} = stn), do: Consistency.network(stn)
+  defp network(%PathConsistency{} = network), do: network
+  defp network(constraints), do: PathConsistency.from_constraints(constraints)
+
+  defp earliest(dispatch, point) do
+    case window(dispatch, point) do
+      {:neg_infinity, _latest} -> dispatch.now
+      {earliest, _latest} -> max(earliest, dispatch.now)
+    end
+  end
+
+  # Earliest member of the rigid component of `id`; among simultaneous ones the origin, then the lowest id
+  defp leader(network, id, origin_id) do
+    rigid =
+      for {other, offset} <- Map.get(network.rows, id, %{}),
+          distance(network, other, id) == -offset,
+          do: {other, offset}
+
+    [{id, 0} | rigid]
+    |> Enum.min_by(fn {member, offset} -> {offset, member != origin_id, member} end)
+    |> elem(0)
+  end
+
+  defp member_edges(network, leaders) do
+    for {member, leader} <- leaders,
+        member != leader,
+        {from, to} <- [{leader, member}, {member, leader}],
+        do: {from, to, distance(network, from, to)}
+  end
+
+  defp leader_edges(network, leaders) do
+    leader_ids = leaders |> Map.values() |> Enum.uniq()
+    leader_set = MapSet.new(leader_ids)
+
+    for a <- leader_ids,
+        {c, weight} <- Map.get(network.rows, a, %{}),
+        MapSet.member?(leader_set, c),
+        not dominated?(network, leader_ids, a, c, weight),
+        do: {a, c, weight}
+  end
+
+  defp dominated?(network, leader_ids, a, c, weight) when weight >= 0 do
+    Enum.any?(leader_ids, fn b ->
+      b != a and b != c and nonnegative?(distance(network, b, c)) and
+        sum(distance(network, a, b), distance(network, b, c)) == weight
+    end)
+  end
+
+  defp dominated?(network, leader_ids, a, c, weight) do
+    Enum.any?(leader_ids, fn b ->
+      b != a and b != c and negative?(distance(network, a, b)) and
+        sum(distance(network, a, b), distance(network, b, c)) == weight
+    end)
+  end
+
+  defp initial_window(network, id, nil) do
+    # Every time point happens at or after 0, so none can be earlier than 0 - d(id, other)
+    earliest = network.rows |> Map.get(id, %{}) |> Enum.reduce(0, fn {_other, distance}, acc -> max(acc, -distance) end)
+    {earliest, :infinity}
+  end
+
+  defp initial_window(network, id, origin_id) do
+    earliest =
+      case distance(network, id, origin_id) do
+        :infinity -> :neg_infinity
+        distance -> -distance
+      end
+
+    {earliest, distance(network, origin_id, id)}
+  end
+
+  defp execute(dispatch, id, time) do
+    executed = Map.put(dispatch.executed, id, time)
+
+    windows =
+      dispatch.outgoing
+      |> Map.get(id, [])
+      |> Enum.reduce(dispatch.windows, fn {to, weight}, windows ->
+        tighten(windows, executed, to, fn {earliest, latest} -> {earliest, min_bound(latest, time + weight)} end)
+      end)
+
+    windows =
+      dispatch.incoming
+      |> Map.get(id, [])
+      |> Enum.reduce(windows, fn {from, weight}, windows ->
+        tighten(windows, executed, from, fn {earliest, latest} -> {max_bound(earliest, time - weight), latest} end)
+      end)
+
+    %{dispatch | executed: executed, windows: windows, now: time}
+  end
+
+  defp tighten(windows, executed, id, fun) do
+    if Map.has_key?(executed, id), do: windows, else: Map.update!(windows, id, fun)
+  end
+
+  defp enabled_id?(%__MODULE__{leaders: leaders, executed: executed, outgoing: outgoing}, id) do
+    case Map.fetch!(leaders, id) do
+      ^id -> outgoing |> Map.get(id, []) |> Enum.all?(fn {to, weight} -> weight >= 0 or Map.has_key?(executed, to) end)
+      leader -> Map.has_key?(executed, leader)
+    end
+  end
+
+  defp within?({earliest, latest}, time),
+    do: (earliest == :neg_infinity or earliest <= time) and (latest == :infinity or time <= latest)
+
+  defp distance(_network, same, same), do: 0
+
+  defp distance(network, from, to) do
+    case network.rows do
+      %{^from => %{^to => distance}} -> distance
+      _ -> :infinity
+    end
+  end
+
+  defp sum(:infinity, _distance), do: :infinity
+  defp sum(_distance, :infinity), do: :infinity
+  defp sum(a, b), do: a + b
+
+  defp nonnegative?(:infinity), do: true
+  defp nonnegative?(distance), do: distance >= 0
+
+  defp negative?(:infinity), do: false
+  defp negative?(distance), do: distance < 0
+
+  defp min_bound(:infinity, value), do: value
+  defp min_bound(bound, value), do: min(bound, value)
+
+  defp max_bound(:neg_infinity, value), do: value
+  defp max_bound(bound, value), do: max(bound, value)
+end
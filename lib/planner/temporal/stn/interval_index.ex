@@ -0,0 +1,197 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2025-present K. S. Ernest (iFire) Lee
+
+defmodule AriaPlanner.Planner.Temporal.STN.IntervalIndex do
+  @moduledoc """
+  Persistent index of an STN's intervals for scheduling queries.
+
+  An interval `id` exists while the STN has both `"<id>_start"` and
+  `"<id>_end"` time points and a numeric constraint between them; its
+  bounds are those `STN.Scheduling` reports. Intervals are kept in an AVL
+  tree ordered by start and augmented with the largest end time of each
+  subtree, so overlap queries cost O(log n + k) for k results.
+
+  `STN.Operations` refreshes the intervals of the time points it touches.
+  An index whose STN was changed by other means, or that an STN built by
+  hand lacks, is rebuilt by `sync/2`.
+  """
+
+  @type interval :: {id :: String.t(), start_time :: number(), end_time :: number()}
+  @type tree ::
+          nil
+          | {key :: {number(), String.t()}, end_time :: number(), max_end :: number(), height :: pos_integer(),
+             left :: tree(), right :: tree()}
+
+  @type t :: %__MODULE__{
+          root: tree(),
+          bounds: %{optional(String.t()) => {number(), number()}},
+          points: MapSet.t() | nil,
+          source: map() | nil
+        }
+
+  defstruct root: nil, bounds: %{}, points: nil, source: nil
+
+  @doc """
+  Returns the index for `stn`: `index` itself when it is up to date,
+  otherwise one rebuilt from the STN's time points and constraints.
+  """
+  @spec sync(t() | nil, map()) :: t()
+  def sync(%__MODULE__{points: points, source: source} = index, %{time_points: time_points, constraints: constraints})
+      when points === time_points and source === constraints,
+      do: index
+
+  def sync(_index, stn) do
+    stn.time_points
+    |> Enum.flat_map(&List.wrap(interval_id(&1)))
+    |> Enum.uniq()
+    |> Enum.reduce(%__MODULE__{}, fn id, index -> put(index, id, bounds(stn, id)) end)
+    |> stamp(stn)
+  end
+
+  @doc """
+  Brings the intervals of `time_points` up to date with `stn`, given an
+  index that was up to date before they changed.
+  """
+  @spec refresh(t(), map(), [term()]) :: t()
+  def refresh(%__MODULE__{} = index, stn, time_points) do
+    time_points
+    |> Enum.flat_map(&List.wrap(interval_id(&1)))
+    |> Enum.uniq()
+    |> Enum.reduce(index, fn id, index -> put(index, id, bounds(stn, id)) end)
+    |> stamp(stn)
+  end
+
+  @doc """
+  All intervals, ordered by start time then id.
+  """
+  @spec to_list(t()) :: [interval()]
+  def to_list(%__MODULE__{root: root}), do: in_order(root, [])
+
+  @doc """
+  Intervals with `start_time <= to` and `from <= end_time`, ordered by start
+  time then id.
+  """
+  @spec overlapping(t(), number(), number()) :: [interval()]
+  def overlapping(%__MODULE__{root: root}, from, to), do: overlapping(root, from, to, [])
+
+  defp stamp(index, stn), do: %{index | points: stn.time_points, source: stn.constraints}
+
+  defp put(%__MODULE__{bounds: bounds} = index, id, new_bounds) do
+    case {Map.get(bounds, id), new_bounds} do
+      {same, same} ->
+        index
+
+      {old, new} ->
+        root = if old, do: delete(index.root, key(id, old)), else: index.root
+        root = if new, do: insert(root, key(id, new), elem(new, 1)), else: root
+        bounds = if new, do: Map.put(bounds, id, new), else: Map.delete(bounds, id)
+        %{index | root: root, bounds: bounds}
+    end
+  end
+
+  defp key(id, {start_time, _end_time}), do: {start_time, id}
+
+  defp bounds(%{time_points: time_points, constraints: constraints}, id) do
+    start_point = id <> "_start"
+    end_point = id <> "_end"
+
+    if MapSet.member?(time_points, start_point) and MapSet.member?(time_points, end_point) do
+      case Map.get(constraints, {start_point, end_point}) do
+        {duration, duration} when is_number(duration) -> {0, duration}
+        {min, max} when is_number(min) and is_number(max) -> {0, (min + max) / 2}
+        _ -> nil
+      end
+    end
+  end
+
+  defp interval_id(point) when is_binary(point) do
+    cond do
+      String.ends_with?(point, "_start") -> String.replace_suffix(point, "_start", "")
+      String.ends_with?(point, "_end") -> String.replace_suffix(point, "_end", "")
+      true -> nil
+    end
+  end
+
+  defp interval_id(_point), do: nil
+
+  # Right subtree first so that results are prepended in order
+  defp overlapping(nil, _from, _to, acc), do: acc
+  defp overlapping({_key, _end, max_end, _height, _left, _right}, from, _to, acc) when max_end < from, do: acc
+
+  defp overlapping({{start_time, id}, end_time, _max_end, _height, left, right}, from, to, acc) do
+    acc = if start_time <= to, do: overlapping(right, from, to, acc), else: acc
+    acc = if start_time <= to and from <= end_time, do: [{id, start_time, end_time} | acc], else: acc
+    overlapping(left, from, to, acc)
+  end
+
+  defp in_order(nil, acc), do: acc
+
+  defp in_order({{start_time, id}, end_time, _max_end, _height, left, right}, acc),
+    do: in_order(left, [{id, start_time, end_time} | in_order(right, acc)])
+
+  defp insert(nil, key, end_time), do: node(key, end_time, nil, nil)
+
+  defp insert({node_key, node_end, _max_end, _height, left, right}, key, end_time) when key < node_key,
+    do: balance(node_key, node_end, insert(left, key, end_time), right)
+
+  defp insert({node_key, node_end, _max_end, _height, left, right}, key, end_time),
+    do: balance(node_key, node_end, left, insert(right, key, end_time))
+
+  defp delete(nil, _key), do: nil
+
+  defp delete({node_key, node_end, _max_end, _height, left, right}, key) when key < node_key,
+    do: balance(node_key, node_end, delete(left, key), right)
+
+  defp delete({node_key, node_end, _max_end, _height, left, right}, key) when key > node_key,
+    do: balance(node_key, node_end, left, delete(right, key))
+
+  defp delete({_key, _end, _max_end, _height, left, nil}, _key_to_delete), do: left
+  defp delete({_key, _end, _max_end, _height, nil, right}, _key_to_delete), do: right
+
+  defp delete({_key, _end, _max_end, _height, left, right}, _key_to_delete) do
+    {key, end_time, right} = pop_min(right)
+    balance(key, end_time, left, right)
+  end
+
+  defp pop_min({key, end_time, _max_end, _height, nil, right}), do: {key, end_time, right}
+
+  defp pop_min({key, end_time, _max_end, _height, left, right}) do
+    {min_key, min_end, left} = pop_min(left)
+    {min_key, min_end, balance(key, end_time, left, right)}
+  end
+
+  defp balance(key, end_time, left, right) do
+    cond do
+      height(left) > height(right) + 1 -> rotate_right(key, end_time, left, right)
+      height(right) > height(left) + 1 -> rotate_left(key, end_time, left, right)
+      true -> node(key, end_time, left, right)
+    end
+  end
+
+  defp rotate_right(key, end_time, {left_key, left_end, _max_end, _height, outer, inner}, right) do
+    if height(inner) > height(outer) do
+      {inner_key, inner_end, _inner_max, _inner_height, inner_left, inner_right} = inner
+      node(inner_key, inner_end, node(left_key, left_end, outer, inner_left), node(key, end_time, inner_right, right))
+    else
+      node(left_key, left_end, outer, node(key, end_time, inner, right))
+    end
+  end
+
+  defp rotate_left(key, end_time, left, {right_key, right_end, _max_end, _height, inner, outer}) do
+    if height(inner) > height(outer) do
+      {inner_key, inner_end, _inner_max, _inner_height, inner_left, inner_right} = inner
+      node(inner_key, inner_end, node(key, end_time, left, inner_left), node(right_key, right_end, inner_right, outer))
+    else
+      node(right_key, right_end, node(key, end_time, left, inner), outer)
+    end
+  end
+
+  defp node(key, end_time, left, right),
+    do: {key, end_time, end_time |> max_end(left) |> max_end(right), max(height(left), height(right)) + 1, left, right}
+
+  defp max_end(value, nil), do: value
+  defp max_end(value, {_key, _end, max_end, _height, _left, _right}), do: max(value, max_end)
+
+  defp height(nil), do: 0
+  defp height({_key, _end, _max_end, height, _left, _right}), do: height
+end
@@ -14,6 +14,7 @@ defmodule AriaPlanner.Planner.Temporal.STN.Operations do
 
   alias AriaPlanner.Planner.Temporal.Interval
   alias AriaPlanner.Planner.Temporal.STN
+  alias AriaPlanner.Planner.Temporal.STN.{IntervalIndex, PathConsistency}
   # Add Timex for datetime parsing
   use Timex
 
@@ -26,6 +27,9 @@ defmodule AriaPlanner.Planner.Temporal.STN.Operations do
 
   The constraint represents the allowable distance between the time points
   as {min_distance, max_distance}. Supports :infinity for unbounded constraints.
+
+  The STN's `network` is updated incrementally, so `consistent` reflects
+  every path through the new constraint, not only the edge itself.
   """
   @spec add_constraint(STN.t(), time_point(), time_point(), constraint()) :: STN.t()
   def add_constraint(stn, from_point, to_point, {min_dist, max_dist} = constraint)
@@ -47,7 +51,14 @@ defmodule AriaPlanner.Planner.Temporal.STN.Operations do
     {updated_constraints_2, consistent_2} =
       update_single_constraint(updated_constraints_1, {to_point, from_point}, reverse_constraint)
 
-    final_consistent = is_consistent and consistent_1 and consistent_2
+    network =
+      stn.network
+      |> PathConsistency.sync(current_constraints)
+      |> PathConsistency.add_constraint(from_point, to_point, constraint)
+
+    network = %{network | source: updated_constraints_2}
+
+    final_consistent = is_consistent and consistent_1 and consistent_2 and PathConsistency.consistent?(network)
 
     # Debug logging
     if not final_consistent do
@@ -55,13 +66,16 @@ defmodule AriaPlanner.Planner.Temporal.STN.Operations do
 
       Logger.debug("Constraint inconsistency detected: #{from_point} -> #{to_point} #{inspect(constraint)}")
 
-      Logger.debug("Initial consistent: #{is_consistent}, step1: #{consistent_1}, step2: #{consistent_2}")
+      Logger.debug(
+        "Initial consistent: #{is_consistent}, step1: #{consistent_1}, step2: #{consistent_2}, " <>
+          "paths: #{PathConsistency.consistent?(network)}"
+      )
 
       Logger.debug("Reverse constraint: #{inspect(reverse_constraint)}")
     end
 
-    updated_stn = %{stn | constraints: updated_constraints_2, consistent: final_consistent}
-    updated_stn
+    updated_stn = %{stn | constraints: updated_constraints_2, consistent: final_consistent, network: network}
+    %{updated_stn | intervals: IntervalIndex.refresh(stn.intervals, updated_stn, [from_point, to_point])}
   end
 
   @doc """
@@ -142,9 +156,26 @@ defmodule AriaPlanner.Planner.Temporal.STN.Operations do
   def add_time_point(stn, time_point) do
     updated_time_points = MapSet.put(stn.time_points, time_point)
     # No self-constraint needed - distance from point to itself is implicitly zero
-    %{stn | time_points: updated_time_points}
+    network = stn.network |> PathConsistency.sync(stn.constraints) |> PathConsistency.add_point(time_point)
+    intervals = IntervalIndex.sync(stn.intervals, stn)
+    updated_stn = %{stn | time_points: updated_time_points, network: network}
+    %{updated_stn | intervals: IntervalIndex.refresh(intervals, updated_stn, [time_point])}
   end
 
+  @doc """
+  Gets the integer id the STN interned `time_point` as, or `nil`.
+  """
+  @spec time_point_id(STN.t(), time_point()) :: non_neg_integer() | nil
+  def time_point_id(stn, time_point), do: PathConsistency.id(network(stn), time_point)
+
+  @doc """
+  Gets the time point interned as `id`, or `nil`.
+  """
+  @spec time_point_name(STN.t(), non_neg_integer()) :: time_point() | nil
+  def time_point_name(stn, id), do: PathConsistency.name(network(stn), id)
+
+  defp network(stn), do: PathConsistency.sync(stn.network, stn.constraints)
+
   @doc """
   Gets all time points in the STN.
   """
@@ -308,7 +339,9 @@ defmodule AriaPlanner.Planner.Temporal.STN.Operations do
           |> Map.delete(key)
           |> Map.delete(reverse_key)
 
-        %{stn | constraints: updated_constraints}
+        intervals = IntervalIndex.sync(stn.intervals, stn)
+        updated_stn = %{stn | constraints: updated_constraints}
+        %{updated_stn | intervals: IntervalIndex.refresh(intervals, updated_stn, [from_point, to_point])}
 
       _ ->
         # Return original STN if constraint doesn't exist
@@ -0,0 +1,208 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2025-present K. S. Ernest (iFire) Lee
+
+defmodule AriaPlanner.Planner.Temporal.STN.PathConsistency do
+  @moduledoc """
+  Incremental all-pairs shortest paths over an STN's distance graph.
+
+  A constraint `{min, max}` from `a` to `b` means `min <= t(b) - t(a) <= max`,
+  i.e. the edges `a -> b` with weight `max` and `b -> a` with weight `-min`.
+  The network keeps the minimal distance between every pair of time points
+  at all times, so consistency and minimal bounds are lookups.
+
+  Adding an edge `u -> v` of weight `w` only relaxes the pairs whose
+  shortest path can now go through it: every `i` reaching `u` paired with
+  every `j` reachable from `v`, `d(i, j) = min(d(i, j), d(i, u) + w + d(v, j))`.
+  That is O(n²) in the worst case and far less on sparse networks. The edge
+  closes a negative cycle, and the network becomes inconsistent, exactly
+  when `d(v, u) + w < 0`.
+
+  Time points of any term, names or atoms alike, are interned to dense
+  integer ids on first use and keep them for the life of the network,
+  rebuilds included; `id/2` and `name/2` translate. Rows are sparse maps
+  from id to id holding only finite distances.
+  """
+
+  @type point :: term()
+  @type bound :: number() | :infinity | :neg_infinity
+  @type distance :: number() | :infinity
+
+  @type t :: %__MODULE__{
+          ids: %{optional(point()) => non_neg_integer()},
+          names: %{optional(non_neg_integer()) => point()},
+          rows: %{optional(non_neg_integer()) => %{optional(non_neg_integer()) => number()}},
+          consistent: boolean(),
+          source: map() | nil
+        }
+
+  defstruct ids: %{}, names: %{}, rows: %{}, consistent: true, source: nil
+
+  @doc """
+  Creates an empty, consistent network.
+  """
+  @spec new() :: t()
+  def new, do: %__MODULE__{}
+
+  @doc """
+  Builds the network of a `%{{from, to} => {min, max}}` constraint map or a
+  `[{from, to, min, max}]` list, remembering a map as its `source`.
+  """
+  @spec from_constraints(map() | [{point(), point(), bound(), bound()}]) :: t()
+  def from_constraints(constraints) when is_map(constraints), do: sync(new(), constraints)
+
+  def from_constraints(constraints) when is_list(constraints) do
+    Enum.reduce(constraints, new(), fn {from, to, min, max}, network -> add_constraint(network, from, to, {min, max}) end)
+  end
+
+  @doc """
+  Returns the network for `constraints`: `network` itself when it was built
+  from that very map, otherwise one rebuilt from it that keeps `network`'s
+  time point ids.
+  """
+  @spec sync(t() | nil, map()) :: t()
+  def sync(%__MODULE__{source: source} = network, constraints) when source === constraints, do: network
+  def sync(nil, constraints), do: from_constraints(constraints)
+
+  def sync(%__MODULE__{ids: ids, names: names}, constraints) do
+    network =
+      Enum.reduce(constraints, %__MODULE__{ids: ids, names: names}, fn {{from, to}, bounds}, network ->
+        add_constraint(network, from, to, bounds)
+      end)
+
+    %{network | source: constraints}
+  end
+
+  @doc """
+  Adds the time point `point` if the network does not know it yet.
+  """
+  @spec add_point(t(), point()) :: t()
+  def add_point(network, point), do: network |> intern(point) |> elem(1)
+
+  @doc """
+  Adds `min <= t(to) - t(from) <= max` and restores minimal distances.
+  Infinite bounds add no edge.
+  """
+  @spec add_constraint(t(), point(), point(), {bound(), bound()}) :: t()
+  def add_constraint(network, from, to, {min, max}) do
+    {u, network} = intern(network, from)
+    {v, network} = intern(network, to)
+
+    network
+    |> add_edge(u, v, max)
+    |> add_edge(v, u, negate(min))
+  end
+
+  @doc """
+  Integer id of `point`, or `nil` if the network does not know it.
+  """
+  @spec id(t(), point()) :: non_neg_integer() | nil
+  def id(%__MODULE__{ids: ids}, point), do: Map.get(ids, point)
+
+  @doc """
+  Time point interned as `id`, or `nil`.
+  """
+  @spec name(t(), non_neg_integer()) :: point() | nil
+  def name(%__MODULE__{names: names}, id), do: Map.get(names, id)
+
+  @doc """
+  Whether the constraints added so far admit a schedule.
+  """
+  @spec consistent?(t()) :: boolean()
+  def consistent?(%__MODULE__{consistent: consistent}), do: consistent
+
+  @doc """
+  Shortest distance from `from` to `to`, the tightest upper bound on
+  `t(to) - t(from)`.
+  """
+  @spec distance(t(), point(), point()) :: distance()
+  def distance(%__MODULE__{ids: ids} = network, from, to) do
+    case {ids, from == to} do
+      {_ids, true} -> 0
+      {%{^from => u, ^to => v}, false} -> dist(network.rows, u, v)
+      _ -> :infinity
+    end
+  end
+
+  @doc """
+  Minimal `{min, max}` bounds on `t(to) - t(from)` implied by the network.
+  """
+  @spec bounds(t(), point(), point()) :: {bound(), bound()}
+  def bounds(network, from, to), do: {negate(distance(network, to, from)), distance(network, from, to)}
+
+  @doc """
+  Time points known to the network.
+  """
+  @spec points(t()) :: [point()]
+  def points(%__MODULE__{ids: ids}), do: Map.keys(ids)
+
+  defp intern(%__MODULE__{ids: ids} = network, point) do
+    case ids do
+      %{^point => id} ->
+        {id, network}
+
+      _ ->
+        id = map_size(ids)
+        {id, %{network | ids: Map.put(ids, point, id), names: Map.put(network.names, id, point)}}
+    end
+  end
+
+  defp add_edge(%__MODULE__{consistent: false} = network, _u, _v, _weight), do: network
+  defp add_edge(network, _u, _v, :infinity), do: network
+
+  defp add_edge(%__MODULE__{rows: rows} = network, u, v, weight) do
+    cond do
+      not shorter?(weight, dist(rows, u, v)) ->
+        network
+
+      shorter?(add(dist(rows, v, u), weight), 0) ->
+        %{network | consistent: false}
+
+      true ->
+        %{network | rows: relax(rows, u, v, weight)}
+    end
+  end
+
+  defp relax(rows, u, v, weight) do
+    # Every i reaching u, with d(i, u), and every j reachable from v, with d(v, j)
+    sources = [{u, 0} | for({i, row} <- rows, i != u, Map.has_key?(row, u), do: {i, Map.fetch!(row, u)})]
+    targets = [{v, 0} | Map.to_list(Map.get(rows, v, %{}))]
+
+    Enum.reduce(sources, rows, fn {i, to_u}, rows ->
+      row =
+        Enum.reduce(targets, Map.get(rows, i, %{}), fn
+          {^i, _from_v}, row ->
+            row
+
+          {j, from_v}, row ->
+            through = to_u + weight + from_v
+
+            case row do
+              %{^j => current} when current <= through -> row
+              _ -> Map.put(row, j, through)
+            end
+        end)
+
+      Map.put(rows, i, row)
+    end)
+  end
+
+  defp dist(_rows, same, same), do: 0
+
+  defp dist(rows, u, v) do
+    case rows do
+      %{^u => %{^v => distance}} -> distance
+      _ -> :infinity
+    end
+  end
+
+  defp shorter?(:infinity, _other), do: false
+  defp shorter?(_number, :infinity), do: true
+  defp shorter?(a, b), do: a < b
+
+  defp add(:infinity, _weight), do: :infinity
+  defp add(distance, weight), do: distance + weight
+
+  defp negate(:infinity), do: :neg_infinity
+  defp negate(:neg_infinity), do: :infinity
+  defp negate(value), do: -value
+end
@@ -10,9 +10,13 @@ defmodule AriaPlanner.Planner.Temporal.STN.Scheduling do
   - Scheduling operations (finding free slots)
   - Conflict detection
   - Timeline gap analysis and interval merging
+
+  Queries read the STN's `STN.IntervalIndex`, ordered by start time, so
+  overlap and free-slot queries only visit the intervals in their window.
   """
 
   alias AriaPlanner.Planner.Temporal.STN
+  alias AriaPlanner.Planner.Temporal.STN.IntervalIndex
 
   @type constraint :: {number(), number()}
   @type time_point :: String.t()
@@ -28,31 +32,10 @@ defmodule AriaPlanner.Planner.Temporal.STN.Scheduling do
           %{id: String.t(), start_time: number(), end_time: number(), metadata: map()}
         ]
   def get_intervals(stn) do
-    stn.time_points
-    |> MapSet.to_list()
-    |> Enum.filter(&String.ends_with?(&1, "_start"))
-    |> Enum.map(fn start_point ->
-      interval_id = String.replace_suffix(start_point, "_start", "")
-      end_point = "#{interval_id}_end"
-
-      if MapSet.member?(stn.time_points, end_point) do
-        case get_interval_bounds(stn, start_point, end_point) do
-          {:ok, start_time, end_time} ->
-            %{
-              id: interval_id,
-              start_time: start_time,
-              end_time: end_time,
-              metadata: Map.get(stn.metadata, interval_id, %{})
-            }
-
-          {:error, _} ->
-            nil
-        end
-      else
-        nil
-      end
-    end)
-    |> Enum.reject(&is_nil/1)
+    stn.intervals
+    |> IntervalIndex.sync(stn)
+    |> IntervalIndex.to_list()
+    |> Enum.map(&to_interval(stn, &1))
   end
 
   @doc """
@@ -65,10 +48,10 @@ defmodule AriaPlanner.Planner.Temporal.STN.Scheduling do
           %{id: String.t(), start_time: number(), end_time: number(), metadata: map()}
         ]
   def get_overlapping_intervals(stn, query_start, query_end) when query_start <= query_end do
-    get_intervals(stn)
-    |> Enum.filter(fn interval ->
-      interval.start_time <= query_end and query_start <= interval.end_time
-    end)
+    stn.intervals
+    |> IntervalIndex.sync(stn)
+    |> IntervalIndex.overlapping(query_start, query_end)
+    |> Enum.map(&to_interval(stn, &1))
   end
 
   @doc """
@@ -82,12 +65,7 @@ defmodule AriaPlanner.Planner.Temporal.STN.Scheduling do
         ]
   def find_free_slots(stn, duration, window_start, window_end)
       when duration > 0 and window_start <= window_end and window_end - window_start >= duration do
-    occupied_intervals =
-      get_intervals(stn)
-      |> Enum.filter(fn interval ->
-        interval.start_time <= window_end and window_start <= interval.end_time
-      end)
-      |> Enum.sort_by(& &1.start_time)
+    occupied_intervals = get_overlapping_intervals(stn, window_start, window_end)
 
     find_gaps_in_timeline(occupied_intervals, window_start, window_end, duration)
   end
@@ -207,25 +185,8 @@ defmodule AriaPlanner.Planner.Temporal.STN.Scheduling do
 
   # Private helper functions
 
-  defp get_interval_bounds(stn, start_point, end_point) do
-    case get_constraint(stn, start_point, end_point) do
-      {duration, duration} when is_number(duration) ->
-        {:ok, 0, duration}
-
-      {min_duration, max_duration} when is_number(min_duration) and is_number(max_duration) ->
-        avg_duration = (min_duration + max_duration) / 2
-        {:ok, 0, avg_duration}
-
-      nil ->
-        {:error, :no_constraint}
-
-      _ ->
-        {:error, :invalid_constraint}
-    end
-  end
-
-  defp get_constraint(stn, from_point, to_point) do
-    Map.get(stn.constraints, {from_point, to_point})
+  defp to_interval(stn, {id, start_time, end_time}) do
+    %{id: id, start_time: start_time, end_time: end_time, metadata: Map.get(stn.metadata, id, %{})}
   end
 
   defp find_gaps_in_timeline(occupied_intervals, window_start, window_end, required_duration) do
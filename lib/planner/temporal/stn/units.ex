@@ -4,6 +4,7 @@
 defmodule AriaPlanner.Planner.Temporal.STN.Units do
   @moduledoc false
   alias AriaPlanner.Planner.Temporal.STN
+  alias AriaPlanner.Planner.Temporal.STN.IntervalIndex
   alias AriaPlanner.Planner.Temporal.Interval
   # Add Timex for duration parsing
   use Timex
@@ -22,28 +23,15 @@ defmodule AriaPlanner.Planner.Temporal.STN.Units do
       new_resolution = lod_resolution_for_level(new_lod_level)
       scale_factor = old_resolution / new_resolution
 
-      rescaled_constraints =
-        Enum.map(stn.constraints, fn {{from, to}, {min_dist, max_dist}} ->
-          {{from, to}, {round(min_dist * scale_factor), round(max_dist * scale_factor)}}
-        end)
-        |> Map.new()
-
-      updated_stn = %{
+      # The network no longer matches the constraints, so the next query that
+      # needs it rebuilds it, and sees whether rounding made the STN inconsistent
+      %{
         stn
         | lod_level: new_lod_level,
           lod_resolution: new_resolution,
-          constraints: rescaled_constraints
+          constraints: scale_constraints(stn.constraints, scale_factor)
       }
-
-      # Only solve if there are time points to solve
-      if MapSet.size(updated_stn.time_points) > 0 do
-        case AriaStnSolver.solve_stn(updated_stn) do
-          {:ok, solved_stn} -> solved_stn
-          {:error, _} -> updated_stn
-        end
-      else
-        updated_stn
-      end
+      |> sync_intervals(stn)
     end
   end
 
@@ -55,23 +43,9 @@ defmodule AriaPlanner.Planner.Temporal.STN.Units do
     else
       conversion_factor = unit_conversion_factor(stn.time_unit, new_unit)
 
-      converted_constraints =
-        Enum.map(stn.constraints, fn {{from, to}, {min_dist, max_dist}} ->
-          {{from, to}, {round(min_dist * conversion_factor), round(max_dist * conversion_factor)}}
-        end)
-        |> Map.new()
-
-      updated_stn = %{stn | time_unit: new_unit, constraints: converted_constraints}
-
-      # Only solve if there are time points to solve
-      if MapSet.size(updated_stn.time_points) > 0 do
-        case AriaStnSolver.solve_stn(updated_stn) do
-          {:ok, solved_stn} -> solved_stn
-          {:error, _} -> updated_stn
-        end
-      else
-        updated_stn
-      end
+      # The network is left to be rebuilt lazily, as in rescale_lod/2
+      %{stn | time_unit: new_unit, constraints: scale_constraints(stn.constraints, conversion_factor)}
+      |> sync_intervals(stn)
     end
   end
 
@@ -229,6 +203,18 @@ defmodule AriaPlanner.Planner.Temporal.STN.Units do
     round(units * lod_resolution)
   end
 
+  # Every interval's bounds were rescaled, so the index is rebuilt once here rather than on each query
+  defp sync_intervals(updated_stn, stn), do: %{updated_stn | intervals: IntervalIndex.sync(stn.intervals, updated_stn)}
+
+  # Scales every bound, leaving infinite bounds infinite
+  defp scale_constraints(constraints, factor) do
+    Map.new(constraints, fn {pair, {min, max}} -> {pair, {scale_bound(min, factor), scale_bound(max, factor)}} end)
+  end
+
+  defp scale_bound(:infinity, _factor), do: :infinity
+  defp scale_bound(:neg_infinity, _factor), do: :neg_infinity
+  defp scale_bound(bound, factor), do: round(bound * factor)
+
   # Helper function to parse ISO 8601 duration to microseconds
   defp parse_iso8601_duration_to_microseconds(iso_duration) when is_binary(iso_duration) do
     if String.contains?(iso_duration, "/") do
@@ -6,17 +6,22 @@ defmodule AriaPlanner.Solvers.AriaChuffedSolver do
   @moduledoc """
   High-level Chuffed solver interface for AriaPlanner.
 
-  This module provides a convenient Elixir interface to the Chuffed constraint solver,
-  integrating with the planner's constraint solving infrastructure.
+  This module provides a convenient Elixir interface for Chuffed-style FlatZinc solving,
+  integrating with the planner's constraint solving infrastructure. Models are solved in
+  process, so no solver binary has to be installed and nothing is written to disk.
+
+  Every entry point solves in a `SolverPool`, given by the `:pool` option and
+  `SolverPool` by default, so the pool's concurrency limit, back-pressure and
+  timeouts apply to all of them. A full pool answers `{:error, :overloaded}`.
 
   ## Features
 
-  - Solves constraint programming problems using Chuffed
-  - Works directly with FlatZinc (.fzn) files (no MiniZinc)
+  - Solves constraint programming problems in process with `CpSolver`
+  - Works directly with FlatZinc (.fzn) files (no MiniZinc), parsed by `FlatZincParser`
   - Integrates with planning domains
   - Returns structured solutions
 
-  Note: MiniZinc dependencies have been removed. This solver requires direct Chuffed executable.
+  Note: MiniZinc dependencies have been removed, and no external Chuffed executable is needed.
 
   ## Usage
 
@@ -27,39 +32,31 @@ defmodule AriaPlanner.Solvers.AriaChuffedSolver do
       {:ok, solution} = AriaChuffedSolver.solve_flatzinc_file("problem.fzn")
   """
 
-  alias AriaPlanner.Solvers.FlatZincGenerator
+  alias AriaPlanner.Solvers.{FlatZincParser, SolverPool}
   # alias AriaPlanner.Planner.State  # Unused - removed to fix compilation warning
 
   @doc """
-  Checks if Chuffed solver is available.
+  Checks if the solver is available.
 
-  Note: MiniZinc is not used. This checks for direct Chuffed availability.
+  Always true: solving runs in process and needs no external executable.
   """
   @spec available?() :: boolean()
-  def available? do
-    # Check for direct fzn-chuffed executable
-    case System.cmd("which", ["fzn-chuffed"], stderr_to_stdout: true) do
-      {_, 0} -> true
-      _ -> false
-    end
-  rescue
-    _ -> false
-  end
+  def available?, do: true
 
   @doc """
-  Solves constraints using Chuffed solver directly with FlatZinc format.
+  Solves constraints given as FlatZinc or as a `FlatZincGenerator` constraint map.
 
-  Chuffed is a FlatZinc solver and works directly with FlatZinc format.
-  This solver only supports FlatZinc (.fzn) files - no MiniZinc support.
+  This solver only supports FlatZinc (.fzn) files and constraint maps - no MiniZinc support.
 
   ## Parameters
 
-  - `constraints`: Map or list of constraints to solve
+  - `constraints`: Constraint map as `FlatZincGenerator.generate/1` takes
   - `opts`: Options keyword list
     - `:domain_type` - Domain type (e.g., "aircraft_disassembly")
     - `:flatzinc_path` - Path to FlatZinc file
     - `:timeout` - Timeout in milliseconds (default: 60000)
     - `:options` - Additional solver options as JSON string
+    - `:pool` - Solver pool (default: `SolverPool`)
 
   ## Returns
 
@@ -74,78 +71,163 @@ defmodule AriaPlanner.Solvers.AriaChuffedSolver do
         domain_type: "aircraft_disassembly"
       )
   """
-  @spec solve(map() | list(), keyword()) :: {:ok, map()} | {:error, String.t()}
+  @spec solve(map() | list(), keyword()) :: {:ok, map()} | {:error, String.t() | :overloaded}
   def solve(constraints, opts \\ []) do
     domain_type = Keyword.get(opts, :domain_type, "default")
     flatzinc_path = Keyword.get(opts, :flatzinc_path)
-    timeout = Keyword.get(opts, :timeout, 60_000)
-    solver_options = Keyword.get(opts, :options, "{}")
 
     cond do
       flatzinc_path && File.exists?(flatzinc_path) ->
         # Direct FlatZinc solving
-        solve_flatzinc_file(flatzinc_path, solver_options, timeout)
+        solve_flatzinc_file(flatzinc_path, opts)
 
       domain_type != "default" ->
         solve_from_domain(domain_type, constraints, opts)
 
       true ->
-        solve_from_constraints(constraints, solver_options, timeout)
+        solve_from_constraints(constraints, opts)
     end
   end
 
   @doc """
-  Solves a FlatZinc file using Chuffed directly (no MiniZinc).
-
-  Note: MiniZinc is not used. This requires direct fzn-chuffed executable.
+  Solves a FlatZinc file in process (no MiniZinc).
 
   ## Parameters
 
   - `flatzinc_path`: Path to .fzn FlatZinc file
   - `opts`: Options keyword list
+    - `:timeout` - Timeout in milliseconds (default: 60000)
+    - `:pool` - Solver pool (default: `SolverPool`)
 
   ## Returns
 
-  - `{:ok, solution}` - Parsed solution
-  - `{:error, reason}` - Error reason
+  - `{:ok, solution}` - `%{status:, variables:, objective:}`, variables keyed by name
+  - `{:error, reason}` - Error reason, `:overloaded` when the pool is full
   """
-  @spec solve_flatzinc_file(String.t(), keyword()) :: {:ok, map()} | {:error, String.t()}
-  def solve_flatzinc_file(_flatzinc_path, _opts \\ []) do
-    {:error, "Direct Chuffed solver not yet implemented. MiniZinc dependencies have been removed."}
+  @spec solve_flatzinc_file(String.t(), keyword()) :: {:ok, map()} | {:error, String.t() | :overloaded}
+  def solve_flatzinc_file(flatzinc_path, opts \\ []) do
+    with {:ok, model} <- FlatZincParser.parse_file(flatzinc_path) do
+      solve_in_pool(model, opts)
+    end
   end
 
   @doc """
-  Solves a FlatZinc problem using Chuffed directly (no MiniZinc).
-
-  Writes the FlatZinc content to a temporary file and solves it.
+  Solves a FlatZinc problem given as a string, in process (no MiniZinc).
 
   ## Parameters
 
   - `flatzinc_content`: FlatZinc problem as string
-  - `opts`: Options keyword list
+  - `opts`: Options keyword list, as for `solve_flatzinc_file/2`
 
   ## Returns
 
-  - `{:ok, solution}` - Parsed solution
+  - `{:ok, solution}` - `%{status:, variables:, objective:}`, variables keyed by name
   - `{:error, reason}` - Error reason
   """
-  @spec solve_flatzinc(String.t(), keyword()) :: {:ok, map()} | {:error, String.t()}
+  @spec solve_flatzinc(String.t(), keyword()) :: {:ok, map()} | {:error, String.t() | :overloaded}
   def solve_flatzinc(flatzinc_content, opts \\ []) do
-    # Write to temporary file
-    tmp_file = System.tmp_dir!() |> Path.join("chuffed_#{:rand.uniform(1_000_000)}.fzn")
+    with {:ok, model} <- FlatZincParser.parse(flatzinc_content) do
+      solve_in_pool(model, opts)
+    end
+  end
 
-    try do
-      File.write!(tmp_file, flatzinc_content)
-      solve_flatzinc_file(tmp_file, opts)
-    after
-      File.rm(tmp_file)
+  @doc """
+  Solves anytime: returns a stream of improving solutions, so callers can
+  act on a good-enough answer while the search goes on.
+
+  `input` is FlatZinc content or a constraint map. The stream emits
+  `{:solution, solution}` for each solution as it is found, with
+  `:elapsed_ms` since solving started added, then `{:done, result}` with
+  the final result. The search runs in `SolverPool` once the stream is
+  consumed, and is cancelled if the consumer stops early, for example
+  after `Enum.take/2`. The stream must be consumed by one process.
+
+  ## Options
+
+  - `:timeout` - Deadline in milliseconds (default: 60000)
+  - `:gap` - Relative objective gap at which to stop, as for `CpSolver.solve/2`
+  - `:pool` - Solver pool (default: `SolverPool`)
+
+  ## Example
+
+      {:ok, solutions} = AriaChuffedSolver.stream_solutions(flatzinc, timeout: 5_000, gap: 0.05)
+
+      Enum.each(solutions, fn
+        {:solution, %{objective: objective, elapsed_ms: ms}} -> IO.puts("\#{objective} after \#{ms}ms")
+        {:done, result} -> result
+      end)
+  """
+  @spec stream_solutions(String.t() | map(), keyword()) :: {:ok, Enumerable.t()} | {:error, String.t()}
+  def stream_solutions(input, opts \\ [])
+
+  def stream_solutions(flatzinc_content, opts) when is_binary(flatzinc_content) do
+    with {:ok, model} <- FlatZincParser.parse(flatzinc_content) do
+      stream_solutions(model, opts)
     end
   end
 
+  def stream_solutions(model, opts) when is_map(model) do
+    {pool, opts} = Keyword.pop(opts, :pool, SolverPool)
+    opts = Keyword.take(opts, [:timeout, :gap])
+
+    stream =
+      Stream.resource(
+        fn ->
+          pool_monitor = SolverPool.monitor(pool)
+          {SolverPool.async_solve(pool, model, opts), pool_monitor, System.monotonic_time(:millisecond)}
+        end,
+        &next_solution/1,
+        fn
+          {{:ok, request}, pool_monitor, _started} ->
+            Process.demonitor(pool_monitor, [:flush])
+            cancel_solving(pool, request)
+
+          _state ->
+            :ok
+        end
+      )
+
+    {:ok, stream}
+  end
+
   # Private helper functions
 
-  defp solve_flatzinc_file(flatzinc_path, solver_options, timeout) do
-    solve_flatzinc_file(flatzinc_path, timeout: timeout, solver_options: solver_options)
+  defp next_solution(:done), do: {:halt, :done}
+  defp next_solution({{:error, reason}, pool_monitor, _started}) do
+    Process.demonitor(pool_monitor, [:flush])
+    {[{:done, {:error, reason}}], :done}
+  end
+
+  defp next_solution({{:ok, request}, pool_monitor, started} = state) do
+    receive do
+      {^request, {:solution, solution}} ->
+        {[{:solution, Map.put(solution, :elapsed_ms, System.monotonic_time(:millisecond) - started)}], state}
+
+      {^request, {:done, result}} ->
+        Process.demonitor(pool_monitor, [:flush])
+        {[{:done, result}], :done}
+
+      {:DOWN, ^pool_monitor, :process, _pid, reason} ->
+        {[{:done, {:error, "Solver pool down: #{inspect(reason)}"}}], :done}
+    end
+  end
+
+  # Stops a search the consumer no longer wants and drops whatever it already sent
+  defp cancel_solving(pool, request) do
+    SolverPool.cancel(pool, request)
+    flush(request)
+  end
+
+  defp flush(request) do
+    receive do
+      {^request, _message} -> flush(request)
+    after
+      0 -> :ok
+    end
+  end
+
+  defp solve_in_pool(model, opts) do
+    SolverPool.solve(Keyword.get(opts, :pool, SolverPool), model, timeout: Keyword.get(opts, :timeout, 60_000))
   end
 
   defp solve_from_domain(domain_type, _constraints, opts) do
@@ -153,17 +235,17 @@ defmodule AriaPlanner.Solvers.AriaChuffedSolver do
     flatzinc_path = find_domain_flatzinc(domain_type)
 
     if flatzinc_path do
-      solve_flatzinc_file(flatzinc_path, Keyword.get(opts, :options, "{}"), Keyword.get(opts, :timeout, 60_000))
+      solve_flatzinc_file(flatzinc_path, opts)
     else
       {:error, "No FlatZinc file found for domain: #{domain_type}. Provide :flatzinc_path option."}
     end
   end
 
-  defp solve_from_constraints(constraints, solver_options, timeout) do
-    # Convert constraints to FlatZinc format using EEx template
-    flatzinc = FlatZincGenerator.generate(constraints)
-    solve_flatzinc(flatzinc, timeout: timeout, solver_options: solver_options)
-  end
+  # The constraint map is what FlatZinc would be parsed into, so it is solved without a round trip through text
+  defp solve_from_constraints(constraints, opts) when is_map(constraints), do: solve_in_pool(constraints, opts)
+
+  defp solve_from_constraints(_constraints, _opts),
+    do: {:error, "Constraints must be a map with :variables, :constraints and optional :objective"}
 
   defp find_domain_flatzinc(domain_type) do
     # Look for FlatZinc files in thirdparty directories
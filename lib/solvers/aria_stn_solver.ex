@@ -5,77 +5,82 @@ defmodule AriaStnSolver do
   @moduledoc """
   STN Solver for temporal constraint networks.
 
-  This module provides STN consistency checking and solving capabilities.
+  Consistency is decided by `AriaPlanner.Planner.Temporal.STN.PathConsistency`,
+  which detects negative cycles through any number of constraints.
   """
 
-  @type constraint :: {atom(), atom(), number(), number()}
+  alias AriaPlanner.Planner.Temporal.STN
+  alias AriaPlanner.Planner.Temporal.STN.{Batch, Consistency, Dispatch, IntervalIndex, PathConsistency}
+
+  @type constraint :: {term(), term(), number(), number()}
   @type stn :: map() | list()
 
   @doc """
   Checks if a list of constraints is consistent.
 
-  Returns {:consistent, solution} or {:inconsistent, reason}
+  Returns `{:consistent, bounds}`, with the minimal `{min, max}` implied for
+  every constrained `{from, to}` pair, or `{:inconsistent, reason}`.
   """
   @spec check_consistency([constraint()]) :: {:consistent, map()} | {:inconsistent, String.t()}
   def check_consistency(constraints) when is_list(constraints) do
-    # Check for basic validity
     if not Enum.all?(constraints, fn {_from, _to, min, max} -> min <= max end) do
       {:inconsistent, "Invalid constraint bounds"}
     else
-      # Check for negative cycles using Floyd-Warshall algorithm
-      # Build a graph and check for negative cycles
-      case check_negative_cycles(constraints) do
-        true -> {:inconsistent, "Negative cycle detected"}
-        false -> {:consistent, %{}}
+      network = PathConsistency.from_constraints(constraints)
+
+      if PathConsistency.consistent?(network) do
+        {:consistent,
+         Map.new(constraints, fn {from, to, _min, _max} ->
+           {{from, to}, PathConsistency.bounds(network, from, to)}
+         end)}
+      else
+        {:inconsistent, "Negative cycle detected"}
       end
     end
   end
 
   def check_consistency(_), do: {:inconsistent, "Invalid constraint format"}
 
-  # Check for negative cycles in the constraint graph
-  # A negative cycle means the constraints are inconsistent
-  # For STN: if we have a -> b with min and b -> a with min, and both mins are positive,
-  # that creates a cycle where both must be after each other, which is impossible
-  defp check_negative_cycles(constraints) do
-    # Build bidirectional constraint map
-    constraint_map =
-      Enum.reduce(constraints, %{}, fn {from, to, min_dist, _max_dist}, acc ->
-        key = {from, to}
-        Map.put(acc, key, min_dist)
-      end)
-
-    # Check for cycles: if we have both (a, b) and (b, a) with positive min distances,
-    # that's inconsistent (both must be after each other)
-    Enum.any?(constraints, fn {from, to, min_dist, _max_dist} ->
-      reverse_key = {to, from}
-      reverse_min = Map.get(constraint_map, reverse_key)
-
-      # If both directions have positive minimum distances, it's inconsistent
-      if reverse_min != nil and min_dist > 0 and reverse_min > 0 do
-        # Found inconsistent cycle
-        true
-      else
-        false
-      end
-    end)
-  end
-
   @doc """
-  Solves an STN and returns a solution.
+  Solves an STN.
+
+  An `%STN{}` comes back with every constraint tightened to the minimal
+  bounds its network implies. Constraint maps and lists come back in
+  dispatchable form, see `AriaPlanner.Planner.Temporal.STN.Dispatch`, from
+  which `Dispatch.schedule/1` gives concrete times.
 
   Returns {:ok, solution} or {:error, reason}
   """
-  @spec solve_stn(stn()) :: {:ok, map()} | {:error, String.t()}
-  def solve_stn(stn) when is_map(stn) do
-    # Stub implementation - return a simple solution
-    {:ok, %{solution: "stub", stn: stn}}
-  end
+  @spec solve_stn(stn()) :: {:ok, STN.t() | Dispatch.t()} | {:error, term()}
+  def solve_stn(%STN{} = stn) do
+    network = Consistency.network(stn)
 
-  def solve_stn(stn) when is_list(stn) do
-    # Handle list format
-    {:ok, %{solution: "stub", constraints: stn}}
+    if PathConsistency.consistent?(network) do
+      constraints =
+        Map.new(stn.constraints, fn {{from, to} = pair, _} -> {pair, PathConsistency.bounds(network, from, to)} end)
+
+      solved = %STN{stn | constraints: constraints, consistent: true, network: %{network | source: constraints}}
+
+      # Kept with the tightened constraints so that scheduling queries on the result do not rebuild it
+      {:ok, %STN{solved | intervals: IntervalIndex.sync(stn.intervals, solved)}}
+    else
+      {:error, "Negative cycle detected"}
+    end
   end
 
+  def solve_stn(stn) when is_map(stn) or is_list(stn), do: Dispatch.new(stn)
+
   def solve_stn(_), do: {:error, "Invalid STN format"}
+
+  @doc """
+  Solves many STNs at once, for example one per candidate schedule.
+
+  Returns one `{:consistent, network}` with the minimal
+  `PathConsistency` network, `{:inconsistent, reason}`, or
+  `{:error, :timeout}` when its chunk overran `:timeout`, per STN and in
+  order. See `AriaPlanner.Planner.Temporal.STN.Batch.solve_batch/2`
+  for the accepted formats and options.
+  """
+  @spec solve_batch([stn()], keyword()) :: [Batch.result()]
+  def solve_batch(stns, opts \\ []) when is_list(stns), do: Batch.solve_batch(stns, opts)
 end
@@ -0,0 +1,650 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2025-present K. S. Ernest (iFire) Lee
+
+defmodule AriaPlanner.Solvers.CpSolver do
+  @moduledoc """
+  In-process finite-domain constraint solver for the models
+  `FlatZincGenerator` describes.
+
+  A model is the map `FlatZincGenerator.generate/1` takes: `:variables`
+  (`{name, :int, min, max}` or `{name, :bool}`), `:constraints` and an
+  optional `:objective` (`{:minimize, var}` or `{:maximize, var}`).
+  Supported constraints:
+
+    * `:int_eq`, `:int_ne`, `:int_le`, `:int_lt`, `:int_ge`, `:int_gt` and
+      `:bool_eq` between expressions built from variables, integers,
+      `:+`, `:-`, `:*`, `:/` (integer division), `:mod` and `{:sum, terms}`
+    * `:bool_and`, `:bool_or` and `:bool_not` over such expressions, true
+      when non-zero
+    * `{:all_different, vars}`
+    * `{:array_element, {:array, elements}, index, value}`, with a
+      1-based `index`
+    * `{:global_cardinality, vars, low, high}`, where `low` and `high` are
+      `{:array, counts}` bounding how often each value `1..length(counts)`
+      is taken
+
+  Domains are bounds with removed values. Linear relations propagate
+  bounds; `all_different`, `element` and `global_cardinality` propagate
+  by value; other expressions are checked once their variables are fixed.
+  Propagators run from a queue woken by domain changes. Search branches
+  on the variable with the narrowest domain, trying its smallest value
+  first, and objectives are optimised by branch and bound.
+  """
+
+  @type name :: atom() | String.t()
+  @type result :: %{
+          status: String.t(),
+          variables: %{optional(name()) => integer() | boolean()},
+          objective: integer() | nil
+        }
+
+  @doc """
+  Solves `model`.
+
+  Returns the first solution found, or the optimal one when the model has
+  an objective, with `status` `"satisfied"` or `"optimal"`. When time runs
+  out during optimisation, or a solution is within `:gap` of the
+  objective's bound, the best solution so far is returned as
+  `"satisfied"`.
+
+  ## Options
+
+    * `:timeout` - milliseconds allowed. Defaults to `60_000`
+    * `:on_solution` - called with each solution as it is found, every
+      improving one when optimising, before `solve/2` returns
+    * `:gap` - relative objective gap at which optimisation stops:
+      `|objective - bound| <= gap * max(|objective|, 1)`, the bound being
+      the best objective value propagation allows before search
+  """
+  @spec solve(map(), keyword()) :: {:ok, result()} | {:error, String.t()}
+  def solve(model, opts \\ []) when is_map(model) do
+    deadline = System.monotonic_time(:millisecond) + Keyword.get(opts, :timeout, 60_000)
+
+    with {:ok, compiled} <- compile(model) do
+      compiled = Map.put(compiled, :on_solution, Keyword.get(opts, :on_solution, fn _solution -> :ok end))
+
+      case compiled.objective do
+        nil ->
+          satisfy(compiled, deadline)
+
+        objective ->
+          compiled
+          |> Map.put(:gap, Keyword.get(opts, :gap))
+          |> Map.put(:bound, bound(compiled, objective))
+          |> optimize(objective, deadline, nil)
+      end
+    end
+  catch
+    {:cp_error, message} -> {:error, message}
+  end
+
+  # Model compilation
+
+  defp compile(model) do
+    variables = Map.get(model, :variables, [])
+    names = variables |> Enum.map(&elem(&1, 0)) |> List.to_tuple()
+    index = names |> Tuple.to_list() |> Enum.with_index() |> Map.new()
+    bools = for {name, :bool} <- variables, into: MapSet.new(), do: Map.fetch!(index, name)
+
+    domains =
+      variables
+      |> Enum.with_index()
+      |> Map.new(fn
+        {{_name, :int, min, max}, i} when is_integer(min) and is_integer(max) -> {i, {min, max, MapSet.new()}}
+        {{_name, :bool}, i} -> {i, {0, 1, MapSet.new()}}
+        {variable, _i} -> throw({:cp_error, "Unsupported variable: #{inspect(variable)}"})
+      end)
+
+    propagators =
+      model
+      |> Map.get(:constraints, [])
+      |> Enum.flat_map(&compile_constraint(&1, index))
+      |> List.to_tuple()
+
+    watchers =
+      propagators
+      |> Tuple.to_list()
+      |> Enum.with_index()
+      |> Enum.flat_map(fn {propagator, p} -> for var <- scope(propagator), do: {var, p} end)
+      |> Enum.group_by(&elem(&1, 0), &elem(&1, 1))
+      |> Map.new(fn {var, ps} -> {var, Enum.uniq(ps)} end)
+
+    objective =
+      case Map.get(model, :objective) do
+        nil -> nil
+        {sense, var} when sense in [:minimize, :maximize] -> {sense, lookup(index, var)}
+        other -> throw({:cp_error, "Unsupported objective: #{inspect(other)}"})
+      end
+
+    {:ok,
+     %{
+       names: names,
+       bools: bools,
+       domains: domains,
+       propagators: propagators,
+       watchers: watchers,
+       objective: objective
+     }}
+  end
+
+  defp compile_constraint({relation, left, right}, index)
+       when relation in [:int_eq, :int_ne, :int_le, :int_lt, :int_ge, :int_gt, :bool_eq] do
+    compile_relation(relation, {:-, left, right}, index)
+  end
+
+  defp compile_constraint({:bool_not, expr}, index), do: compile_relation(:int_eq, expr, index)
+  defp compile_constraint({:bool_and, left, right}, index), do: truthy(left, index) ++ truthy(right, index)
+
+  defp compile_constraint({:bool_or, left, right}, index) do
+    [{:or, [resolve(left, index), resolve(right, index)]}]
+  end
+
+  defp compile_constraint({:all_different, vars}, index), do: [{:all_different, Enum.map(vars, &lookup(index, &1))}]
+
+  defp compile_constraint({:array_element, {:array, elements}, idx, value}, index) do
+    [{:element, operand(idx, index), Enum.map(elements, &operand(&1, index)) |> List.to_tuple(), operand(value, index)}]
+  end
+
+  defp compile_constraint({:global_cardinality, vars, {:array, low}, {:array, high}}, index)
+       when length(low) == length(high) do
+    [{:cardinality, Enum.map(vars, &lookup(index, &1)), List.to_tuple(low), List.to_tuple(high)}]
+  end
+
+  defp compile_constraint(constraint, _index), do: throw({:cp_error, "Unsupported constraint: #{inspect(constraint)}"})
+
+  # `expr != 0`
+  defp truthy(expr, index) do
+    case resolve(expr, index) do
+      {:var, var} -> [{:linear, [{var, 1}], 0, :ne}]
+      resolved -> [{:check, vars(resolved), {:ne, resolved, {:const, 0}}}]
+    end
+  end
+
+  # `expr relation 0`, as `sum(a * x) + c op 0` with op one of :eq, :ne and :le when linear
+  defp compile_relation(relation, expr, index) do
+    resolved = resolve(expr, index)
+
+    case linearize(resolved) do
+      {:ok, terms, constant} ->
+        terms = terms |> Enum.reject(fn {_var, coeff} -> coeff == 0 end) |> Enum.sort()
+
+        case relation do
+          eq when eq in [:int_eq, :bool_eq] -> [{:linear, terms, constant, :eq}]
+          :int_ne -> [{:linear, terms, constant, :ne}]
+          :int_le -> [{:linear, terms, constant, :le}]
+          :int_lt -> [{:linear, terms, constant + 1, :le}]
+          :int_ge -> [{:linear, negate(terms), -constant, :le}]
+          :int_gt -> [{:linear, negate(terms), -constant + 1, :le}]
+        end
+
+      :nonlinear ->
+        op = %{int_eq: :eq, bool_eq: :eq, int_ne: :ne, int_le: :le, int_lt: :lt, int_ge: :ge, int_gt: :gt}
+        [{:check, vars(resolved), {Map.fetch!(op, relation), resolved, {:const, 0}}}]
+    end
+  end
+
+  defp negate(terms), do: Enum.map(terms, fn {var, coeff} -> {var, -coeff} end)
+
+  # Expressions with variables resolved to `{:var, index}` and literals to `{:const, value}`
+  defp resolve({op, left, right}, index) when op in [:+, :-, :*, :/, :mod],
+    do: {op, resolve(left, index), resolve(right, index)}
+
+  defp resolve({:sum, terms}, index), do: {:sum, Enum.map(terms, &resolve(&1, index))}
+  defp resolve(value, _index) when is_integer(value), do: {:const, value}
+  defp resolve(true, _index), do: {:const, 1}
+  defp resolve(false, _index), do: {:const, 0}
+  defp resolve(name, index) when is_atom(name) or is_binary(name), do: {:var, lookup(index, name)}
+  defp resolve(expr, _index), do: throw({:cp_error, "Unsupported expression: #{inspect(expr)}"})
+
+  defp operand(expr, index) do
+    case resolve(expr, index) do
+      {:var, var} -> {:var, var}
+      {:const, value} -> {:const, value}
+      other -> throw({:cp_error, "Expected a variable or integer, got: #{inspect(other)}"})
+    end
+  end
+
+  defp lookup(index, name) do
+    case index do
+      %{^name => var} -> var
+      _ -> throw({:cp_error, "Unknown variable: #{inspect(name)}"})
+    end
+  end
+
+  defp linearize({:const, value}), do: {:ok, [], value}
+  defp linearize({:var, var}), do: {:ok, [{var, 1}], 0}
+
+  defp linearize({:+, left, right}), do: combine(linearize(left), linearize(right), 1)
+  defp linearize({:-, left, right}), do: combine(linearize(left), linearize(right), -1)
+
+  defp linearize({:sum, terms}) do
+    Enum.reduce(terms, {:ok, [], 0}, fn term, acc -> combine(acc, linearize(term), 1) end)
+  end
+
+  defp linearize({:*, {:const, factor}, expr}), do: scale(linearize(expr), factor)
+  defp linearize({:*, expr, {:const, factor}}), do: scale(linearize(expr), factor)
+  defp linearize(_expr), do: :nonlinear
+
+  defp combine({:ok, left, left_constant}, {:ok, right, right_constant}, sign) do
+    terms =
+      Enum.reduce(right, Map.new(left), fn {var, coeff}, terms ->
+        Map.update(terms, var, sign * coeff, &(&1 + sign * coeff))
+      end)
+
+    {:ok, Map.to_list(terms), left_constant + sign * right_constant}
+  end
+
+  defp combine(_left, _right, _sign), do: :nonlinear
+
+  defp scale({:ok, terms, constant}, factor),
+    do: {:ok, Enum.map(terms, fn {var, coeff} -> {var, coeff * factor} end), constant * factor}
+
+  defp scale(:nonlinear, _factor), do: :nonlinear
+
+  defp vars({:var, var}), do: [var]
+  defp vars({:const, _value}), do: []
+  defp vars({_op, left, right}), do: Enum.uniq(vars(left) ++ vars(right))
+  defp vars({:sum, terms}), do: terms |> Enum.flat_map(&vars/1) |> Enum.uniq()
+
+  defp scope({:linear, terms, _constant, _op}), do: Enum.map(terms, &elem(&1, 0))
+  defp scope({:check, vars, _relation}), do: vars
+  defp scope({:or, operands}), do: Enum.flat_map(operands, &vars/1)
+  defp scope({:all_different, vars}), do: vars
+  defp scope({:cardinality, vars, _low, _high}), do: vars
+
+  defp scope({:element, idx, elements, value}),
+    do: Enum.flat_map([idx, value | Tuple.to_list(elements)], &vars/1)
+
+  # Search
+
+  defp satisfy(compiled, deadline) do
+    case search(compiled, compiled.domains, deadline) do
+      {:solution, domains} -> {:ok, found(compiled, domains, "satisfied")}
+      :fail -> {:error, "Unsatisfiable"}
+      :timeout -> {:error, "Timeout"}
+    end
+  end
+
+  # Branch and bound by restarting with the objective bounded by the incumbent
+  defp optimize(compiled, {sense, var} = objective, deadline, best) do
+    domains =
+      case {best, sense} do
+        {nil, _sense} -> {:ok, compiled.domains}
+        {best, :minimize} -> restrict(compiled.domains, var, :neg_infinity, best.objective - 1)
+        {best, :maximize} -> restrict(compiled.domains, var, best.objective + 1, :infinity)
+      end
+
+    outcome =
+      case domains do
+        {:ok, domains} -> search(compiled, domains, deadline)
+        :fail -> :fail
+      end
+
+    case {outcome, best} do
+      {{:solution, domains}, _best} ->
+        best = found(compiled, domains, "satisfied")
+
+        cond do
+          best.objective == compiled.bound -> {:ok, %{best | status: "optimal"}}
+          within_gap?(compiled, best) -> {:ok, best}
+          true -> optimize(compiled, objective, deadline, best)
+        end
+
+      {:fail, nil} -> {:error, "Unsatisfiable"}
+      {:fail, best} -> {:ok, %{best | status: "optimal"}}
+      {:timeout, nil} -> {:error, "Timeout"}
+      {:timeout, best} -> {:ok, best}
+    end
+  end
+
+  # Best objective value left after propagating the model, before any search
+  defp bound(compiled, {sense, var}) do
+    case propagate(compiled, compiled.domains, all_propagators(compiled)) do
+      {:ok, domains} when sense == :minimize -> domains |> Map.fetch!(var) |> elem(0)
+      {:ok, domains} -> domains |> Map.fetch!(var) |> elem(1)
+      :fail -> nil
+    end
+  end
+
+  defp within_gap?(%{gap: nil}, _best), do: false
+  defp within_gap?(%{gap: gap, bound: bound}, best),
+    do: abs(best.objective - bound) <= gap * max(abs(best.objective), 1)
+
+  defp search(compiled, domains, deadline) do
+    case propagate(compiled, domains, all_propagators(compiled)) do
+      {:ok, domains} -> branch(compiled, domains, deadline)
+      :fail -> :fail
+    end
+  end
+
+  defp all_propagators(compiled), do: Enum.to_list(0..(tuple_size(compiled.propagators) - 1)//1)
+
+  defp branch(compiled, domains, deadline) do
+    if System.monotonic_time(:millisecond) > deadline do
+      :timeout
+    else
+      case narrowest(domains) do
+        nil ->
+          {:solution, domains}
+
+        {var, {min, _max, _holes}} ->
+          with :fail <- try_value(compiled, domains, var, min, deadline) do
+            case remove(domains, var, min) do
+              {:ok, domains} -> propagate_and_branch(compiled, domains, var, deadline)
+              :fail -> :fail
+            end
+          end
+      end
+    end
+  end
+
+  defp try_value(compiled, domains, var, value, deadline) do
+    case restrict(domains, var, value, value) do
+      {:ok, domains} -> propagate_and_branch(compiled, domains, var, deadline)
+      :fail -> :fail
+    end
+  end
+
+  defp propagate_and_branch(compiled, domains, var, deadline) do
+    case propagate(compiled, domains, Map.get(compiled.watchers, var, [])) do
+      {:ok, domains} -> branch(compiled, domains, deadline)
+      :fail -> :fail
+    end
+  end
+
+  defp narrowest(domains) do
+    domains
+    |> Enum.reject(fn {_var, {min, max, _holes}} -> min == max end)
+    |> Enum.min_by(fn {var, {min, max, _holes}} -> {max - min, var} end, fn -> nil end)
+  end
+
+  defp found(compiled, domains, status) do
+    solution = result(compiled, domains, status)
+    compiled.on_solution.(solution)
+    solution
+  end
+
+  defp result(compiled, domains, status) do
+    variables =
+      Map.new(domains, fn {var, {value, value, _holes}} ->
+        name = elem(compiled.names, var)
+        {name, if(MapSet.member?(compiled.bools, var), do: value == 1, else: value)}
+      end)
+
+    objective =
+      case compiled.objective do
+        nil -> nil
+        {_sense, var} -> domains |> Map.fetch!(var) |> elem(0)
+      end
+
+    %{status: status, variables: variables, objective: objective}
+  end
+
+  # Propagation queue
+
+  defp propagate(_compiled, domains, []), do: {:ok, domains}
+
+  defp propagate(compiled, domains, queue) do
+    propagate(compiled, domains, queue, MapSet.new(queue))
+  end
+
+  defp propagate(_compiled, domains, [], _queued), do: {:ok, domains}
+
+  defp propagate(compiled, domains, [p | queue], queued) do
+    propagator = elem(compiled.propagators, p)
+    queued = MapSet.delete(queued, p)
+
+    case run(propagator, domains) do
+      :fail ->
+        :fail
+
+      {:ok, updated} ->
+        woken =
+          for var <- scope(propagator),
+              Map.fetch!(updated, var) != Map.fetch!(domains, var),
+              q <- Map.get(compiled.watchers, var, []),
+              not MapSet.member?(queued, q),
+              uniq: true,
+              do: q
+
+        propagate(compiled, updated, queue ++ woken, Enum.into(woken, queued))
+    end
+  end
+
+  # Propagators
+
+  defp run({:linear, terms, constant, :le}, domains), do: linear_le(terms, constant, domains)
+
+  defp run({:linear, terms, constant, :eq}, domains) do
+    with {:ok, domains} <- linear_le(terms, constant, domains) do
+      linear_le(negate(terms), -constant, domains)
+    end
+  end
+
+  defp run({:linear, terms, constant, :ne}, domains) do
+    case Enum.reject(terms, fn {var, _coeff} -> fixed?(domains, var) end) do
+      [] ->
+        if linear_value(terms, constant, domains) != 0, do: {:ok, domains}, else: :fail
+
+      [{var, coeff}] ->
+        rest = linear_value(List.keydelete(terms, var, 0), constant, domains)
+        if rem(rest, coeff) == 0, do: remove(domains, var, div(-rest, coeff)), else: {:ok, domains}
+
+      _unfixed ->
+        {:ok, domains}
+    end
+  end
+
+  defp run({:check, vars, relation}, domains) do
+    cond do
+      not Enum.all?(vars, &fixed?(domains, &1)) -> {:ok, domains}
+      holds?(relation, domains) -> {:ok, domains}
+      true -> :fail
+    end
+  end
+
+  defp run({:or, operands}, domains) do
+    case Enum.reject(operands, &(known(&1, domains) == {:ok, false})) do
+      [] ->
+        :fail
+
+      [{:var, var}] ->
+        remove(domains, var, 0)
+
+      _remaining ->
+        {:ok, domains}
+    end
+  end
+
+  defp run({:all_different, vars}, domains) do
+    values = for var <- vars, fixed?(domains, var), do: value(domains, var)
+
+    if length(Enum.uniq(values)) < length(values) do
+      :fail
+    else
+      vars
+      |> Enum.reject(&fixed?(domains, &1))
+      |> reduce_vars(domains, &remove_all(&2, &1, values))
+    end
+  end
+
+  defp run({:element, idx, elements, value}, domains) do
+    with {:ok, domains} <- restrict_operand(domains, idx, 1, tuple_size(elements)) do
+      candidates = for i <- members(domains, idx), overlaps?(domains, elem(elements, i - 1), value), do: i
+
+      with {:ok, domains} <- keep_operand(domains, idx, candidates) do
+        low = candidates |> Enum.map(&operand_min(domains, elem(elements, &1 - 1))) |> Enum.min()
+        high = candidates |> Enum.map(&operand_max(domains, elem(elements, &1 - 1))) |> Enum.max()
+
+        case {restrict_operand(domains, value, low, high), candidates} do
+          {{:ok, domains}, [i]} -> equal(domains, elem(elements, i - 1), value)
+          {outcome, _candidates} -> outcome
+        end
+      end
+    end
+  end
+
+  defp run({:cardinality, vars, low, high}, domains) do
+    reduce_vars(1..tuple_size(low)//1, domains, fn v, domains ->
+      fixed = Enum.count(vars, &(fixed?(domains, &1) and value(domains, &1) == v))
+      possible = Enum.filter(vars, &(not fixed?(domains, &1) and contains?(domains, &1, v)))
+
+      cond do
+        fixed > elem(high, v - 1) or fixed + length(possible) < elem(low, v - 1) -> :fail
+        fixed == elem(high, v - 1) -> reduce_vars(possible, domains, &remove(&2, &1, v))
+        fixed + length(possible) == elem(low, v - 1) -> reduce_vars(possible, domains, &restrict(&2, &1, v, v))
+        true -> {:ok, domains}
+      end
+    end)
+  end
+
+  defp reduce_vars(vars, domains, fun) do
+    Enum.reduce_while(vars, {:ok, domains}, fn var, {:ok, domains} ->
+      case fun.(var, domains) do
+        {:ok, domains} -> {:cont, {:ok, domains}}
+        :fail -> {:halt, :fail}
+      end
+    end)
+  end
+
+  # sum(a * x) + c <= 0 on bounds
+  defp linear_le(terms, constant, domains) do
+    minimum = Enum.reduce(terms, constant, fn {var, coeff}, acc -> acc + term_min(domains, var, coeff) end)
+
+    if minimum > 0 do
+      :fail
+    else
+      reduce_vars(terms, domains, fn {var, coeff}, domains ->
+        slack = -(minimum - term_min(domains, var, coeff))
+
+        if coeff > 0,
+          do: restrict(domains, var, :neg_infinity, floor_div(slack, coeff)),
+          else: restrict(domains, var, ceil_div(slack, coeff), :infinity)
+      end)
+    end
+  end
+
+  defp term_min(domains, var, coeff) do
+    {min, max, _holes} = Map.fetch!(domains, var)
+    if coeff > 0, do: coeff * min, else: coeff * max
+  end
+
+  defp linear_value(terms, constant, domains),
+    do: Enum.reduce(terms, constant, fn {var, coeff}, acc -> acc + coeff * value(domains, var) end)
+
+  defp floor_div(a, b), do: Integer.floor_div(a, b)
+  defp ceil_div(a, b), do: -Integer.floor_div(-a, b)
+
+  defp holds?({op, left, right}, domains) do
+    case {eval(left, domains), eval(right, domains)} do
+      {nil, _right} -> false
+      {_left, nil} -> false
+      {left, right} when op == :eq -> left == right
+      {left, right} when op == :ne -> left != right
+      {left, right} when op == :le -> left <= right
+      {left, right} when op == :lt -> left < right
+      {left, right} when op == :ge -> left >= right
+      {left, right} when op == :gt -> left > right
+    end
+  end
+
+  # `nil` when dividing by zero, which makes any relation over it false
+  defp eval({:const, value}, _domains), do: value
+  defp eval({:var, var}, domains), do: value(domains, var)
+  defp eval({:sum, terms}, domains), do: Enum.reduce(terms, 0, &arithmetic(:+, eval(&1, domains), &2))
+  defp eval({op, left, right}, domains), do: arithmetic(op, eval(left, domains), eval(right, domains))
+
+  defp arithmetic(_op, nil, _right), do: nil
+  defp arithmetic(_op, _left, nil), do: nil
+  defp arithmetic(:+, left, right), do: left + right
+  defp arithmetic(:-, left, right), do: left - right
+  defp arithmetic(:*, left, right), do: left * right
+  defp arithmetic(op, _left, 0) when op in [:/, :mod], do: nil
+  defp arithmetic(:/, left, right), do: div(left, right)
+  defp arithmetic(:mod, left, right), do: rem(left, right)
+
+  defp known(expr, domains) do
+    if Enum.all?(vars(expr), &fixed?(domains, &1)), do: {:ok, eval(expr, domains) not in [0, nil]}, else: :unknown
+  end
+
+  # Operands: `{:var, index}` or `{:const, value}`
+
+  defp members(domains, {:var, var}) do
+    {min, max, holes} = Map.fetch!(domains, var)
+    for value <- min..max//1, not MapSet.member?(holes, value), do: value
+  end
+
+  defp members(_domains, {:const, value}), do: [value]
+
+  # Exact against a constant, on bounds between two variables
+  defp overlaps?(domains, {:const, value}, {:var, var}), do: contains?(domains, var, value)
+  defp overlaps?(domains, {:var, var}, {:const, value}), do: contains?(domains, var, value)
+  defp overlaps?(_domains, {:const, left}, {:const, right}), do: left == right
+
+  defp overlaps?(domains, left, right) do
+    operand_min(domains, left) <= operand_max(domains, right) and
+      operand_min(domains, right) <= operand_max(domains, left)
+  end
+
+  defp operand_min(domains, {:var, var}), do: domains |> Map.fetch!(var) |> elem(0)
+  defp operand_min(_domains, {:const, value}), do: value
+  defp operand_max(domains, {:var, var}), do: domains |> Map.fetch!(var) |> elem(1)
+  defp operand_max(_domains, {:const, value}), do: value
+
+  defp restrict_operand(domains, {:var, var}, low, high), do: restrict(domains, var, low, high)
+  defp restrict_operand(domains, {:const, value}, low, high) when low <= value and value <= high, do: {:ok, domains}
+  defp restrict_operand(_domains, {:const, _value}, _low, _high), do: :fail
+
+  defp keep_operand(domains, {:var, var}, values) do
+    remove_all(domains, var, members(domains, {:var, var}) -- values)
+  end
+
+  defp keep_operand(domains, {:const, value}, values), do: if(value in values, do: {:ok, domains}, else: :fail)
+
+  defp equal(domains, left, right) do
+    with {:ok, domains} <- restrict_operand(domains, left, operand_min(domains, right), operand_max(domains, right)) do
+      restrict_operand(domains, right, operand_min(domains, left), operand_max(domains, left))
+    end
+  end
+
+  # Domains: `{min, max, removed values}`
+
+  defp fixed?(domains, var), do: match?({value, value, _holes}, Map.fetch!(domains, var))
+  defp value(domains, var), do: domains |> Map.fetch!(var) |> elem(0)
+
+  defp contains?(domains, var, value) do
+    {min, max, holes} = Map.fetch!(domains, var)
+    min <= value and value <= max and not MapSet.member?(holes, value)
+  end
+
+  defp restrict(domains, var, low, high) do
+    {min, max, holes} = Map.fetch!(domains, var)
+    min = if low == :neg_infinity, do: min, else: max(min, low)
+    max = if high == :infinity, do: max, else: min(max, high)
+    min = skip_up(min, max, holes)
+    max = skip_down(max, min, holes)
+
+    if min > max, do: :fail, else: {:ok, Map.put(domains, var, {min, max, holes})}
+  end
+
+  defp remove(domains, var, value) do
+    {min, max, holes} = Map.fetch!(domains, var)
+
+    cond do
+      value < min or value > max -> {:ok, domains}
+      value == min -> restrict(domains, var, value + 1, :infinity)
+      value == max -> restrict(domains, var, :neg_infinity, value - 1)
+      true -> {:ok, Map.put(domains, var, {min, max, MapSet.put(holes, value)})}
+    end
+  end
+
+  defp remove_all(domains, var, values), do: reduce_vars(values, domains, &remove(&2, var, &1))
+
+  defp skip_up(min, max, holes) do
+    if min <= max and MapSet.member?(holes, min), do: skip_up(min + 1, max, holes), else: min
+  end
+
+  defp skip_down(max, min, holes) do
+    if max >= min and MapSet.member?(holes, max), do: skip_down(max - 1, min, holes), else: max
+  end
+end
@@ -3,11 +3,16 @@
 
 defmodule AriaPlanner.Solvers.FlatZincGenerator do
   @moduledoc """
-  Generates FlatZinc format from constraint specifications using EEx templates.
+  Generates FlatZinc format from constraint specifications.
+
+  Output is built as iodata, one item per line, and `stream/1` produces the
+  lines lazily, so `write/2` and `write_file/2` can emit models with
+  hundreds of thousands of constraints without the whole text ever
+  existing as one binary.
   """
 
-  # Get template path relative to this file's directory
-  @template_path Path.expand("templates/flatzinc.eex", __DIR__)
+  @header "% Generated FlatZinc for AriaPlanner\n"
+  @empty "% Empty constraints\nsolve satisfy;"
 
   @doc """
   Generates FlatZinc content from a constraint map.
@@ -32,169 +37,133 @@ defmodule AriaPlanner.Solvers.FlatZincGenerator do
         ],
         objective: {:minimize, :x}
       }
-      
+
       flatzinc = FlatZincGenerator.generate(constraints)
   """
   @spec generate(map()) :: String.t()
-  def generate(constraints) when is_map(constraints) do
-    variables = Map.get(constraints, :variables, [])
-    constraint_list = Map.get(constraints, :constraints, [])
-    objective = Map.get(constraints, :objective)
-
-    assigns = [
-      variables: variables,
-      constraints: constraint_list,
-      objective: objective
-    ]
-
-    # Add format functions to assigns so template can access them
-    assigns_with_functions =
-      assigns ++
-        [
-          format_variable: &format_variable/1,
-          format_constraint: &format_constraint/1,
-          format_objective: &format_objective/1
-        ]
-
-    EEx.eval_file(@template_path, assigns: assigns_with_functions)
-  end
-
-  def generate(_), do: "% Empty constraints\nsolve satisfy;"
-
-  # Format a variable declaration (public for EEx template)
-  def format_variable({name, :int, min, max}) when is_atom(name) do
-    "var #{min}..#{max}: #{name};"
-  end
-
-  def format_variable({name, :bool}) when is_atom(name) do
-    "var bool: #{name};"
-  end
-
-  def format_variable({name, :float, min, max}) when is_atom(name) do
-    "var #{min}..#{max}: #{name};"
-  end
-
-  def format_variable({name, :int, min, max}) when is_binary(name) do
-    "var #{min}..#{max}: #{name};"
-  end
-
-  def format_variable({name, :bool}) when is_binary(name) do
-    "var bool: #{name};"
-  end
-
-  def format_variable({name, :float, min, max}) when is_binary(name) do
-    "var #{min}..#{max}: #{name};"
-  end
-
-  def format_variable(var) do
-    "% Unknown variable format: #{inspect(var)}"
-  end
-
-  # Format a constraint (public for EEx template)
-  def format_constraint({:all_different, vars}) do
-    var_list = Enum.join(Enum.map(vars, &var_to_string/1), ", ")
-    "constraint all_different([#{var_list}]);"
-  end
-
-  def format_constraint({:int_eq, left, right}) do
-    "constraint #{expr_to_string(left)} = #{expr_to_string(right)};"
-  end
+  def generate(constraints) when is_map(constraints),
+    do: constraints |> stream() |> Enum.to_list() |> IO.iodata_to_binary()
 
-  def format_constraint({:int_ne, left, right}) do
-    "constraint #{expr_to_string(left)} != #{expr_to_string(right)};"
-  end
-
-  def format_constraint({:int_le, left, right}) do
-    "constraint #{expr_to_string(left)} <= #{expr_to_string(right)};"
-  end
+  def generate(_), do: @empty
 
-  def format_constraint({:int_lt, left, right}) do
-    "constraint #{expr_to_string(left)} < #{expr_to_string(right)};"
+  @doc """
+  Lazily generates the FlatZinc for a constraint map, one line of iodata at
+  a time.
+  """
+  @spec stream(map()) :: Enumerable.t()
+  def stream(constraints) when is_map(constraints) do
+    Stream.concat([
+      [@header, "% Variables\n"],
+      Stream.map(Map.get(constraints, :variables, []), &line(format_variable(&1))),
+      ["\n% Constraints\n"],
+      Stream.map(Map.get(constraints, :constraints, []), &line(format_constraint(&1))),
+      ["\n% Objective\n", line(format_objective(Map.get(constraints, :objective)))]
+    ])
   end
 
-  def format_constraint({:int_ge, left, right}) do
-    "constraint #{expr_to_string(left)} >= #{expr_to_string(right)};"
-  end
+  def stream(_), do: [@empty]
 
-  def format_constraint({:int_gt, left, right}) do
-    "constraint #{expr_to_string(left)} > #{expr_to_string(right)};"
-  end
+  @doc """
+  Writes the FlatZinc for a constraint map to an IO device, line by line.
+  """
+  @spec write(map(), IO.device()) :: :ok
+  def write(constraints, device), do: constraints |> stream() |> Enum.each(&IO.binwrite(device, &1))
 
-  def format_constraint({:bool_eq, left, right}) do
-    "constraint #{expr_to_string(left)} = #{expr_to_string(right)};"
+  @doc """
+  Writes the FlatZinc for a constraint map to the file at `path`, buffering
+  writes rather than building the content first.
+  """
+  @spec write_file(map(), Path.t()) :: :ok | {:error, File.posix()}
+  def write_file(constraints, path) do
+    case File.open(path, [:write, :binary, :delayed_write], &write(constraints, &1)) do
+      {:ok, :ok} -> :ok
+      error -> error
+    end
   end
 
-  def format_constraint({:bool_and, left, right}) do
-    "constraint #{expr_to_string(left)} /\\ #{expr_to_string(right)};"
-  end
+  defp line(item), do: [item, ?\n]
 
-  def format_constraint({:bool_or, left, right}) do
-    "constraint #{expr_to_string(left)} \\/ #{expr_to_string(right)};"
+  # Format a variable declaration as iodata
+  defp format_variable({name, :int, min, max}) when is_atom(name) or is_binary(name) do
+    ["var ", to_string(min), "..", to_string(max), ": ", var_to_string(name), ?;]
   end
 
-  def format_constraint({:bool_not, expr}) do
-    "constraint not #{expr_to_string(expr)};"
+  defp format_variable({name, :bool}) when is_atom(name) or is_binary(name) do
+    ["var bool: ", var_to_string(name), ?;]
   end
 
-  def format_constraint({:array_element, array, index, value}) do
-    "constraint element(#{expr_to_string(index)}, #{expr_to_string(array)}, #{expr_to_string(value)});"
+  defp format_variable({name, :float, min, max}) when is_atom(name) or is_binary(name) do
+    ["var ", to_string(min), "..", to_string(max), ": ", var_to_string(name), ?;]
   end
 
-  def format_constraint({:global_cardinality, vars, low, high}) do
-    "constraint global_cardinality_low_up([#{Enum.join(Enum.map(vars, &expr_to_string/1), ", ")}], #{expr_to_string(low)}, #{expr_to_string(high)});"
+  defp format_variable(var) do
+    ["% Unknown variable format: ", inspect(var)]
   end
 
-  def format_constraint(constraint) do
-    "% Unknown constraint: #{inspect(constraint)}"
+  # Format a constraint as iodata
+  defp format_constraint({:all_different, vars}) do
+    ["constraint all_different([", join(vars, &var_to_string/1, ", "), "]);"]
   end
 
-  # Format an objective (public for EEx template)
-  def format_objective({:minimize, var}) do
-    "solve minimize #{var_to_string(var)};"
-  end
+  defp format_constraint({:int_eq, left, right}), do: relation(left, " = ", right)
+  defp format_constraint({:int_ne, left, right}), do: relation(left, " != ", right)
+  defp format_constraint({:int_le, left, right}), do: relation(left, " <= ", right)
+  defp format_constraint({:int_lt, left, right}), do: relation(left, " < ", right)
+  defp format_constraint({:int_ge, left, right}), do: relation(left, " >= ", right)
+  defp format_constraint({:int_gt, left, right}), do: relation(left, " > ", right)
+  defp format_constraint({:bool_eq, left, right}), do: relation(left, " = ", right)
+  defp format_constraint({:bool_and, left, right}), do: relation(left, " /\\ ", right)
+  defp format_constraint({:bool_or, left, right}), do: relation(left, " \\/ ", right)
 
-  def format_objective({:maximize, var}) do
-    "solve maximize #{var_to_string(var)};"
+  defp format_constraint({:bool_not, expr}) do
+    ["constraint not ", expr_to_iodata(expr), ?;]
   end
 
-  def format_objective(_), do: "solve satisfy;"
-
-  # Convert expression to string
-  defp expr_to_string({:+, left, right}) do
-    "(#{expr_to_string(left)} + #{expr_to_string(right)})"
+  defp format_constraint({:array_element, array, index, value}) do
+    ["constraint element(", expr_to_iodata(index), ", ", expr_to_iodata(array), ", ", expr_to_iodata(value), ");"]
   end
 
-  defp expr_to_string({:-, left, right}) do
-    "(#{expr_to_string(left)} - #{expr_to_string(right)})"
+  defp format_constraint({:global_cardinality, vars, low, high}) do
+    [
+      "constraint global_cardinality_low_up([",
+      join(vars, &expr_to_iodata/1, ", "),
+      "], ",
+      expr_to_iodata(low),
+      ", ",
+      expr_to_iodata(high),
+      ");"
+    ]
   end
 
-  defp expr_to_string({:*, left, right}) do
-    "(#{expr_to_string(left)} * #{expr_to_string(right)})"
+  defp format_constraint(constraint) do
+    ["% Unknown constraint: ", inspect(constraint)]
   end
 
-  defp expr_to_string({:/, left, right}) do
-    "(#{expr_to_string(left)} / #{expr_to_string(right)})"
-  end
+  # Format an objective as iodata
+  defp format_objective({:minimize, var}), do: ["solve minimize ", var_to_string(var), ?;]
+  defp format_objective({:maximize, var}), do: ["solve maximize ", var_to_string(var), ?;]
+  defp format_objective(_), do: "solve satisfy;"
 
-  defp expr_to_string({:mod, left, right}) do
-    "(#{expr_to_string(left)} mod #{expr_to_string(right)})"
-  end
+  defp relation(left, op, right), do: ["constraint ", expr_to_iodata(left), op, expr_to_iodata(right), ?;]
 
-  defp expr_to_string({:sum, vars}) do
-    var_list = Enum.join(Enum.map(vars, &expr_to_string/1), " + ")
-    "(#{var_list})"
-  end
+  # Convert expression to iodata
+  defp expr_to_iodata({:+, left, right}), do: binary(left, " + ", right)
+  defp expr_to_iodata({:-, left, right}), do: binary(left, " - ", right)
+  defp expr_to_iodata({:*, left, right}), do: binary(left, " * ", right)
+  defp expr_to_iodata({:/, left, right}), do: binary(left, " / ", right)
+  defp expr_to_iodata({:mod, left, right}), do: binary(left, " mod ", right)
+  defp expr_to_iodata({:sum, vars}), do: [?(, join(vars, &expr_to_iodata/1, " + "), ?)]
+  defp expr_to_iodata({:array, elements}), do: [?[, join(elements, &expr_to_iodata/1, ", "), ?]]
+  defp expr_to_iodata(bool) when is_boolean(bool), do: if(bool, do: "true", else: "false")
+  defp expr_to_iodata(atom) when is_atom(atom), do: Atom.to_string(atom)
+  defp expr_to_iodata(int) when is_integer(int), do: Integer.to_string(int)
+  defp expr_to_iodata(float) when is_float(float), do: Float.to_string(float)
+  defp expr_to_iodata(str) when is_binary(str), do: str
+  defp expr_to_iodata(other), do: inspect(other)
 
-  defp expr_to_string({:array, elements}) do
-    "[#{Enum.join(Enum.map(elements, &expr_to_string/1), ", ")}]"
-  end
+  defp binary(left, op, right), do: [?(, expr_to_iodata(left), op, expr_to_iodata(right), ?)]
 
-  defp expr_to_string(atom) when is_atom(atom), do: Atom.to_string(atom)
-  defp expr_to_string(int) when is_integer(int), do: Integer.to_string(int)
-  defp expr_to_string(float) when is_float(float), do: Float.to_string(float)
-  defp expr_to_string(bool) when is_boolean(bool), do: if(bool, do: "true", else: "false")
-  defp expr_to_string(str) when is_binary(str), do: str
-  defp expr_to_string(other), do: inspect(other)
+  defp join(items, fun, separator), do: Enum.map_intersperse(items, separator, fun)
 
   # Convert variable to string
   defp var_to_string(atom) when is_atom(atom), do: Atom.to_string(atom)
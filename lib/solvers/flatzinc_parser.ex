@@ -0,0 +1,380 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2025-present K. S. Ernest (iFire) Lee
+
+defmodule AriaPlanner.Solvers.FlatZincParser do
+  @moduledoc """
+  Parses FlatZinc into the constraint map `FlatZincGenerator.generate/1`
+  takes, so that `CpSolver` can solve it.
+
+  Covers what `FlatZincGenerator` writes, expressions and relations
+  included, and the integer and boolean FlatZinc builtins:
+
+    * `var lo..hi: x` and `var bool: b` declarations, with an optional
+      `= value`; `int`, `bool` and `array [..] of ...` parameters and
+      arrays, substituted where they are used
+    * relations `=`, `!=`, `<`, `<=`, `>`, `>=` and `/\\`, `\\/`, `not`
+    * `int_eq`, `int_ne`, `int_le`, `int_lt`, `int_lin_eq`, `int_lin_le`,
+      `int_lin_ne`, `int_plus`, `int_times`, `int_div`, `int_mod`,
+      `bool_eq` and `bool2int`
+    * `all_different` (and `all_different_int`), `element` (and the
+      `array_*_element` builtins) and `global_cardinality_low_up`
+
+  Variable names are kept as strings. Annotations and predicate
+  declarations are skipped.
+  """
+
+  @doc """
+  Parses FlatZinc `content`.
+  """
+  @spec parse(binary()) :: {:ok, map()} | {:error, String.t()}
+  def parse(content) when is_binary(content) do
+    content
+    |> tokenize([])
+    |> items(%{variables: [], constraints: [], objective: nil, params: %{}})
+  catch
+    {:fzn_error, message} -> {:error, message}
+  end
+
+  @doc """
+  Reads and parses the FlatZinc file at `path`.
+  """
+  @spec parse_file(Path.t()) :: {:ok, map()} | {:error, String.t()}
+  def parse_file(path) do
+    case File.read(path) do
+      {:ok, content} -> parse(content)
+      {:error, reason} -> {:error, "Failed to read file: #{inspect(reason)}"}
+    end
+  end
+
+  # Tokenizer
+
+  @symbols ["::", "..", "/\\", "\\/", "!=", "<=", ">=", "=="]
+
+  defp tokenize(<<>>, acc), do: Enum.reverse(acc)
+  defp tokenize(<<c, rest::binary>>, acc) when c in ~c" \t\r\n", do: tokenize(rest, acc)
+  defp tokenize(<<"%", rest::binary>>, acc), do: rest |> skip_line() |> tokenize(acc)
+
+  defp tokenize(<<sym::binary-size(2), rest::binary>>, acc) when sym in @symbols,
+    do: tokenize(rest, [{:sym, sym} | acc])
+
+  defp tokenize(<<c, rest::binary>>, acc) when c in ~c"()[]{},;:=<>+-*/",
+    do: tokenize(rest, [{:sym, <<c>>} | acc])
+
+  defp tokenize(<<c, _::binary>> = content, acc) when c in ?0..?9 do
+    {digits, rest} = take(content, &(&1 in ?0..?9))
+
+    case rest do
+      <<".", d, _::binary>> when d in ?0..?9 -> throw({:fzn_error, "Unsupported float literal after #{digits}"})
+      _ -> tokenize(rest, [{:int, String.to_integer(digits)} | acc])
+    end
+  end
+
+  defp tokenize(<<c, _::binary>> = content, acc) when c in ?a..?z or c in ?A..?Z or c == ?_ do
+    {word, rest} = take(content, &(&1 in ?a..?z or &1 in ?A..?Z or &1 in ?0..?9 or &1 == ?_))
+    tokenize(rest, [{:ident, word} | acc])
+  end
+
+  defp tokenize(<<"\"", rest::binary>>, acc) do
+    case :binary.split(rest, "\"") do
+      [string, rest] -> tokenize(rest, [{:string, string} | acc])
+      [_unterminated] -> throw({:fzn_error, "Unterminated string"})
+    end
+  end
+
+  defp tokenize(<<c, _::binary>>, _acc), do: throw({:fzn_error, "Unexpected character: #{inspect(<<c>>)}"})
+
+  defp skip_line(content) do
+    case :binary.split(content, "\n") do
+      [_comment, rest] -> rest
+      [_comment] -> <<>>
+    end
+  end
+
+  defp take(content, fun), do: take(content, fun, 0)
+
+  defp take(content, fun, n) do
+    case content do
+      <<_::binary-size(n), c, _::binary>> -> if fun.(c), do: take(content, fun, n + 1), else: split(content, n)
+      _ -> split(content, n)
+    end
+  end
+
+  defp split(content, n) do
+    <<taken::binary-size(n), rest::binary>> = content
+    {taken, rest}
+  end
+
+  # Items
+
+  defp items([], model) do
+    {:ok,
+     %{
+       variables: Enum.reverse(model.variables),
+       constraints: Enum.reverse(model.constraints),
+       objective: model.objective
+     }}
+  end
+
+  defp items([{:ident, "predicate"} | tokens], model), do: tokens |> skip_to(";") |> items(model)
+
+  defp items([{:ident, "var"} | tokens], model) do
+    {variable, tokens} = domain(tokens)
+    {name, tokens} = declared_name(tokens)
+    model = %{model | variables: [put_elem(variable, 0, name) | model.variables]}
+
+    case tokens do
+      [{:sym, "="} | tokens] ->
+        {value, tokens} = expression(tokens, model.params)
+        items(expect(tokens, ";"), %{model | constraints: [{:int_eq, name, value} | model.constraints]})
+
+      tokens ->
+        items(expect(tokens, ";"), model)
+    end
+  end
+
+  defp items([{:ident, type} | tokens], model) when type in ["int", "bool", "array"] do
+    {name, tokens} = tokens |> skip_to(":") |> declared_name()
+    {value, tokens} = tokens |> expect("=") |> expression(model.params)
+    items(expect(tokens, ";"), %{model | params: Map.put(model.params, name, value)})
+  end
+
+  defp items([{:ident, "constraint"} | tokens], model) do
+    {constraint, tokens} = disjunction(tokens, model.params)
+    tokens = tokens |> annotations() |> expect(";")
+    items(tokens, %{model | constraints: Enum.reverse(constraints(constraint), model.constraints)})
+  end
+
+  defp items([{:ident, "solve"} | tokens], model) do
+    case annotations(tokens) do
+      [{:ident, "satisfy"} | tokens] ->
+        items(expect(tokens, ";"), model)
+
+      [{:ident, sense} | tokens] when sense in ["minimize", "maximize"] ->
+        {objective, tokens} = expression(tokens, model.params)
+        items(expect(tokens, ";"), %{model | objective: {String.to_existing_atom(sense), objective}})
+
+      tokens ->
+        unexpected(tokens)
+    end
+  end
+
+  defp items(tokens, _model), do: unexpected(tokens)
+
+  defp domain([{:ident, "bool"}, {:sym, ":"} | tokens]), do: {{nil, :bool}, tokens}
+
+  defp domain([{:int, min}, {:sym, ".."}, {:int, max}, {:sym, ":"} | tokens]), do: {{nil, :int, min, max}, tokens}
+
+  defp domain([{:sym, "-"}, {:int, min} | tokens]), do: domain([{:int, -min} | tokens])
+  defp domain([{:int, min}, {:sym, ".."}, {:sym, "-"}, {:int, max} | tokens]),
+    do: domain([{:int, min}, {:sym, ".."}, {:int, -max} | tokens])
+
+  defp domain(tokens), do: throw({:fzn_error, "Unsupported variable domain near #{describe(tokens)}"})
+
+  defp declared_name([{:ident, name} | tokens]), do: {name, annotations(tokens)}
+  defp declared_name(tokens), do: unexpected(tokens)
+
+  # Constraints
+
+  defp constraints({:bool_and, left, right}), do: constraints(left) ++ constraints(right)
+  defp constraints({:call, name, args}), do: [builtin(name, args)]
+  defp constraints({relation, _left, _right} = constraint)
+       when relation in [:int_eq, :int_ne, :int_le, :int_lt, :int_ge, :int_gt, :bool_or],
+       do: [constraint]
+  defp constraints({:bool_not, _expr} = constraint), do: [constraint]
+  defp constraints(expr), do: [{:int_ne, expr, 0}]
+
+  @elements ["element", "array_int_element", "array_var_int_element", "array_bool_element", "array_var_bool_element"]
+
+  defp builtin(name, [{:array, vars}]) when name in ["all_different", "alldifferent", "all_different_int"],
+    do: {:all_different, vars}
+
+  defp builtin(name, [index, {:array, _} = array, value]) when name in @elements,
+    do: {:array_element, array, index, value}
+
+  defp builtin("global_cardinality_low_up", [{:array, vars}, {:array, _} = low, {:array, _} = high]),
+    do: {:global_cardinality, vars, low, high}
+
+  defp builtin(name, [left, right]) when name in ["int_eq", "int_ne", "int_le", "int_lt", "bool_eq", "bool2int"] do
+    relation = %{"int_eq" => :int_eq, "int_ne" => :int_ne, "int_le" => :int_le, "int_lt" => :int_lt}
+    {Map.get(relation, name, :int_eq), left, right}
+  end
+
+  defp builtin(name, [{:array, coeffs}, {:array, vars}, constant])
+       when name in ["int_lin_eq", "int_lin_le", "int_lin_ne"] and length(coeffs) == length(vars) do
+    relation = %{"int_lin_eq" => :int_eq, "int_lin_le" => :int_le, "int_lin_ne" => :int_ne}
+    {Map.fetch!(relation, name), {:sum, Enum.zip_with(coeffs, vars, &{:*, &1, &2})}, constant}
+  end
+
+  defp builtin(name, [left, right, result]) when name in ["int_plus", "int_times", "int_div", "int_mod"] do
+    op = %{"int_plus" => :+, "int_times" => :*, "int_div" => :/, "int_mod" => :mod}
+    {:int_eq, {Map.fetch!(op, name), left, right}, result}
+  end
+
+  defp builtin(name, args), do: throw({:fzn_error, "Unsupported constraint: #{name}/#{length(args)}"})
+
+  # Expressions, loosest binding first
+
+  defp disjunction(tokens, params) do
+    {left, tokens} = conjunction(tokens, params)
+
+    case tokens do
+      [{:sym, "\\/"} | tokens] ->
+        {right, tokens} = disjunction(tokens, params)
+        {{:bool_or, left, right}, tokens}
+
+      tokens ->
+        {left, tokens}
+    end
+  end
+
+  defp conjunction(tokens, params) do
+    {left, tokens} = relation(tokens, params)
+
+    case tokens do
+      [{:sym, "/\\"} | tokens] ->
+        {right, tokens} = conjunction(tokens, params)
+        {{:bool_and, left, right}, tokens}
+
+      tokens ->
+        {left, tokens}
+    end
+  end
+
+  @relations %{
+    "=" => :int_eq,
+    "==" => :int_eq,
+    "!=" => :int_ne,
+    "<" => :int_lt,
+    "<=" => :int_le,
+    ">" => :int_gt,
+    ">=" => :int_ge
+  }
+
+  defp relation([{:ident, "not"} | tokens], params) do
+    {expr, tokens} = relation(tokens, params)
+    {{:bool_not, expr}, tokens}
+  end
+
+  defp relation(tokens, params) do
+    {left, tokens} = expression(tokens, params)
+
+    case tokens do
+      [{:sym, sym} | tokens] when is_map_key(@relations, sym) ->
+        {right, tokens} = expression(tokens, params)
+        {{Map.fetch!(@relations, sym), left, right}, tokens}
+
+      tokens ->
+        {left, tokens}
+    end
+  end
+
+  defp expression(tokens, params) do
+    {left, tokens} = term(tokens, params)
+    additive(left, tokens, params)
+  end
+
+  defp additive(left, [{:sym, sym} | tokens], params) when sym in ["+", "-"] do
+    {right, tokens} = term(tokens, params)
+    additive({if(sym == "+", do: :+, else: :-), left, right}, tokens, params)
+  end
+
+  defp additive(left, tokens, _params), do: {left, tokens}
+
+  defp term(tokens, params) do
+    {left, tokens} = unary(tokens, params)
+    multiplicative(left, tokens, params)
+  end
+
+  @multiplicative %{{:sym, "*"} => :*, {:sym, "/"} => :/, {:ident, "div"} => :/, {:ident, "mod"} => :mod}
+
+  defp multiplicative(left, [token | tokens], params) when is_map_key(@multiplicative, token) do
+    {right, tokens} = unary(tokens, params)
+    multiplicative({Map.fetch!(@multiplicative, token), left, right}, tokens, params)
+  end
+
+  defp multiplicative(left, tokens, _params), do: {left, tokens}
+
+  defp unary([{:sym, "-"} | tokens], params) do
+    case unary(tokens, params) do
+      {value, tokens} when is_integer(value) -> {-value, tokens}
+      {expr, tokens} -> {{:-, 0, expr}, tokens}
+    end
+  end
+
+  defp unary(tokens, params), do: primary(tokens, params)
+
+  defp primary([{:int, value} | tokens], _params), do: {value, tokens}
+  defp primary([{:ident, "true"} | tokens], _params), do: {true, tokens}
+  defp primary([{:ident, "false"} | tokens], _params), do: {false, tokens}
+
+  defp primary([{:sym, "("} | tokens], params) do
+    {expr, tokens} = disjunction(tokens, params)
+    {expr, expect(tokens, ")")}
+  end
+
+  defp primary([{:sym, "["} | tokens], params) do
+    {elements, tokens} = list(tokens, params, "]")
+    {{:array, elements}, tokens}
+  end
+
+  defp primary([{:ident, name}, {:sym, "("} | tokens], params) do
+    {args, tokens} = list(tokens, params, ")")
+    {{:call, name, args}, tokens}
+  end
+
+  defp primary([{:ident, name}, {:sym, "["} | tokens], params) do
+    {index, tokens} = expression(tokens, params)
+
+    case {Map.get(params, name), index} do
+      {{:array, elements}, index} when is_integer(index) and index in 1..length(elements)//1 ->
+        {Enum.at(elements, index - 1), expect(tokens, "]")}
+
+      _ ->
+        throw({:fzn_error, "Unsupported array access: #{name}[#{inspect(index)}]"})
+    end
+  end
+
+  defp primary([{:ident, name} | tokens], params), do: {Map.get(params, name, name), tokens}
+  defp primary(tokens, _params), do: unexpected(tokens)
+
+  defp list([{:sym, close} | tokens], _params, close), do: {[], tokens}
+
+  defp list(tokens, params, close) do
+    {element, tokens} = disjunction(tokens, params)
+
+    case tokens do
+      [{:sym, ","} | tokens] ->
+        {elements, tokens} = list(tokens, params, close)
+        {[element | elements], tokens}
+
+      [{:sym, ^close} | tokens] ->
+        {[element], tokens}
+
+      tokens ->
+        unexpected(tokens)
+    end
+  end
+
+  # Annotations: `:: name` or `:: name(args)`, possibly repeated
+  defp annotations([{:sym, "::"}, {:ident, _name}, {:sym, "("} | tokens]), do: tokens |> skip_group(1) |> annotations()
+  defp annotations([{:sym, "::"}, {:ident, _name} | tokens]), do: annotations(tokens)
+  defp annotations(tokens), do: tokens
+
+  defp skip_group(tokens, 0), do: tokens
+  defp skip_group([{:sym, open} | tokens], depth) when open in ["(", "["], do: skip_group(tokens, depth + 1)
+  defp skip_group([{:sym, close} | tokens], depth) when close in [")", "]"], do: skip_group(tokens, depth - 1)
+  defp skip_group([_token | tokens], depth), do: skip_group(tokens, depth)
+  defp skip_group([], _depth), do: throw({:fzn_error, "Unterminated annotation"})
+
+  defp skip_to([{:sym, sym} | tokens], sym), do: tokens
+  defp skip_to([_token | tokens], sym), do: skip_to(tokens, sym)
+  defp skip_to([], sym), do: throw({:fzn_error, "Expected #{sym}, got end of input"})
+
+  defp expect([{:sym, sym} | tokens], sym), do: tokens
+  defp expect(tokens, sym), do: throw({:fzn_error, "Expected #{sym}, got #{describe(tokens)}"})
+
+  defp unexpected(tokens), do: throw({:fzn_error, "Unexpected #{describe(tokens)}"})
+
+  defp describe([]), do: "end of input"
+  defp describe([{_kind, value} | _tokens]), do: inspect(value)
+end
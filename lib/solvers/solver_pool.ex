@@ -0,0 +1,292 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2025-present K. S. Ernest (iFire) Lee
+
+defmodule AriaPlanner.Solvers.SolverPool do
+  @moduledoc """
+  Bounded pool for `CpSolver` requests.
+
+  At most `:size` models are solved at once, each in its own task under
+  the pool's `Task.Supervisor`. Further requests wait in a queue of at
+  most `:max_queue`, beyond which they are refused with
+  `{:error, :overloaded}` so that callers feel back-pressure instead of
+  piling up work.
+
+  `async_solve/3` streams each solution to the caller as it is found:
+
+    * `{ref, {:solution, solution}}` for every solution, improving ones
+      included when optimising
+    * `{ref, {:done, result}}` once, with `CpSolver.solve/2`'s result,
+      `{:error, "Timeout"}` when the request overran its `:timeout`, or
+      `{:error, "Cancelled"}` after `cancel/2`
+
+  The pool enforces each request's `:timeout` itself, killing a task that
+  has not finished shortly after its deadline, reports tasks that crash,
+  and cancels the requests of callers that exit. A stopped task is gone
+  before its caller is told `:done`, so no solution follows that message.
+  Callers waiting on a request should watch the pool with `monitor/1`.
+  """
+
+  use GenServer
+
+  alias AriaPlanner.Solvers.CpSolver
+
+  @default_timeout 60_000
+  # Time a solver is given past its deadline to return its best solution
+  @grace 100
+
+  @type request :: reference()
+
+  # Client API
+
+  @doc """
+  Starts a pool.
+
+  ## Options
+
+    * `:name` - registered name. Defaults to `#{inspect(__MODULE__)}`
+    * `:size` - models solved at once. Defaults to the number of schedulers
+    * `:max_queue` - requests allowed to wait. Defaults to `16 * size`
+  """
+  @spec start_link(keyword()) :: GenServer.on_start()
+  def start_link(opts \\ []) do
+    GenServer.start_link(__MODULE__, opts, name: Keyword.get(opts, :name, __MODULE__))
+  end
+
+  @doc """
+  Queues `model` for solving and returns a reference to the request, whose
+  solutions arrive as messages to the calling process.
+
+  Takes `CpSolver.solve/2`'s options, `:on_solution` excepted.
+  """
+  @spec async_solve(GenServer.server(), map(), keyword()) :: {:ok, request()} | {:error, :overloaded}
+  def async_solve(pool \\ __MODULE__, model, opts \\ []) do
+    GenServer.call(pool, {:solve, model, Keyword.delete(opts, :on_solution)})
+  end
+
+  @doc """
+  Solves `model` in the pool and waits for the result.
+
+  Takes `CpSolver.solve/2`'s options; `:on_solution` is called, in the
+  calling process, with each solution as it arrives.
+  """
+  @spec solve(GenServer.server(), map(), keyword()) :: {:ok, CpSolver.result()} | {:error, term()}
+  def solve(pool \\ __MODULE__, model, opts \\ []) do
+    on_solution = Keyword.get(opts, :on_solution, fn _solution -> :ok end)
+
+    pool_monitor = monitor(pool)
+
+    case async_solve(pool, model, opts) do
+      {:ok, request} ->
+        await(request, pool_monitor, on_solution)
+
+      error ->
+        Process.demonitor(pool_monitor, [:flush])
+        error
+    end
+  end
+
+  @doc """
+  Monitors the pool, so that a caller waiting on its requests learns when
+  it goes down: no `:done` message will come after the monitor's `:DOWN`.
+  """
+  @spec monitor(GenServer.server()) :: reference()
+  def monitor(pool), do: Process.monitor(GenServer.whereis(pool) || pool)
+
+  @doc """
+  Cancels a request, queued or running. Its caller receives
+  `{ref, {:done, {:error, "Cancelled"}}}`, and its task is stopped by the
+  time this returns.
+  """
+  @spec cancel(GenServer.server(), request()) :: :ok | {:error, :not_found}
+  def cancel(pool \\ __MODULE__, request), do: GenServer.call(pool, {:cancel, request})
+
+  @doc """
+  Number of running and queued requests.
+  """
+  @spec stats(GenServer.server()) :: %{running: non_neg_integer(), queued: non_neg_integer()}
+  def stats(pool \\ __MODULE__), do: GenServer.call(pool, :stats)
+
+  defp await(request, pool_monitor, on_solution) do
+    receive do
+      {^request, {:solution, solution}} ->
+        on_solution.(solution)
+        await(request, pool_monitor, on_solution)
+
+      {^request, {:done, result}} ->
+        Process.demonitor(pool_monitor, [:flush])
+        result
+
+      {:DOWN, ^pool_monitor, :process, _pid, reason} ->
+        {:error, "Solver pool down: #{inspect(reason)}"}
+    end
+  end
+
+  # Server callbacks
+
+  @impl true
+  def init(opts) do
+    size = Keyword.get(opts, :size, System.schedulers_online())
+    {:ok, tasks} = Task.Supervisor.start_link()
+
+    {:ok,
+     %{
+       tasks: tasks,
+       size: size,
+       max_queue: Keyword.get(opts, :max_queue, 16 * size),
+       queue: :queue.new(),
+       # request => %{caller:, caller_monitor:, task:, task_monitor:, timer:}
+       running: %{},
+       # request => caller_monitor, for queued requests
+       waiting: %{},
+       # monitor => request, for callers and tasks alike
+       monitors: %{}
+     }}
+  end
+
+  @impl true
+  def handle_call({:solve, model, opts}, {caller, _tag}, state) do
+    cond do
+      map_size(state.running) < state.size ->
+        request = make_ref()
+        {:reply, {:ok, request}, start(state, request, caller, Process.monitor(caller), model, opts)}
+
+      :queue.len(state.queue) < state.max_queue ->
+        request = make_ref()
+        caller_monitor = Process.monitor(caller)
+
+        state = %{
+          state
+          | queue: :queue.in({request, caller, caller_monitor, model, opts}, state.queue),
+            waiting: Map.put(state.waiting, request, caller_monitor),
+            monitors: Map.put(state.monitors, caller_monitor, request)
+        }
+
+        {:reply, {:ok, request}, state}
+
+      true ->
+        {:reply, {:error, :overloaded}, state}
+    end
+  end
+
+  def handle_call({:cancel, request}, _from, state) do
+    if Map.has_key?(state.running, request) or Map.has_key?(state.waiting, request) do
+      {:reply, :ok, state |> finish(request, {:error, "Cancelled"}) |> dispatch()}
+    else
+      {:reply, {:error, :not_found}, state}
+    end
+  end
+
+  def handle_call(:stats, _from, state) do
+    {:reply, %{running: map_size(state.running), queued: :queue.len(state.queue)}, state}
+  end
+
+  @impl true
+  def handle_info({monitor, result}, state) when is_reference(monitor) do
+    case Map.fetch(state.monitors, monitor) do
+      {:ok, request} -> {:noreply, state |> finish(request, result) |> dispatch()}
+      :error -> {:noreply, state}
+    end
+  end
+
+  def handle_info({:timeout, request}, state) do
+    if Map.has_key?(state.running, request),
+      do: {:noreply, state |> finish(request, {:error, "Timeout"}) |> dispatch()},
+      else: {:noreply, state}
+  end
+
+  def handle_info({:DOWN, monitor, :process, _pid, reason}, state) do
+    case Map.fetch(state.monitors, monitor) do
+      {:ok, request} ->
+        %{caller_monitor: caller_monitor} = Map.get(state.running, request, %{caller_monitor: nil})
+
+        state =
+          cond do
+            # The caller exited: nobody is left to tell
+            monitor == caller_monitor or Map.has_key?(state.waiting, request) ->
+              finish(state, request, nil)
+
+            # The task is gone already, so there is nothing to wait for
+            true ->
+              state
+              |> update_in([:running, request], &%{&1 | task: nil})
+              |> finish(request, {:error, "Solver crashed: #{inspect(reason)}"})
+          end
+
+        {:noreply, dispatch(state)}
+
+      :error ->
+        {:noreply, state}
+    end
+  end
+
+  defp start(state, request, caller, caller_monitor, model, opts) do
+    timeout = Keyword.get(opts, :timeout, @default_timeout)
+    notify = fn solution -> send(caller, {request, {:solution, solution}}) end
+
+    # The task's reply and exit both come back to the pool, which alone tells the caller it is done
+    task = Task.Supervisor.async_nolink(state.tasks, CpSolver, :solve, [model, Keyword.put(opts, :on_solution, notify)])
+
+    entry = %{
+      caller: caller,
+      caller_monitor: caller_monitor,
+      task: task.pid,
+      task_monitor: task.ref,
+      timer: Process.send_after(self(), {:timeout, request}, timeout + @grace)
+    }
+
+    %{
+      state
+      | running: Map.put(state.running, request, entry),
+        monitors: state.monitors |> Map.put(caller_monitor, request) |> Map.put(task.ref, request)
+    }
+  end
+
+  # Forgets `request`, stopping its task, and tells its caller `result` unless it is nil
+  defp finish(state, request, result) do
+    case Map.pop(state.running, request) do
+      {%{} = entry, running} ->
+        Process.cancel_timer(entry.timer)
+        Process.demonitor(entry.caller_monitor, [:flush])
+        stop_task(entry)
+        if result, do: send(entry.caller, {request, {:done, result}})
+
+        %{state | running: running, monitors: Map.drop(state.monitors, [entry.task_monitor, entry.caller_monitor])}
+
+      {nil, _running} ->
+        {caller_monitor, waiting} = Map.pop(state.waiting, request)
+        {[{^request, caller, ^caller_monitor, _model, _opts}], queue} = take(state.queue, request)
+        Process.demonitor(caller_monitor, [:flush])
+        if result, do: send(caller, {request, {:done, result}})
+
+        %{state | queue: queue, waiting: waiting, monitors: Map.delete(state.monitors, caller_monitor)}
+    end
+  end
+
+  # Kills a task and waits for it to be gone, so that none of its solutions can reach the caller after `:done`
+  defp stop_task(%{task: nil, task_monitor: task_monitor}), do: Process.demonitor(task_monitor, [:flush])
+
+  defp stop_task(%{task: task, task_monitor: task_monitor}) do
+    Process.exit(task, :kill)
+
+    receive do
+      {:DOWN, ^task_monitor, :process, _pid, _reason} -> :ok
+    end
+  end
+
+  defp take(queue, request) do
+    {taken, kept} = queue |> :queue.to_list() |> Enum.split_with(&(elem(&1, 0) == request))
+    {taken, :queue.from_list(kept)}
+  end
+
+  # Starts queued requests while there is room
+  defp dispatch(state) do
+    with true <- map_size(state.running) < state.size,
+         {{:value, {request, caller, caller_monitor, model, opts}}, queue} <- :queue.out(state.queue) do
+      %{state | queue: queue, waiting: Map.delete(state.waiting, request)}
+      |> start(request, caller, caller_monitor, model, opts)
+      |> dispatch()
+    else
+      _ -> state
+    end
+  end
+end
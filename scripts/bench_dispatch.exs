@@ -0,0 +1,88 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2025-present K. S. Ernest (iFire) Lee
+#
+# Compares node classification and method dispatch through the method/action
+# dictionaries against the compiled dispatch tables, then runs lazy refinement
+# end to end on the fox-geese-corn and tiny-cvrp instances. That both agree is
+# checked by test/core/planner/compiled_domain_test.exs; this script times them.
+# Run with: mix run scripts/bench_dispatch.exs
+
+require Logger
+Logger.configure(level: :warning)
+
+alias AriaCore.Planner.CompiledDomain
+alias AriaCore.Planner.LazyRefinement
+alias AriaPlanner.Domains.{FoxGeeseCorn, PlannerAdapter, TinyCvrp}
+
+lookups = 1_000_000
+probs = Path.join([__DIR__, "..", "thirdparty", "mznc2024_probs"])
+
+# Classification as done before compilation: consult each dictionary in turn
+dict_classify = fn methods, actions, info ->
+  name = elem(info, 0)
+
+  cond do
+    Map.has_key?(methods.task_method_dict, name) -> {:T, methods.task_method_dict[name]}
+    Map.has_key?(actions.action_dict, name) -> {:A, actions.action_dict[name]}
+    Map.has_key?(methods.goal_method_dict, name) -> {:G, methods.goal_method_dict[name]}
+    true -> :unknown
+  end
+end
+
+compiled_classify = fn domain, info ->
+  case CompiledDomain.classify(domain, info) do
+    {type, symbol} -> {type, CompiledDomain.handler(domain, symbol)}
+    :unknown -> :unknown
+  end
+end
+
+time_ms = fn fun ->
+  {micros, result} = :timer.tc(fun)
+  {micros / 1000, result}
+end
+
+instances = [
+  {"fox-geese-corn", FoxGeeseCorn, AriaPlanner.Domains.FoxGeeseCorn.PlannerSpec,
+   Path.wildcard(Path.join([probs, "fox-geese-corn", "*.dzn"]))},
+  {"tiny-cvrp", TinyCvrp, AriaPlanner.Domains.TinyCvrp.PlannerSpec,
+   Path.wildcard(Path.join([probs, "tiny-cvrp", "*.dzn"]))}
+]
+
+for {label, domain_module, spec_module, files} <- instances, file <- files do
+  {:ok, params} = domain_module.parse_dzn_file(file)
+  {:ok, domain_state} = domain_module.initialize_state(params)
+  spec = spec_module.domain_spec(domain_state)
+  domain = CompiledDomain.compile(spec.methods, spec.actions)
+
+  infos =
+    (Map.keys(spec.methods.task_method_dict) ++ Map.keys(spec.actions.action_dict))
+    |> Enum.map(&{&1, nil})
+    |> List.to_tuple()
+
+  info_count = tuple_size(infos)
+
+  {dict_ms, _} =
+    time_ms.(fn ->
+      Enum.each(1..lookups, fn i -> dict_classify.(spec.methods, spec.actions, elem(infos, rem(i, info_count))) end)
+    end)
+
+  {compiled_ms, _} =
+    time_ms.(fn ->
+      Enum.each(1..lookups, fn i -> compiled_classify.(domain, elem(infos, rem(i, info_count))) end)
+    end)
+
+  plan = %AriaCore.Plan{id: Path.basename(file), name: label, persona_id: "bench", domain_type: label}
+
+  {plan_ms, {:ok, final_plan}} =
+    time_ms.(fn ->
+      LazyRefinement.run_lazy_refineahead(spec, PlannerAdapter.initial_state_params(domain_state), plan)
+    end)
+
+  actions = final_plan.solution_plan |> Jason.decode!() |> length()
+
+  IO.puts(
+    "#{label}/#{Path.basename(file)}: classify x#{lookups} dict=#{Float.round(dict_ms, 1)}ms " <>
+      "compiled=#{Float.round(compiled_ms, 1)}ms speedup=#{Float.round(dict_ms / max(compiled_ms, 0.001), 2)}x; " <>
+      "plan=#{Float.round(plan_ms, 1)}ms actions=#{actions}"
+  )
+end
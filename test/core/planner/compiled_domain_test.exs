@@ -0,0 +1,114 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2025-present K. S. Ernest (iFire) Lee
+
+defmodule AriaCore.Planner.CompiledDomainTest do
+  use ExUnit.Case, async: true
+
+  alias AriaCore.Planner.{Actions, CompiledDomain, Methods, MultiGoal}
+  alias AriaPlanner.Domains.{AircraftDisassembly, FoxGeeseCorn, Neighbours, TinyCvrp}
+
+  defp task_method(_state, _arg), do: []
+  defp other_task_method(_state, _arg), do: nil
+  defp goal_method(_state, _subject, _value), do: []
+  defp multigoal_method(_state, _multigoal), do: []
+  defp move(state, _to), do: {:ok, state, 1}
+
+  defp domain do
+    methods =
+      Methods.new()
+      |> Methods.add_task_method("t_travel", [&task_method/2, &other_task_method/2])
+      |> Methods.add_goal_method("loc", &goal_method/3)
+      |> Methods.add_multigoal_method(:all_at, &multigoal_method/2)
+
+    actions = Actions.add_action(Actions.new(), "c_move", &move/2)
+
+    CompiledDomain.compile(methods, actions)
+  end
+
+  test "interns every name into a dense symbol" do
+    domain = domain()
+
+    assert CompiledDomain.size(domain) == 4
+    symbols = Map.values(domain.symbols) ++ Map.values(domain.multigoal_symbols)
+    assert Enum.sort(symbols) == [0, 1, 2, 3]
+  end
+
+  test "classifies tasks, actions, goals and multigoals" do
+    domain = domain()
+
+    assert {:T, task} = CompiledDomain.classify(domain, {"t_travel", "home"})
+    assert {:A, action} = CompiledDomain.classify(domain, {"c_move", "home"})
+    assert {:G, goal} = CompiledDomain.classify(domain, {"loc", "robot", "home"})
+    assert {:M, multigoal} = CompiledDomain.classify(domain, MultiGoal.new(:all_at, []))
+
+    assert CompiledDomain.name(domain, task) == "t_travel"
+    assert length(CompiledDomain.handler(domain, task)) == 2
+    assert is_function(CompiledDomain.handler(domain, action), 2)
+    assert [_] = CompiledDomain.handler(domain, goal)
+    assert [_] = CompiledDomain.handler(domain, multigoal)
+  end
+
+  test "unknown names and untagged multigoals" do
+    domain = domain()
+
+    assert CompiledDomain.classify(domain, {"unknown"}) == :unknown
+    assert CompiledDomain.classify(domain, :not_a_tuple) == :unknown
+    assert {:M, nil} = CompiledDomain.classify(domain, MultiGoal.new(:missing, []))
+    assert CompiledDomain.handler(domain, nil) == []
+  end
+
+  test "a task name shadows an action with the same name" do
+    methods = Methods.add_task_method(Methods.new(), "travel", &task_method/2)
+    actions = Actions.add_action(Actions.new(), "travel", &move/2)
+
+    assert {:T, _} = CompiledDomain.classify(CompiledDomain.compile(methods, actions), {"travel", "home"})
+  end
+
+  test "agrees with the method and action dictionaries on every planner domain" do
+    specs = [
+      test_spec(),
+      AircraftDisassembly.PlannerSpec.domain_spec(%{}),
+      FoxGeeseCorn.PlannerSpec.domain_spec(%{}),
+      Neighbours.PlannerSpec.domain_spec(%{}),
+      TinyCvrp.PlannerSpec.domain_spec(%{})
+    ]
+
+    for %{methods: methods, actions: actions} <- specs do
+      domain = CompiledDomain.compile(methods, actions)
+
+      names =
+        Map.keys(methods.task_method_dict) ++ Map.keys(actions.action_dict) ++ Map.keys(methods.goal_method_dict)
+
+      for name <- ["unknown" | names] do
+        expected = dictionary_classify(methods, actions, name)
+
+        actual =
+          case CompiledDomain.classify(domain, {name, nil}) do
+            {type, symbol} -> {type, CompiledDomain.handler(domain, symbol)}
+            :unknown -> :unknown
+          end
+
+        assert actual == expected, "#{inspect(name)} classified as #{inspect(actual)}"
+      end
+    end
+  end
+
+  defp test_spec do
+    methods =
+      Methods.new()
+      |> Methods.add_task_method("t_travel", [&task_method/2, &other_task_method/2])
+      |> Methods.add_goal_method("loc", &goal_method/3)
+
+    %{methods: methods, actions: Actions.add_action(Actions.new(), "c_move", &move/2)}
+  end
+
+  # Classification as refinement did it before compilation: each dictionary in turn
+  defp dictionary_classify(methods, actions, name) do
+    cond do
+      Map.has_key?(methods.task_method_dict, name) -> {:T, List.wrap(methods.task_method_dict[name])}
+      Map.has_key?(actions.action_dict, name) -> {:A, actions.action_dict[name]}
+      Map.has_key?(methods.goal_method_dict, name) -> {:G, List.wrap(methods.goal_method_dict[name])}
+      true -> :unknown
+    end
+  end
+end
@@ -0,0 +1,145 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2025-present K. S. Ernest (iFire) Lee
+
+defmodule AriaCore.Planner.LazyRefinement.BacktrackingTest do
+  use ExUnit.Case, async: true
+
+  alias AriaCore.Planner.{Actions, LazyRefinement, Methods, State}
+  alias AriaCore.Planner.LazyRefinement.{Backtracking, NogoodTable, SolutionGraph}
+
+  # t_outer first sets the switch wrong; t_inner's methods all leave it alone,
+  # so the goal under them can only be met by t_outer's second method
+  defp outer_wrong(_state), do: [{"c_set", :off}, {"t_inner"}]
+  defp outer_right(_state), do: [{"c_set", :on}, {"t_inner"}]
+
+  defp inner(method) do
+    fn _state ->
+      send(self(), {:inner, method})
+      [{"switch", ["main", :on]}]
+    end
+  end
+
+  defp wait(_state, "switch", ["main", :on]), do: [{"c_wait"}]
+
+  defp set(state, value), do: {:ok, State.update_fact(state, "switch", "main", value), 1}
+  defp idle(state), do: {:ok, state, 1}
+
+  defp run(opts) do
+    domain_spec = %{
+      methods:
+        Methods.new()
+        |> Methods.add_task_method("t_outer", [&outer_wrong/1, &outer_right/1])
+        |> Methods.add_task_method("t_inner", [inner(1), inner(2), inner(3)])
+        |> Methods.add_goal_method("switch", &wait/3),
+      actions: Actions.new() |> Actions.add_action("c_set", &set/2) |> Actions.add_action("c_wait", &idle/1),
+      initial_tasks: [{"t_outer"}]
+    }
+
+    state_params = %{
+      current_time: ~U[2025-01-01 00:00:00Z],
+      timeline: %{},
+      entity_capabilities: %{},
+      facts: %{"switch" => %{"main" => :unset}}
+    }
+
+    {:ok, plan} = LazyRefinement.run_lazy_refineahead(domain_spec, state_params, %AriaCore.Plan{id: "bj"}, opts)
+    plan
+  end
+
+  defp inner_methods_tried do
+    receive do
+      {:inner, method} -> [method | inner_methods_tried()]
+    after
+      0 -> []
+    end
+  end
+
+  test "backtracks to the nearest choice point by default" do
+    assert %{execution_status: "completed"} = run([])
+    assert inner_methods_tried() == [1, 2, 3, 1]
+  end
+
+  test "jumps over choice points that did not write the facts a goal failed on" do
+    assert %{execution_status: "completed", solution_plan: plan} = run(backjumping: true)
+    assert inner_methods_tried() == [1, 1]
+    assert Jason.decode!(plan) == [["c_set", "on"]]
+  end
+
+  test "does not remember ancestors above a jumped-over choice point" do
+    state = State.new(~U[2025-01-01 00:00:00Z], %{}, %{}, %{"switch" => %{"main" => :unset}})
+    before_write = State.checkpoint(state)
+    state = State.update_fact(state, "switch", "main", :on)
+    after_write = State.checkpoint(state)
+
+    # t_writer wrote the switch; t_sibling's next method might still have
+    # fixed it, so t_stuck above it has not been shown to fail
+    chain = [
+      {"t_writer", [:retry], before_write},
+      {"t_stuck", [], before_write},
+      {"t_sibling", [:retry], after_write},
+      {"t_done", [], after_write},
+      {"t_check", [], after_write}
+    ]
+
+    {_last, graph} =
+      Enum.reduce(chain, {0, SolutionGraph.new(%{info: {:root}, type: :D, status: :NA, successors: []})}, fn
+        {name, methods, checkpoint}, {parent, graph} ->
+          node = %{
+            info: {name},
+            type: :T,
+            status: :O,
+            successors: [],
+            available_methods: methods,
+            checkpoint: checkpoint,
+            nogood_key: name
+          }
+
+          SolutionGraph.add_children(graph, parent, [node])
+      end)
+
+    graph = SolutionGraph.put(graph, 5, Map.put(SolutionGraph.get(graph, 5), :conflict, [{"switch", "main"}]))
+
+    assert {_parent, 1, graph, _state, _blacklisted, nogoods} =
+             Backtracking.backtrack(graph, 4, 5, state, MapSet.new(), NogoodTable.new(8), backjumping: true)
+
+    assert {[true, true, false, false], nogoods} =
+             Enum.map_reduce(["t_check", "t_done", "t_stuck", "t_sibling"], nogoods, &NogoodTable.failed?(&2, &1))
+
+    # t_writer's last method fails too; t_sibling's were never tried, so
+    # t_writer has not been shown to fail either
+    graph = SolutionGraph.put(graph, 1, %{SolutionGraph.get(graph, 1) | available_methods: []})
+
+    retry = %{
+      info: {"t_retry"},
+      type: :T,
+      status: :O,
+      successors: [],
+      available_methods: [],
+      checkpoint: before_write,
+      nogood_key: "t_retry"
+    }
+
+    {retry_id, graph} = SolutionGraph.add_children(graph, 1, [retry])
+
+    assert {_parent, _child, _graph, _state, _blacklisted, nogoods} =
+             Backtracking.backtrack(graph, 1, retry_id, state, MapSet.new(), nogoods, backjumping: true)
+
+    assert {[true, false], _nogoods} = Enum.map_reduce(["t_retry", "t_writer"], nogoods, &NogoodTable.failed?(&2, &1))
+  end
+
+  test "finds the newest write to a fact on the trail" do
+    state = State.new(~U[2025-01-01 00:00:00Z], %{}, %{}, %{"switch" => %{"main" => :unset}})
+    checkpoint = State.checkpoint(state)
+
+    state =
+      state
+      |> State.update_fact("switch", "main", :on)
+      |> State.update_fact("lamp", "desk", :off)
+      |> State.update_fact("switch", "spare", :on)
+
+    assert State.last_write(state, [{"switch", "main"}]) == 1
+    assert State.last_write(state, [{"switch", "main"}, {"lamp", "desk"}]) == 2
+    assert State.last_write(state, [{"switch", "other"}]) == 0
+    assert State.trail_position(checkpoint) < State.last_write(state, [{"lamp", "desk"}])
+  end
+end
@@ -0,0 +1,102 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2025-present K. S. Ernest (iFire) Lee
+
+defmodule AriaCore.Planner.LazyRefinement.BudgetTest do
+  use ExUnit.Case, async: true
+
+  alias AriaCore.Planner.{Actions, LazyRefinement, Methods}
+  alias AriaCore.Planner.LazyRefinement.Budget
+
+  # The first method's action fails, so refining takes a backtrack
+  defp fly(_state), do: [{"c_fly"}, {"c_land"}]
+  defp drive(_state), do: [{"c_drive"}, {"c_park"}]
+
+  defp domain_spec do
+    %{
+      methods: Methods.add_task_method(Methods.new(), "t_travel", [&fly/1, &drive/1]),
+      actions:
+        Actions.new()
+        |> Actions.add_action("c_fly", fn _state -> {:error, "grounded"} end)
+        |> Actions.add_action("c_land", fn state -> {:ok, state, 1} end)
+        |> Actions.add_action("c_drive", fn state -> {:ok, state, 5} end)
+        |> Actions.add_action("c_park", fn state -> {:ok, state, 1} end),
+      initial_tasks: [{"t_travel"}]
+    }
+  end
+
+  defp run(opts, domain_spec \\ domain_spec()) do
+    state_params = %{current_time: ~U[2025-01-01 00:00:00Z], timeline: %{}, entity_capabilities: %{}, facts: %{}}
+    LazyRefinement.run_lazy_refineahead(domain_spec, state_params, %AriaCore.Plan{id: "budget"}, opts)
+  end
+
+  defp actions(plan), do: Jason.decode!(plan.solution_plan)
+
+  test "runs unbounded by default" do
+    assert {:ok, %{execution_status: "completed"} = plan} = run([])
+    assert actions(plan) == [["c_drive"], ["c_park"]]
+  end
+
+  test "stops at the iteration limit with a partial plan and resumes from there" do
+    assert {:stopped, plan, continuation} = run(max_iterations: 2)
+    assert %{execution_status: "stopped", performance_metrics: %{stopped_by: :iterations}} = plan
+
+    assert {:ok, %{execution_status: "completed"} = plan} = LazyRefinement.resume_lazy_refineahead(continuation)
+    assert actions(plan) == [["c_drive"], ["c_park"]]
+
+    # Resuming again starts from the same point
+    assert {:ok, again} = LazyRefinement.resume_lazy_refineahead(continuation)
+    assert actions(again) == actions(plan)
+  end
+
+  test "stops at the backtrack limit" do
+    assert {:stopped, %{performance_metrics: %{stopped_by: :backtracks}}, continuation} = run(max_backtracks: 1)
+    assert {:ok, %{execution_status: "completed"}} = LazyRefinement.resume_lazy_refineahead(continuation)
+  end
+
+  test "stops in search strategies too" do
+    assert {:stopped, _plan, continuation} = run(strategy: :best_first, max_iterations: 1)
+    assert {:ok, plan} = LazyRefinement.resume_lazy_refineahead(continuation)
+    assert actions(plan) == [["c_drive"], ["c_park"]]
+  end
+
+  test "cancels a portfolio race at the time limit and races it again on resume" do
+    slow_park = fn state ->
+      Process.sleep(300)
+      {:ok, state, 1}
+    end
+
+    spec = Map.update!(domain_spec(), :actions, &Actions.add_action(&1, "c_park", slow_park))
+    started = System.monotonic_time(:millisecond)
+
+    assert {:stopped, plan, continuation} = run([portfolio: 2, time_limit: 50], spec)
+    assert %{performance_metrics: %{stopped_by: :time}} = plan
+    assert System.monotonic_time(:millisecond) - started < 300
+
+    assert {:ok, %{execution_status: "completed"} = plan} = LazyRefinement.resume_lazy_refineahead(continuation)
+    assert actions(plan) == [["c_drive"], ["c_park"]]
+  end
+
+  test "hands the time limit on to other processes" do
+    assert Budget.time_left(Budget.new([], 0)) == :infinity
+    assert Budget.time_left(Budget.new([time_limit: 0], 0)) == 0
+
+    budget = Budget.new([time_limit: 60_000, max_iterations: 1], 5)
+
+    assert %Budget{deadline: deadline, iteration_limit: nil} = Budget.deadline(budget)
+    assert deadline == budget.deadline
+    assert Budget.time_left(budget) in 1..60_000
+  end
+
+  test "checks time and memory" do
+    assert Budget.exhausted(Budget.new([time_limit: 0], 0), 0) == :time
+    assert Budget.exhausted(Budget.new([max_memory: 0], 0), 0) == :memory
+    assert Budget.exhausted(Budget.new([time_limit: 60_000, max_memory: 1_000_000_000_000], 0), 0) == nil
+  end
+
+  test "counts iterations from the call that set the limit" do
+    budget = Budget.new([max_iterations: 3], 10)
+
+    assert Budget.exhausted(budget, 12) == nil
+    assert Budget.exhausted(budget, 13) == :iterations
+  end
+end
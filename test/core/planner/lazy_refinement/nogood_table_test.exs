@@ -0,0 +1,65 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2025-present K. S. Ernest (iFire) Lee
+
+defmodule AriaCore.Planner.LazyRefinement.NogoodTableTest do
+  use ExUnit.Case, async: true
+
+  alias AriaCore.Planner.LazyRefinement.NogoodTable
+  alias AriaCore.Planner.State
+
+  test "counts hits and misses" do
+    table = NogoodTable.new(4) |> NogoodTable.put(:a)
+
+    {true, table} = NogoodTable.failed?(table, :a)
+    {false, table} = NogoodTable.failed?(table, :b)
+    {true, table} = NogoodTable.failed?(table, :a)
+
+    assert NogoodTable.stats(table) == %{size: 1, hits: 2, misses: 1}
+  end
+
+  test "gives entries hit since the hand last passed a second chance" do
+    table = Enum.reduce([:a, :b, :c], NogoodTable.new(3), &NogoodTable.put(&2, &1))
+    {true, table} = NogoodTable.failed?(table, :a)
+
+    # :a is referenced, so :b goes first, then :a once its bit is cleared
+    table = NogoodTable.put(table, :d)
+    assert {[true, false, true, true], table} = lookup(table, [:a, :b, :c, :d])
+
+    table = table |> NogoodTable.put(:e) |> NogoodTable.put(:f) |> NogoodTable.put(:g)
+    assert NogoodTable.stats(table).size == 3
+    assert {[false, false, false], _table} = lookup(table, [:a, :b, :c])
+  end
+
+  test "stores nothing with no capacity" do
+    table = NogoodTable.new(0) |> NogoodTable.put(:a)
+
+    assert {false, table} = NogoodTable.failed?(table, :a)
+    assert NogoodTable.stats(table) == %{size: 0, hits: 0, misses: 0}
+  end
+
+  test "keys on what the state holds rather than how it was reached" do
+    state = State.new(~U[2025-01-01 00:00:00Z], %{}, %{}, %{"door" => %{open: false}})
+    reopened = state |> State.update_fact("door", :open, true) |> State.update_fact("door", :open, false)
+    key = NogoodTable.key(:T, {"t_enter"}, state)
+
+    assert key == NogoodTable.key(:T, {"t_enter"}, reopened)
+    refute key == NogoodTable.key(:G, {"t_enter"}, state)
+    refute key == NogoodTable.key(:T, {"t_enter"}, State.update(state, %{timeline: %{a: 1}}))
+    refute key == NogoodTable.key(:T, {"t_enter"}, %{state | current_time: ~U[2025-01-02 00:00:00Z]})
+  end
+
+  test "keys on the name and a hash of the arguments" do
+    state = State.new(~U[2025-01-01 00:00:00Z], %{}, %{}, %{})
+    snapshot = Map.new(1..1000, &{&1, &1})
+    key = NogoodTable.key(:T, {"t_plan", snapshot}, state)
+
+    assert {:T, "t_plan", args_hash, _fingerprint} = key
+    assert is_integer(args_hash)
+    assert key == NogoodTable.key(:T, {"t_plan", Map.new(snapshot)}, state)
+    refute key == NogoodTable.key(:T, {"t_plan", Map.delete(snapshot, 1)}, state)
+  end
+
+  defp lookup(table, keys) do
+    Enum.map_reduce(keys, table, fn key, table -> NogoodTable.failed?(table, key) end)
+  end
+end
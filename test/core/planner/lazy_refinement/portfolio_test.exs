@@ -0,0 +1,66 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2025-present K. S. Ernest (iFire) Lee
+
+defmodule AriaCore.Planner.LazyRefinement.PortfolioTest do
+  use ExUnit.Case, async: true
+
+  alias AriaCore.Planner.LazyRefinement.Portfolio
+
+  test "the first successful candidate wins and unfinished ones stay untried" do
+    explore = fn
+      :slow ->
+        Process.sleep(5_000)
+        {:ok, :slow}
+
+      :fails ->
+        :failure
+
+      :fast ->
+        Process.sleep(50)
+        {:ok, :fast_result}
+    end
+
+    assert {:ok, :fast, :fast_result, untried} = Portfolio.race([:slow, :fails, :fast, :later], 3, explore)
+    assert untried == [:slow, :later]
+  end
+
+  test "moves on to the next batch when a whole batch fails" do
+    explore = fn
+      {:ok, value} -> {:ok, value}
+      :fails -> :failure
+    end
+
+    assert {:ok, {:ok, 3}, 3, []} = Portfolio.race([:fails, :fails, {:ok, 3}], 2, explore)
+  end
+
+  test "fails when every candidate fails" do
+    assert Portfolio.race([:a, :b, :c], 2, fn _ -> :failure end) == :failure
+    assert Portfolio.race([], 2, fn _ -> {:ok, :never} end) == :failure
+  end
+
+  test "gives up on a race that outlives its timeout" do
+    explore = fn
+      :fails ->
+        :failure
+
+      :slow ->
+        Process.sleep(5_000)
+        {:ok, :slow}
+
+      :out_of_time ->
+        :timeout
+    end
+
+    started = System.monotonic_time(:millisecond)
+
+    assert Portfolio.race([:fails, :slow, :slow], 2, explore, 50) == :timeout
+    assert System.monotonic_time(:millisecond) - started < 5_000
+    assert Portfolio.race([:fails, :out_of_time, :slow], 2, explore) == :timeout
+  end
+
+  test "leaves no worker messages behind" do
+    Portfolio.race([:a, :b], 2, fn candidate -> {:ok, candidate} end)
+
+    refute_received {Portfolio, _, _, _}
+  end
+end
@@ -0,0 +1,92 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2025-present K. S. Ernest (iFire) Lee
+
+defmodule AriaCore.Planner.LazyRefinement.SearchTest do
+  use ExUnit.Case, async: true
+
+  alias AriaCore.Planner.{Actions, LazyRefinement, Methods}
+  alias AriaCore.Planner.LazyRefinement.Search
+
+  defmodule PreferRiding do
+    @behaviour AriaCore.Planner.Heuristic
+
+    @impl true
+    def estimate(_state, pending), do: Enum.sum(Enum.map(pending, &cost/1))
+
+    defp cost({"c_walk"}), do: 100
+    defp cost(_node), do: 1
+  end
+
+  # Walking comes first but takes five times as long as riding
+  defp walk(_state), do: [{"c_walk"}]
+  defp ride(_state), do: [{"c_ride"}]
+
+  defp run(opts) do
+    domain_spec = %{
+      methods: Methods.add_task_method(Methods.new(), "t_travel", [&walk/1, &ride/1]),
+      actions:
+        Actions.new()
+        |> Actions.add_action("c_walk", fn state -> {:ok, state, 10} end)
+        |> Actions.add_action("c_ride", fn state -> {:ok, state, 2} end),
+      initial_tasks: [{"t_travel"}]
+    }
+
+    state_params = %{current_time: ~U[2025-01-01 00:00:00Z], timeline: %{}, entity_capabilities: %{}, facts: %{}}
+
+    {:ok, %{execution_status: "completed"} = plan} =
+      LazyRefinement.run_lazy_refineahead(domain_spec, state_params, %AriaCore.Plan{id: "search"}, opts)
+
+    {Jason.decode!(plan.solution_plan), plan.planning_duration_ms}
+  end
+
+  describe "strategies" do
+    test "depth first takes the first method that applies" do
+      assert run([]) == {[["c_walk"]], 10}
+    end
+
+    test "A* finds the cheapest plan, even without a heuristic" do
+      assert run(strategy: :astar) == {[["c_ride"]], 2}
+      assert run(strategy: :astar, heuristic: PreferRiding, weight: 2) == {[["c_ride"]], 2}
+    end
+
+    test "best first follows the heuristic" do
+      assert run(strategy: :best_first) == {[["c_walk"]], 10}
+      assert run(strategy: :best_first, heuristic: PreferRiding) == {[["c_ride"]], 2}
+    end
+
+    test "beam search keeps the best plans of each generation" do
+      assert run(strategy: :beam, beam_width: 2) == {[["c_ride"]], 2}
+      assert run(strategy: :beam, beam_width: 1) == {[["c_walk"]], 10}
+    end
+  end
+
+  describe "Search" do
+    test "pops the lowest priority first, ties in insertion order" do
+      frontier = Search.new(:astar, 1) |> Search.push(2, :b) |> Search.push(1, :a) |> Search.push(2, :c)
+
+      assert pop_all(frontier) == [:a, :b, :c]
+    end
+
+    test "keeps the best of each beam generation" do
+      frontier = Search.new(:beam, 2) |> Search.push(3, :c) |> Search.push(1, :a) |> Search.push(2, :b)
+
+      {:a, frontier} = Search.pop(frontier)
+      # Pushed while the first generation is expanded: part of the next one
+      frontier = Search.push(frontier, 0, :d)
+
+      assert pop_all(frontier) == [:b, :d]
+    end
+
+    test "rejects unknown strategies" do
+      assert_raise ArgumentError, fn -> Search.new(:random, 1) end
+      assert_raise ArgumentError, fn -> Search.new(:beam, 0) end
+    end
+  end
+
+  defp pop_all(frontier) do
+    case Search.pop(frontier) do
+      {plan, frontier} -> [plan | pop_all(frontier)]
+      :empty -> []
+    end
+  end
+end
@@ -0,0 +1,86 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2025-present K. S. Ernest (iFire) Lee
+
+defmodule AriaCore.Planner.LazyRefinement.SolutionGraphTest do
+  use ExUnit.Case, async: true
+
+  alias AriaCore.Planner.LazyRefinement.GraphOperations
+  alias AriaCore.Planner.LazyRefinement.SolutionGraph
+
+  defp root, do: %{info: {:root}, type: :D, status: :NA, successors: []}
+  defp action(info), do: %{info: info, type: :A, status: :O, successors: []}
+
+  describe "node table" do
+    test "hands out dense ids and records parent links" do
+      graph = SolutionGraph.new(root())
+      {last_id, graph} = SolutionGraph.add_children(graph, 0, [action({:a}), action({:b})])
+
+      assert last_id == 2
+      assert SolutionGraph.successors(graph, 0) == [1, 2]
+      assert SolutionGraph.parent(graph, 1) == 0
+      assert SolutionGraph.parent(graph, 2) == 0
+      assert SolutionGraph.parent(graph, 0) == nil
+      assert SolutionGraph.size(graph) == 3
+    end
+
+    test "appends later batches after existing successors" do
+      graph = SolutionGraph.new(root())
+      {_, graph} = SolutionGraph.add_children(graph, 0, [action({:a})])
+      {last_id, graph} = SolutionGraph.add_children(graph, 0, [action({:b}), action({:c})])
+
+      assert last_id == 3
+      assert SolutionGraph.successors(graph, 0) == [1, 2, 3]
+    end
+
+    test "deleted nodes leave holes without reusing ids" do
+      graph = SolutionGraph.new(root())
+      {_, graph} = SolutionGraph.add_children(graph, 0, [action({:a}), action({:b})])
+      graph = SolutionGraph.delete(graph, 1)
+      {last_id, graph} = SolutionGraph.add_children(graph, 0, [action({:c})])
+
+      assert last_id == 3
+      assert SolutionGraph.get(graph, 1) == nil
+      assert SolutionGraph.size(graph) == 3
+      assert Map.keys(SolutionGraph.to_map(graph)) == [0, 2, 3]
+    end
+  end
+
+  describe "graph operations" do
+    test "find_predecessor answers from the parent table" do
+      graph = SolutionGraph.new(root())
+      {_, graph} = SolutionGraph.add_children(graph, 0, [%{root() | type: :T, status: :C}])
+      {_, graph} = SolutionGraph.add_children(graph, 1, [action({:a})])
+
+      assert GraphOperations.find_predecessor(graph, 2) == 1
+      assert GraphOperations.find_predecessor(graph, 1) == 0
+    end
+
+    test "remove_descendants drops the subtree and its edges" do
+      graph = SolutionGraph.new(root())
+      {_, graph} = SolutionGraph.add_children(graph, 0, [%{root() | type: :T, status: :C}])
+      {_, graph} = SolutionGraph.add_children(graph, 1, [action({:a}), action({:b})])
+
+      graph = GraphOperations.remove_descendants(graph, 1)
+
+      assert SolutionGraph.successors(graph, 1) == []
+      assert SolutionGraph.get(graph, 2) == nil
+      assert SolutionGraph.get(graph, 3) == nil
+      assert SolutionGraph.size(graph) == 2
+    end
+
+    test "extract_solution_plan collects actions in preorder" do
+      graph = SolutionGraph.new(root())
+      {_, graph} = SolutionGraph.add_children(graph, 0, [%{root() | type: :T, status: :C}, action({:c})])
+      {_, graph} = SolutionGraph.add_children(graph, 1, [action({:a}), action({:b})])
+
+      assert GraphOperations.extract_solution_plan(graph) == [{:a}, {:b}, {:c}]
+    end
+
+    test "find_open_node returns :no_open_node when every successor is closed" do
+      graph = SolutionGraph.new(root())
+      {_, graph} = SolutionGraph.add_children(graph, 0, [%{action({:a}) | status: :C}])
+
+      assert GraphOperations.find_open_node(graph, 0) == :no_open_node
+    end
+  end
+end
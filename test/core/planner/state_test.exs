@@ -3,7 +3,7 @@
 
 defmodule AriaCore.Planner.StateTest do
   use ExUnit.Case, async: true
-  alias AriaCore.Planner.State
+  alias AriaCore.Planner.{Actions, LazyRefinement, Methods, State}
 
   describe "State creation and manipulation" do
     test "creates a new state with initial values" do
@@ -71,4 +71,200 @@ defmodule AriaCore.Planner.StateTest do
       assert State.get_fact(state, "non_existent_subject", :location) == nil
     end
   end
+
+  describe "trail" do
+    test "restore unwinds fact writes made since the checkpoint" do
+      state = State.new(DateTime.utc_now(), %{}, %{}, %{"robot1" => %{location: :kitchen}})
+      checkpoint = State.checkpoint(state)
+
+      changed =
+        state
+        |> State.update_fact("robot1", :location, :garage)
+        |> State.update_fact("robot1", :status, :moving)
+        |> State.update_fact("robot2", :location, :hall)
+
+      assert changed.trail_length == 3
+
+      restored = State.restore(changed, checkpoint)
+
+      assert restored.facts == state.facts
+      assert restored.trail_length == 0
+    end
+
+    test "restore returns to an intermediate checkpoint" do
+      state = State.new(DateTime.utc_now(), %{}, %{}, %{"robot1" => %{location: :kitchen}})
+      state = State.update_fact(state, "robot1", :location, :garage)
+      checkpoint = State.checkpoint(state)
+
+      changed =
+        state
+        |> State.update_fact("robot1", :location, :hall)
+        |> Map.put(:current_time, DateTime.add(state.current_time, 5, :second))
+
+      restored = State.restore(changed, checkpoint)
+
+      assert State.get_fact(restored, "robot1", :location) == :garage
+      assert restored.current_time == state.current_time
+      assert restored.trail_length == 1
+    end
+
+    test "update records merged facts on the trail" do
+      state = State.new(DateTime.utc_now(), %{}, %{}, %{"robot1" => %{location: :kitchen}})
+      checkpoint = State.checkpoint(state)
+
+      updated = State.update(state, %{facts: %{"robot1" => %{status: :working}, "robot2" => %{location: :hall}}})
+
+      assert updated.facts == %{"robot1" => %{location: :kitchen, status: :working}, "robot2" => %{location: :hall}}
+      assert State.restore(updated, checkpoint).facts == state.facts
+    end
+
+    test "restore rejects a checkpoint from a longer trail" do
+      state = State.new(DateTime.utc_now(), %{}, %{}, %{})
+      checkpoint = state |> State.update_fact("robot1", :location, :garage) |> State.checkpoint()
+
+      assert_raise ArgumentError, fn -> State.restore(state, checkpoint) end
+    end
+
+    test "truncate keeps later checkpoints restorable and rejects earlier ones" do
+      state = State.new(DateTime.utc_now(), %{}, %{}, %{"robot1" => %{location: :kitchen}})
+      early = State.checkpoint(state)
+      state = State.update_fact(state, "robot1", :location, :garage)
+      late = State.checkpoint(state)
+
+      changed = state |> State.update_fact("robot1", :location, :hall) |> State.truncate_trail(1)
+
+      assert State.trail_size(changed) == 1
+      assert changed.trail_length == 2
+      assert State.get_fact(State.restore(changed, late), "robot1", :location) == :garage
+      assert_raise ArgumentError, fn -> State.restore(changed, early) end
+    end
+
+    test "stays bounded over a long planning run" do
+      domain_spec = %{
+        methods: Methods.add_task_method(Methods.new(), "t_count", &count/2),
+        actions: Actions.add_action(Actions.new(), "c_tick", &tick/2),
+        initial_tasks: [{"t_count", 3000}]
+      }
+
+      state_params = %{current_time: ~U[2025-01-01 00:00:00Z], timeline: %{}, entity_capabilities: %{}, facts: %{}}
+
+      assert {:ok, %{execution_status: "completed"}} =
+               LazyRefinement.run_lazy_refineahead(domain_spec, state_params, %AriaCore.Plan{id: "trail"})
+
+      # One write per tick, but only the writes since the last truncation are kept
+      assert trail_sizes() |> Enum.max() < 1100
+    end
+  end
+
+  defp count(_state, 1), do: [{"c_tick", 1}]
+  defp count(_state, n), do: [{"c_tick", n}, {"t_count", n - 1}]
+
+  defp tick(state, n) do
+    send(self(), {:trail_size, State.trail_size(state)})
+    {:ok, State.update_fact(state, "counter", "n", n), 1}
+  end
+
+  defp trail_sizes do
+    receive do
+      {:trail_size, size} -> [size | trail_sizes()]
+    after
+      0 -> []
+    end
+  end
+
+  describe "fingerprint" do
+    test "tracks the facts through writes, updates and restores" do
+      state = State.new(~U[2025-01-01 00:00:00Z], %{}, %{}, %{"robot1" => %{location: :kitchen}, "door" => :closed})
+      checkpoint = State.checkpoint(state)
+
+      changed =
+        state
+        |> State.update_fact("robot1", :location, :garage)
+        |> State.update_fact("robot2", :location, :hall)
+        |> State.update(%{facts: %{"robot1" => %{status: :working}, "door" => :open}})
+
+      rebuilt = State.new(state.current_time, %{}, %{}, changed.facts)
+
+      assert State.fingerprint(changed) == State.fingerprint(rebuilt)
+      assert State.fingerprint(changed) != State.fingerprint(state)
+      assert State.equal?(changed, rebuilt)
+
+      restored = State.restore(changed, checkpoint)
+
+      assert State.fingerprint(restored) == State.fingerprint(state)
+      assert State.equal?(restored, state)
+    end
+
+    test "does not depend on the order facts were written in" do
+      state = State.new(~U[2025-01-01 00:00:00Z], %{}, %{}, %{})
+      one = state |> State.update_fact("a", :x, 1) |> State.update_fact("b", :y, 2)
+      other = state |> State.update_fact("b", :y, 2) |> State.update_fact("a", :x, 0) |> State.update_fact("a", :x, 1)
+
+      assert State.fingerprint(one) == State.fingerprint(other)
+      assert State.equal?(one, other)
+      refute State.equal?(one, %{other | current_time: ~U[2025-01-02 00:00:00Z]})
+      refute State.equal?(one, State.update_fact(other, "a", :x, 2))
+    end
+
+    test "rehashes nested facts down to the changed leaves" do
+      facts = %{"activity_status" => %{1 => %{status: "not_started"}, 2 => %{status: "not_started"}}, "clock" => 0}
+      state = State.new(~U[2025-01-01 00:00:00Z], %{}, %{}, facts)
+      checkpoint = State.checkpoint(state)
+
+      changed =
+        state
+        |> State.put_subject("activity_status", %{1 => %{status: "in_progress"}, 3 => %{status: "not_started"}})
+        |> State.update_fact("activity_status", 3, %{status: "completed", by: "robot1"})
+        |> State.put_subject("clock", %{hour: 1})
+
+      rebuilt = State.new(state.current_time, %{}, %{}, changed.facts)
+
+      assert State.fingerprint(changed) == State.fingerprint(rebuilt)
+      assert State.fingerprint(State.restore(changed, checkpoint)) == State.fingerprint(state)
+      assert State.fingerprint(State.delete_subject(changed, "clock")) != State.fingerprint(changed)
+    end
+
+    test "leaves derived facts out" do
+      state = State.new(~U[2025-01-01 00:00:00Z], %{}, %{}, %{"door" => %{open: false}, ready: [1, 2]}, [:ready])
+      changed = State.put_subject(state, :ready, [2])
+
+      assert State.fingerprint(changed) == State.fingerprint(state)
+      assert State.fingerprint(State.delete_subject(changed, :ready)) == State.fingerprint(state)
+      refute State.equal?(changed, state)
+      assert State.fingerprint(State.update_fact(changed, "door", :open, true)) != State.fingerprint(state)
+    end
+
+    test "covers the timeline and entity capabilities set through update/2" do
+      capabilities = %{"robot1" => %{speed: 1}}
+      state = State.new(~U[2025-01-01 00:00:00Z], %{}, capabilities, %{})
+      checkpoint = State.checkpoint(state)
+      changed = State.update(state, %{timeline: %{"move" => {0, 5}}})
+      rebuilt = State.new(state.current_time, %{"move" => {0, 5}}, capabilities, %{})
+
+      assert State.fingerprint(changed) == State.fingerprint(rebuilt)
+      assert State.fingerprint(changed) != State.fingerprint(state)
+      assert State.fingerprint(State.update(changed, %{timeline: %{}})) == State.fingerprint(state)
+      assert State.fingerprint(State.update(state, %{entity_capabilities: %{}})) != State.fingerprint(state)
+      assert State.fingerprint(State.restore(changed, checkpoint)) == State.fingerprint(state)
+    end
+  end
+
+  describe "JSON encoding" do
+    test "encodes domain facts holding tuples, tuple keys and sets" do
+      facts = %{grid: %{{1, 2} => 3}, route: [{1, 2}], seen: MapSet.new([2, 1]), "robot1" => %{location: :hall}}
+      state = State.update_fact(State.new(~U[2025-01-01 00:00:00Z], %{}, %{}, facts), "robot1", :location, :garage)
+
+      decoded = state |> Jason.encode!() |> Jason.decode!()
+
+      assert decoded["facts"] == %{
+               "grid" => %{"{1, 2}" => 3},
+               "route" => [[1, 2]],
+               "seen" => [1, 2],
+               "robot1" => %{"location" => "garage"}
+             }
+
+      assert decoded["current_time"] == "2025-01-01T00:00:00Z"
+      refute Map.has_key?(decoded, "trail")
+    end
+  end
 end
@@ -0,0 +1,82 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2025-present K. S. Ernest (iFire) Lee
+
+defmodule AriaCore.Planner.TraceTest do
+  use ExUnit.Case, async: false
+
+  alias AriaCore.Planner.{Actions, LazyRefinement, Methods}
+
+  @events [
+    [:aria_planner, :lazy_refinement, :run, :stop],
+    [:aria_planner, :lazy_refinement, :iteration],
+    [:aria_planner, :lazy_refinement, :refine, :stop],
+    [:aria_planner, :lazy_refinement, :action, :stop],
+    [:aria_planner, :lazy_refinement, :backtrack, :stop],
+    [:aria_planner, :lazy_refinement, :nogoods]
+  ]
+
+  def handle_event(event, measurements, metadata, pid), do: send(pid, {:event, event, measurements, metadata})
+
+  setup do
+    handler_id = "trace-test-#{inspect(self())}"
+    :ok = :telemetry.attach_many(handler_id, @events, &__MODULE__.handle_event/4, self())
+    on_exit(fn -> :telemetry.detach(handler_id) end)
+  end
+
+  defp go(_state, _to), do: [{"c_step", :a}, {"c_step", :b}]
+  defp step(state, :b), do: {:ok, state, 5}
+  defp step(_state, _to), do: {:error, "blocked"}
+  defp step_anywhere(state, _to), do: {:ok, state, 5}
+
+  # Both ways of going round lead to the same task in the same state
+  defp round_left(_state, to), do: [{"t_go", to}]
+  defp round_right(_state, to), do: [{"t_go", to}]
+
+  defp run(action, methods \\ Methods.add_task_method(Methods.new(), "t_go", &go/2), initial_tasks \\ [{"t_go", :b}]) do
+    domain_spec = %{
+      methods: methods,
+      actions: Actions.add_action(Actions.new(), "c_step", action),
+      initial_tasks: initial_tasks
+    }
+
+    state_params = %{current_time: ~U[2025-01-01 00:00:00Z], timeline: %{}, entity_capabilities: %{}, facts: %{}}
+    LazyRefinement.run_lazy_refineahead(domain_spec, state_params, %AriaCore.Plan{id: "plan-trace"}, nogoods: 64)
+  end
+
+  test "reports the run, each iteration, refinement and action" do
+    assert {:ok, %{execution_status: "completed"}} = run(&step_anywhere/2)
+
+    assert_received {:event, [:aria_planner, :lazy_refinement, :run, :stop], %{duration: _}, %{plan_id: "plan-trace"}}
+    assert_received {:event, [:aria_planner, :lazy_refinement, :refine, :stop], _, %{type: :T, info: {"t_go", :b}}}
+    assert_received {:event, [:aria_planner, :lazy_refinement, :action, :stop], _, %{info: {"c_step", :a}}}
+    assert_received {:event, [:aria_planner, :lazy_refinement, :action, :stop], _, %{info: {"c_step", :b}}}
+
+    assert_received {:event, [:aria_planner, :lazy_refinement, :iteration], %{duration: duration},
+                     %{iteration: 0, type: :T, transition: :descend}}
+
+    assert is_integer(duration)
+    refute_received {:event, [:aria_planner, :lazy_refinement, :backtrack, :stop], _, _}
+  end
+
+  test "reports backtracks" do
+    assert {:ok, %{execution_status: "failed"}} = run(&step/2)
+
+    assert_received {:event, [:aria_planner, :lazy_refinement, :iteration], _, %{type: :A, transition: :backtrack}}
+    assert_received {:event, [:aria_planner, :lazy_refinement, :backtrack, :stop], _, %{node_id: _}}
+  end
+
+  test "skips refinements that already failed in the same state" do
+    methods =
+      Methods.new()
+      |> Methods.add_task_method("t_go", &go/2)
+      |> Methods.add_task_method("t_round", [&round_left/2, &round_right/2])
+
+    assert {:ok, %{execution_status: "failed"}} = run(&step/2, methods, [{"t_round", :b}])
+
+    # t_go fails under the first method and is not refined again under the second
+    assert_received {:event, [:aria_planner, :lazy_refinement, :refine, :stop], _, %{info: {"t_go", :b}}}
+    refute_received {:event, [:aria_planner, :lazy_refinement, :refine, :stop], _, %{info: {"t_go", :b}}}
+
+    assert_received {:event, [:aria_planner, :lazy_refinement, :nogoods], %{hits: 1, size: 2}, %{plan_id: "plan-trace"}}
+  end
+end
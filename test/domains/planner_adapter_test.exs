@@ -0,0 +1,37 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2025-present K. S. Ernest (iFire) Lee
+
+defmodule AriaPlanner.Domains.PlannerAdapterTest do
+  use ExUnit.Case, async: true
+
+  alias AriaCore.Planner.State
+  alias AriaPlanner.Domains.PlannerAdapter
+
+  describe "commit/3" do
+    test "replaces changed entries wholesale" do
+      facts = %{
+        "activity_status" => %{1 => "completed", 2 => "in_progress"},
+        "done" => MapSet.new([1, 2]),
+        "num_activities" => 2,
+        "scratch" => :unused
+      }
+
+      state = State.new(~U[2025-01-01 00:00:00Z], %{}, %{}, facts)
+      checkpoint = State.checkpoint(state)
+
+      # The command deletes a nested key, replaces a set and drops an entry
+      new_facts = %{"activity_status" => %{1 => "completed"}, "done" => MapSet.new([3]), "num_activities" => 2}
+
+      assert {:ok, committed, 5} = PlannerAdapter.commit(state, {:ok, new_facts}, 5)
+      assert committed.facts == new_facts
+      assert State.trail_size(committed) == 3
+      assert State.fingerprint(committed) == State.fingerprint(State.new(state.current_time, %{}, %{}, new_facts))
+      assert State.restore(committed, checkpoint).facts == facts
+    end
+
+    test "passes command errors through" do
+      state = State.new(~U[2025-01-01 00:00:00Z], %{}, %{}, %{})
+      assert PlannerAdapter.commit(state, {:error, "blocked"}, 5) == {:error, "blocked"}
+    end
+  end
+end
@@ -0,0 +1,197 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2025-present K. S. Ernest (iFire) Lee
+
+defmodule AriaPlanner.Domains.AircraftDisassemblyTest do
+  @moduledoc """
+  Aircraft disassembly scheduling: activities with durations, precedences,
+  skilled resources with unavailability periods and location capacities.
+  """
+
+  use ExUnit.Case, async: true
+
+  alias AriaPlanner.Domains.AircraftDisassembly
+  alias AriaPlanner.Domains.AircraftDisassembly.{ActivityModel, StateHelpers, Timeline}
+  alias AriaPlanner.Domains.AircraftDisassembly.Commands.{CompleteActivity, StartActivity}
+  alias AriaPlanner.Domains.AircraftDisassembly.Tasks.ScheduleActivities
+
+  @aircraft Path.join([__DIR__, "../../../thirdparty/mznc2024_probs/aircraft-disassembly"])
+
+  setup_all do
+    {:ok, params} = AircraftDisassembly.parse_dzn_file(Path.join(@aircraft, "B737NG-600-01-Anon.json.dzn"))
+    {:ok, state} = AircraftDisassembly.initialize_state(params)
+    %{state: state}
+  end
+
+  describe "activity model" do
+    test "indexes per-activity and per-resource data", %{state: state} do
+      model = state.model
+
+      assert ActivityModel.duration(model, 1) == 32
+      assert ActivityModel.location(model, 1) == 4
+      assert ActivityModel.occupancy(model, 1) == 2
+      assert ActivityModel.location_capacity(model, 14) == 19
+      assert ActivityModel.skill_requirement(model, 1, 1) == 1
+      assert ActivityModel.skill_requirement(model, 1, 2) == 1
+      assert ActivityModel.skill_requirement(model, 1, 3) == 0
+      assert ActivityModel.unavailable_periods(model, 2) == [{96, 224}, {1632, 1760}]
+    end
+
+    test "stores mastery and useful resources as bitsets", %{state: state} do
+      model = state.model
+
+      assert ActivityModel.has_skill?(model, 1, 1)
+      refute ActivityModel.has_skill?(model, 1, 2)
+      assert ActivityModel.has_skill?(model, 20, 3)
+      assert ActivityModel.members(ActivityModel.skill_resources(model, 2)) == Enum.to_list(12..17) ++ [20, 21]
+      assert ActivityModel.members(ActivityModel.useful_resources(model, 1)) == Enum.to_list(1..21)
+
+      available = ActivityModel.members(ActivityModel.available_resources(model, 0, 32))
+      refute 1 in available
+      refute 14 in available
+      assert 2 in available
+    end
+
+    test "indexes unavailability by time", %{state: state} do
+      model = state.model
+
+      for from <- 0..2000//37 do
+        to = from + 50
+
+        expected =
+          for resource <- 1..21,
+              Enum.all?(ActivityModel.unavailable_periods(model, resource), fn {start, stop} ->
+                to <= start or from >= stop
+              end),
+              do: resource
+
+        assert ActivityModel.members(ActivityModel.available_resources(model, from, to)) == expected
+      end
+
+      assert 1 in ActivityModel.members(ActivityModel.available_resources(model, 160, 161))
+    end
+
+    test "is rebuilt from the list fields when a state carries none", %{state: state} do
+      assert ActivityModel.of(Map.delete(state, :model)) == state.model
+    end
+  end
+
+  describe "state initialization" do
+    test "keys activity status by activity number", %{state: state} do
+      assert map_size(state.facts["activity_status"]) == 16
+      assert StateHelpers.get_activity_status(state, 1) == "not_started"
+      refute AircraftDisassembly.all_activities_completed?(state)
+    end
+  end
+
+  describe "ready queue" do
+    setup do
+      params = %{
+        num_activities: 3,
+        num_resources: 1,
+        nSkills: 1,
+        durations: [1, 1, 1],
+        precedences: [{1, 3}, {2, 3}],
+        sreq: [1, 1, 1],
+        mastery: [true],
+        locations: [1, 1, 1],
+        location_capacities: [2],
+        occupancy: [1, 1, 1]
+      }
+
+      {:ok, state} = AircraftDisassembly.initialize_state(params)
+      %{small: state}
+    end
+
+    test "releases an activity when its last predecessor completes", %{small: state} do
+      assert :gb_sets.to_list(state.ready) == [1, 2]
+
+      state = StateHelpers.put_activity_status(state, 1, "in_progress")
+      assert :gb_sets.to_list(state.ready) == [2]
+      assert StateHelpers.location_load(state, 1) == 1
+
+      state = StateHelpers.put_activity_status(state, 1, "completed")
+      assert :gb_sets.to_list(state.ready) == [2]
+      assert StateHelpers.location_load(state, 1) == 0
+      refute StateHelpers.all_predecessors_completed?(state, 3)
+
+      state = StateHelpers.put_activity_status(state, 2, "completed")
+      assert :gb_sets.to_list(state.ready) == [3]
+      assert StateHelpers.all_predecessors_completed?(state, 3)
+      refute AircraftDisassembly.all_activities_completed?(state)
+
+      state = StateHelpers.put_activity_status(state, 3, "completed")
+      assert AircraftDisassembly.all_activities_completed?(state)
+    end
+
+    test "is rebuilt from the statuses when a state carries none", %{small: state} do
+      state = StateHelpers.put_activity_status(state, 1, "completed")
+      rebuilt = StateHelpers.with_schedule(Map.drop(state, [:in_degree, :ready, :location_load, :remaining_activities]))
+
+      assert Map.take(rebuilt, [:in_degree, :location_load, :remaining_activities]) ==
+               Map.take(state, [:in_degree, :location_load, :remaining_activities])
+
+      assert :gb_sets.to_list(rebuilt.ready) == :gb_sets.to_list(state.ready)
+    end
+
+    test "bookings block their location and resources for their duration", %{small: state} do
+      state = StateHelpers.book_activity(state, 1, 5, [1])
+
+      assert StateHelpers.location_peak(state, 1, 0, 5) == 0
+      assert StateHelpers.location_peak(state, 1, 5, 6) == 1
+      assert StateHelpers.free_resources(state, 1, 4, 5) == 1
+      assert StateHelpers.free_resources(state, 1, 5, 6) == 0
+      assert StateHelpers.free_resources(state, 1, 6, 7) == 1
+    end
+  end
+
+  describe "timeline" do
+    test "peak is the largest cumulative booking over a range" do
+      timeline =
+        Timeline.new(4)
+        |> Timeline.add(0, 10, 1)
+        |> Timeline.add(5, 20, 2)
+        |> Timeline.add(3000, 3010, 4)
+
+      assert Timeline.peak(timeline, 0, 5) == 1
+      assert Timeline.peak(timeline, 4, 6) == 3
+      assert Timeline.peak(timeline, 10, 20) == 2
+      assert Timeline.peak(timeline, 20, 3000) == 0
+      assert Timeline.peak(timeline, 2999, 3001) == 4
+      assert Timeline.peak(timeline, 7, 7) == 0
+    end
+
+    test "matches a brute-force occupancy count" do
+      bookings = for from <- 0..200//13, do: {from, from + rem(from * 7, 40) + 1, rem(from, 3) + 1}
+      timeline = Enum.reduce(bookings, Timeline.new(), fn {from, to, n}, acc -> Timeline.add(acc, from, to, n) end)
+
+      for from <- 0..250//11, to <- [from + 1, from + 17] do
+        expected =
+          from..(to - 1)
+          |> Enum.map(fn time -> for({f, t, a} <- bookings, f <= time and time < t, do: a) |> Enum.sum() end)
+          |> Enum.max()
+
+        assert Timeline.peak(timeline, from, to) == expected
+      end
+    end
+  end
+
+  describe "scheduling" do
+    test "t_schedule_activities staffs every required skill with available resources", %{state: state} do
+      # Resource 1 is unavailable until hour 160; resource 12 covers skills 1 and 2
+      assert [{"c_start_activity", 1, 0, [2, 12]}, {"t_schedule_activities", _}] =
+               ScheduleActivities.t_schedule_activities(state)
+    end
+
+    test "c_start_activity and c_complete_activity update the status", %{state: state} do
+      {:ok, started, _metadata} = StartActivity.c_start_activity(state, 1, "2025-01-01T00:00:00Z", [2, 12])
+      assert StateHelpers.get_activity_status(started, 1) == "in_progress"
+
+      {:ok, completed, _metadata} = CompleteActivity.c_complete_activity(started, 1)
+      assert StateHelpers.get_activity_status(completed, 1) == "completed"
+    end
+
+    test "c_start_activity rejects resources lacking a required skill", %{state: state} do
+      assert {:error, _} = StartActivity.c_start_activity(state, 1, "2025-01-01T00:00:00Z", [2, 3])
+    end
+  end
+end
@@ -0,0 +1,73 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2025-present K. S. Ernest (iFire) Lee
+
+defmodule AriaPlanner.Domains.AircraftDisassembly.DznParserTest do
+  use ExUnit.Case, async: true
+
+  alias AriaPlanner.Domains.AircraftDisassembly.DznParser
+
+  @aircraft Path.join([__DIR__, "../../../thirdparty/mznc2024_probs/aircraft-disassembly"])
+
+  describe "decode/1" do
+    test "decodes scalars, arrays, sets and ranges" do
+      content = """
+      % comment
+      n = 3; neg = -12; f = 1.5e2; ok = true; name = "a \\"b\\"";
+      xs = [1, 2, 3,]; s = {3, 1..2}; r = 1..4; empty = {}; absent = [<>, 1];
+      """
+
+      assert {:ok, values} = DznParser.decode(content)
+      assert values["n"] == 3
+      assert values["neg"] == -12
+      assert values["f"] == 150.0
+      assert values["ok"] == true
+      assert values["name"] == ~s(a "b")
+      assert values["xs"] == [1, 2, 3]
+      assert values["s"] == MapSet.new([1, 2, 3])
+      assert values["r"] == 1..4
+      assert values["empty"] == MapSet.new()
+      assert values["absent"] == [nil, 1]
+    end
+
+    test "decodes array2d as a flat list and 2d literals as rows" do
+      content = "a = array2d(1..n, SKILL, [true, false, {1}, {}]); b = [| 1, 2, | 3, 4 |]"
+
+      assert {:ok, %{"a" => [true, false, set, empty], "b" => [[1, 2], [3, 4]]}} = DznParser.decode(content)
+      assert set == MapSet.new([1])
+      assert empty == MapSet.new()
+    end
+
+    test "reports malformed input instead of guessing" do
+      assert {:error, _} = DznParser.decode("n = [1, 2;")
+      assert {:error, _} = DznParser.decode("n = 1 2;")
+      assert {:error, _} = DznParser.decode("n = ?;")
+    end
+  end
+
+  describe "decode_file/2" do
+    test "tokens split across chunk boundaries decode the same" do
+      path = Path.join(@aircraft, "B737NG-600-02-Anon.json.dzn")
+
+      assert DznParser.decode_file(path, 7) == DznParser.decode(File.read!(path))
+      assert DznParser.decode_file(path, 1) == DznParser.decode_file(path)
+    end
+
+    test "missing files are an error" do
+      assert {:error, "Failed to read file: " <> _} = DznParser.decode_file("does/not/exist.dzn")
+    end
+  end
+
+  test "parse_file/1 keys the aircraft-disassembly parameters" do
+    {:ok, params} = DznParser.parse_file(Path.join(@aircraft, "B737NG-600-01-Anon.json.dzn"))
+
+    assert params.num_activities == 16
+    assert params.num_resources == 21
+    assert length(params.durations) == 16
+    assert length(params.sreq) == 16 * 3
+    assert length(params.mastery) == 21 * 3
+    assert %MapSet{} = hd(params.useful_res)
+    assert params.M == MapSet.new([1, 2])
+    assert length(params.unrelated) == 120
+    assert params.precedences == []
+  end
+end
@@ -0,0 +1,58 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2025-present K. S. Ernest (iFire) Lee
+
+defmodule AriaPlanner.Planner.BenchmarkTest do
+  use ExUnit.Case, async: false
+
+  alias AriaPlanner.Planner.Benchmark
+  alias AriaPlanner.Planner.Benchmark.STNBatch
+
+  @root Path.join([__DIR__, "../../thirdparty"])
+
+  test "discovers the instances of every wired domain" do
+    instances = Benchmark.instances(@root)
+    domains = instances |> Enum.map(&elem(&1, 0)) |> Enum.uniq()
+
+    assert domains == ["aircraft-disassembly", "fox-geese-corn", "neighbours", "tiny-cvrp"]
+    assert Enum.all?(instances, fn {_domain, path} -> Path.extname(path) == ".dzn" end)
+    assert [{"neighbours", _} | _] = Benchmark.instances(@root, ["neighbours"])
+  end
+
+  test "measures a planning run" do
+    path = Path.join([@root, "mznc2024_probs/neighbours/neightbours-new-2.dzn"])
+    result = Benchmark.run("neighbours", path)
+
+    assert result.status == "completed"
+    assert result.instance == "neightbours-new-2.dzn"
+    # One assignment per cell of the 4x2 grid
+    assert result.actions == 8
+    assert result.iterations > result.actions
+    assert result.backtracks == 0
+    assert result.wall_time_us > 0
+    assert result.peak_memory_bytes > 0
+    assert result.reductions > 0
+  end
+
+  test "plans every aircraft-disassembly activity" do
+    path = Path.join([@root, "mznc2024_probs/aircraft-disassembly/B737NG-600-01-Anon.json.dzn"])
+    result = Benchmark.run("aircraft-disassembly", path)
+
+    assert result.status == "completed"
+    assert result.actions == 16
+  end
+
+  test "batch STN solving agrees with per-network path consistency" do
+    result = STNBatch.run(8, 12)
+
+    assert result.stns == 8
+    assert result.agree
+    assert result.sequential_us > 0
+    assert result.batch_us > 0
+  end
+
+  test "report is JSON encodable" do
+    report = Benchmark.report([])
+
+    assert %{"results" => [], "elixir" => _} = report |> Jason.encode!() |> Jason.decode!()
+  end
+end
@@ -0,0 +1,130 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2025-present K. S. Ernest (iFire) Lee
+
+defmodule AriaPlanner.Solvers.CpSolverTest do
+  use ExUnit.Case, async: true
+
+  alias AriaPlanner.Solvers.{AriaChuffedSolver, CpSolver, FlatZincGenerator, FlatZincParser}
+
+  describe "solve/2" do
+    test "minimizes over linear constraints" do
+      model = %{
+        variables: [{:x, :int, 1, 10}, {:y, :int, 1, 10}],
+        constraints: [{:int_eq, {:+, :x, :y}, 10}],
+        objective: {:minimize, :x}
+      }
+
+      assert {:ok, %{status: "optimal", variables: %{x: 1, y: 9}, objective: 1}} = CpSolver.solve(model)
+    end
+
+    test "maximizes over nonlinear constraints" do
+      model = %{
+        variables: [{:x, :int, 1, 10}, {:y, :int, 1, 10}, {:area, :int, 0, 100}],
+        constraints: [{:int_eq, {:+, :x, :y}, 10}, {:int_eq, :area, {:*, :x, :y}}],
+        objective: {:maximize, :area}
+      }
+
+      assert {:ok, %{status: "optimal", variables: %{x: 5, y: 5, area: 25}}} = CpSolver.solve(model)
+    end
+
+    test "stops optimising within the objective gap" do
+      model = %{
+        variables: [{:total, :int, 0, 100}, {:a, :int, 1, 4}, {:b, :int, 1, 4}, {:c, :int, 1, 4}, {:d, :int, 1, 4}],
+        constraints: [{:all_different, [:a, :b, :c, :d]}, {:int_eq, :total, {:sum, [:a, :b, :c, :d]}}],
+        objective: {:minimize, :total}
+      }
+
+      # Propagation alone bounds the total by 4, 6 away from the first solution's 10
+      assert {:ok, %{status: "satisfied", objective: 10}} = CpSolver.solve(model, gap: 0.9)
+      assert {:ok, %{status: "optimal", objective: 10}} = CpSolver.solve(model)
+    end
+
+    test "places four queens" do
+      queens = [:q1, :q2, :q3, :q4]
+
+      diagonals =
+        for {a, i} <- Enum.with_index(queens), {b, j} <- Enum.with_index(queens), i < j, sign <- [1, -1] do
+          {:int_ne, {:-, a, b}, sign * (j - i)}
+        end
+
+      model = %{
+        variables: Enum.map(queens, &{&1, :int, 1, 4}),
+        constraints: [{:all_different, queens} | diagonals]
+      }
+
+      assert {:ok, %{status: "satisfied", variables: placement}} = CpSolver.solve(model)
+      assert Enum.map(queens, &placement[&1]) in [[2, 4, 1, 3], [3, 1, 4, 2]]
+    end
+
+    test "propagates element and global cardinality constraints" do
+      model = %{
+        variables: [{:i, :int, 1, 3}, {:v, :int, 0, 100}, {:a, :int, 1, 2}, {:b, :int, 1, 2}, {:c, :int, 1, 2}],
+        constraints: [
+          {:array_element, {:array, [10, 20, 30]}, :i, :v},
+          {:int_ge, :v, 15},
+          {:global_cardinality, [:a, :b, :c], {:array, [2, 1]}, {:array, [2, 1]}},
+          {:int_eq, :a, 2}
+        ],
+        objective: {:minimize, :v}
+      }
+
+      assert {:ok, %{variables: %{i: 2, v: 20, a: 2, b: 1, c: 1}}} = CpSolver.solve(model)
+    end
+
+    test "solves boolean constraints" do
+      model = %{
+        variables: [{:p, :bool}, {:q, :bool}],
+        constraints: [{:bool_or, :p, :q}, {:bool_not, :p}]
+      }
+
+      assert {:ok, %{variables: %{p: false, q: true}}} = CpSolver.solve(model)
+    end
+
+    test "reports unsatisfiable models and unknown variables" do
+      assert CpSolver.solve(%{variables: [{:x, :int, 1, 3}], constraints: [{:int_gt, :x, 5}]}) ==
+               {:error, "Unsatisfiable"}
+
+      assert {:error, "Unknown variable" <> _} =
+               CpSolver.solve(%{variables: [{:x, :int, 1, 3}], constraints: [{:int_eq, :x, :y}]})
+    end
+  end
+
+  describe "FlatZincParser.parse/1" do
+    test "reads FlatZinc builtins, parameters and annotations" do
+      flatzinc = """
+      % Two of a kind
+      array [1..2] of int: coeffs = [2, 3];
+      var 0..10: a :: output_var;
+      var 0..10: b :: output_var;
+      constraint int_lin_eq(coeffs, [a, b], 12) :: domain;
+      constraint int_le(b, a);
+      solve :: int_search([a, b], input_order, indomain_min, complete) maximize b;
+      """
+
+      assert {:ok, model} = FlatZincParser.parse(flatzinc)
+      assert model.variables == [{"a", :int, 0, 10}, {"b", :int, 0, 10}]
+      assert {:ok, %{variables: %{"a" => 3, "b" => 2}, objective: 2}} = CpSolver.solve(model)
+    end
+
+    test "reports syntax errors" do
+      assert {:error, "Expected ;" <> _} = FlatZincParser.parse("var 1..3: x")
+    end
+  end
+
+  describe "AriaChuffedSolver" do
+    test "solves generated FlatZinc in process" do
+      model = %{
+        variables: [{:x, :int, 1, 10}, {:y, :int, 1, 10}],
+        constraints: [{:int_eq, {:+, :x, :y}, 10}, {:int_ge, {:-, :x, :y}, 2}],
+        objective: {:minimize, :x}
+      }
+
+      assert AriaChuffedSolver.available?()
+
+      assert {:ok, %{variables: %{"x" => 6, "y" => 4}}} =
+               model |> FlatZincGenerator.generate() |> AriaChuffedSolver.solve_flatzinc()
+
+      assert {:ok, %{variables: %{x: 6, y: 4}}} = AriaChuffedSolver.solve(model)
+    end
+  end
+end
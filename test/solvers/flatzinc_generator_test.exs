@@ -94,6 +94,28 @@ defmodule AriaPlanner.Solvers.FlatZincGeneratorTest do
       assert String.contains?(flatzinc, "z")
     end
 
+    test "lays out one item per line under each section header" do
+      constraints = %{
+        variables: [{:x, :int, 1, 10}, {"y", :bool}],
+        constraints: [{:int_eq, {:+, :x, :y}, 10}, {:all_different, [:x, "y"]}],
+        objective: {:minimize, :x}
+      }
+
+      assert FlatZincGenerator.generate(constraints) == """
+             % Generated FlatZinc for AriaPlanner
+             % Variables
+             var 1..10: x;
+             var bool: y;
+
+             % Constraints
+             constraint (x + y) = 10;
+             constraint all_different([x, y]);
+
+             % Objective
+             solve minimize x;
+             """
+    end
+
     test "handles empty constraints" do
       flatzinc = FlatZincGenerator.generate(%{})
 
@@ -106,4 +128,24 @@ defmodule AriaPlanner.Solvers.FlatZincGeneratorTest do
       assert String.contains?(flatzinc, "solve satisfy;")
     end
   end
+
+  describe "stream/1 and write_file/2" do
+    @tag :tmp_dir
+    test "write the same FlatZinc as generate/1, one line at a time", %{tmp_dir: tmp_dir} do
+      constraints = %{
+        variables: for(i <- 1..1000, do: {"x#{i}", :int, 0, 1000}),
+        constraints: for(i <- 2..1000, do: {:int_lt, "x#{i - 1}", "x#{i}"}),
+        objective: {:minimize, "x1000"}
+      }
+
+      flatzinc = FlatZincGenerator.generate(constraints)
+      path = Path.join(tmp_dir, "chain.fzn")
+
+      assert :ok = FlatZincGenerator.write_file(constraints, path)
+      assert File.read!(path) == flatzinc
+      assert Enum.count(FlatZincGenerator.stream(constraints)) > 1999
+      assert String.contains?(flatzinc, "constraint x1 < x2;")
+      assert String.contains?(flatzinc, "solve minimize x1000;")
+    end
+  end
 end
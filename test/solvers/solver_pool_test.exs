@@ -0,0 +1,144 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2025-present K. S. Ernest (iFire) Lee
+
+defmodule AriaPlanner.Solvers.SolverPoolTest do
+  use ExUnit.Case, async: true
+
+  alias AriaPlanner.Solvers.{AriaChuffedSolver, SolverPool}
+
+  @pool __MODULE__.Pool
+
+  # Eleven pigeons in ten holes: unsatisfiable, and slow to prove without global reasoning
+  @slow %{
+    variables: for(i <- 1..11, do: {"p#{i}", :int, 1, 10}),
+    constraints: [{:all_different, for(i <- 1..11, do: "p#{i}")}]
+  }
+
+  # The first solution is immediate; proving it optimal is not
+  @pigeons for(i <- 1..11, do: "p#{i}")
+  @seating %{
+    variables: [{"total", :int, 0, 200} | Enum.map(@pigeons, &{&1, :int, 1, 11})],
+    constraints: [{:all_different, @pigeons}, {:int_eq, "total", {:sum, @pigeons}}],
+    objective: {:minimize, "total"}
+  }
+
+  setup do
+    start_supervised!({SolverPool, name: @pool, size: 1, max_queue: 1})
+    :ok
+  end
+
+  test "streams improving solutions before the optimum" do
+    model = %{
+      variables: [{:x, :int, 1, 10}, {:y, :int, 1, 10}, {:area, :int, 0, 100}],
+      constraints: [{:int_eq, {:+, :x, :y}, 10}, {:int_eq, :area, {:*, :x, :y}}],
+      objective: {:maximize, :area}
+    }
+
+    parent = self()
+    on_solution = fn solution -> send(parent, {:seen, solution.objective}) end
+
+    assert {:ok, %{status: "optimal", objective: 25}} = SolverPool.solve(@pool, model, on_solution: on_solution)
+    assert_received {:seen, first}
+    assert first < 25
+    assert_received {:seen, 25}
+  end
+
+  test "refuses requests beyond the queue and cancels queued and running ones" do
+    assert {:ok, running} = SolverPool.async_solve(@pool, @slow)
+    assert {:ok, queued} = SolverPool.async_solve(@pool, @slow)
+    assert SolverPool.async_solve(@pool, @slow) == {:error, :overloaded}
+    assert SolverPool.stats(@pool) == %{running: 1, queued: 1}
+
+    assert SolverPool.cancel(@pool, running) == :ok
+    assert_receive {^running, {:done, {:error, "Cancelled"}}}
+    assert SolverPool.stats(@pool) == %{running: 1, queued: 0}
+
+    assert SolverPool.cancel(@pool, queued) == :ok
+    assert_receive {^queued, {:done, {:error, "Cancelled"}}}
+    assert SolverPool.cancel(@pool, queued) == {:error, :not_found}
+    assert SolverPool.stats(@pool) == %{running: 0, queued: 0}
+  end
+
+  test "applies to AriaChuffedSolver's synchronous entry points" do
+    assert {:ok, running} = SolverPool.async_solve(@pool, @slow)
+    assert {:ok, queued} = SolverPool.async_solve(@pool, @slow)
+
+    flatzinc = "var 1..10: x;\nsolve satisfy;\n"
+    assert AriaChuffedSolver.solve_flatzinc(flatzinc, pool: @pool) == {:error, :overloaded}
+
+    assert SolverPool.cancel(@pool, queued) == :ok
+    assert SolverPool.cancel(@pool, running) == :ok
+    assert {:ok, %{variables: %{"x" => _x}}} = AriaChuffedSolver.solve_flatzinc(flatzinc, pool: @pool)
+  end
+
+  test "sends nothing for a cancelled request after :done" do
+    assert {:ok, request} = SolverPool.async_solve(@pool, @seating, timeout: 60_000)
+    assert_receive {^request, {:solution, _solution}}, 5_000
+
+    assert SolverPool.cancel(@pool, request) == :ok
+    assert_receive {^request, {:done, {:error, "Cancelled"}}}
+    refute_receive {^request, _message}, 100
+  end
+
+  test "returns an error to a waiting caller when the pool goes down" do
+    start_supervised!(Supervisor.child_spec({SolverPool, name: __MODULE__.Doomed}, id: :doomed))
+
+    caller = Task.async(fn -> SolverPool.solve(__MODULE__.Doomed, @slow, timeout: 60_000) end)
+    wait_until(fn -> SolverPool.stats(__MODULE__.Doomed).running == 1 end)
+    stop_supervised!(:doomed)
+
+    assert {:error, "Solver pool down: " <> _reason} = Task.await(caller)
+  end
+
+  test "enforces each request's timeout" do
+    assert SolverPool.solve(@pool, @slow, timeout: 50) == {:error, "Timeout"}
+    assert SolverPool.stats(@pool) == %{running: 0, queued: 0}
+  end
+
+  describe "AriaChuffedSolver.stream_solutions/2" do
+    test "streams timestamped improving solutions, then the result" do
+      flatzinc = """
+      var 1..10: x;
+      var 1..10: y;
+      var 0..100: area;
+      constraint x + y = 10;
+      constraint area = x * y;
+      solve maximize area;
+      """
+
+      assert {:ok, stream} = AriaChuffedSolver.stream_solutions(flatzinc, pool: @pool)
+      events = Enum.to_list(stream)
+
+      {solutions, [{:done, {:ok, %{status: "optimal", objective: 25}}}]} = Enum.split(events, -1)
+      objectives = for {:solution, %{objective: objective, elapsed_ms: ms}} <- solutions, is_integer(ms), do: objective
+
+      assert length(objectives) == length(solutions)
+      assert objectives == Enum.sort(objectives)
+      assert List.last(objectives) == 25
+    end
+
+    test "stops searching when the consumer has what it needs" do
+      assert {:ok, stream} = AriaChuffedSolver.stream_solutions(@seating, pool: @pool, timeout: 60_000)
+      assert [{:solution, %{objective: 66}}] = Enum.take(stream, 1)
+      assert SolverPool.stats(@pool) == %{running: 0, queued: 0}
+    end
+
+    test "ends with an error when the pool goes down" do
+      start_supervised!(Supervisor.child_spec({SolverPool, name: __MODULE__.Doomed}, id: :doomed))
+      assert {:ok, stream} = AriaChuffedSolver.stream_solutions(@slow, pool: __MODULE__.Doomed, timeout: 60_000)
+
+      consumer = Task.async(fn -> Enum.to_list(stream) end)
+      wait_until(fn -> SolverPool.stats(__MODULE__.Doomed).running == 1 end)
+      stop_supervised!(:doomed)
+
+      assert [{:done, {:error, "Solver pool down: " <> _reason}}] = Task.await(consumer)
+    end
+  end
+
+  defp wait_until(done?) do
+    unless done?.() do
+      Process.sleep(5)
+      wait_until(done?)
+    end
+  end
+end
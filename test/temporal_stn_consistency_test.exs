@@ -5,7 +5,7 @@ defmodule AriaPlanner.Planner.Temporal.STN.ConsistencyTest do
   use ExUnit.Case, async: true
 
   alias AriaPlanner.Planner.Temporal.STN
-  alias AriaPlanner.Planner.Temporal.STN.Consistency
+  alias AriaPlanner.Planner.Temporal.STN.{Consistency, PathConsistency}
 
   describe "consistent?/1" do
     test "returns true for empty STN" do
@@ -39,6 +39,28 @@ defmodule AriaPlanner.Planner.Temporal.STN.ConsistencyTest do
       refute Consistency.consistent?(stn)
     end
 
+    test "detects inconsistency propagated through a chain of constraints" do
+      stn =
+        STN.new()
+        |> STN.add_constraint("a", "b", {5, 10})
+        |> STN.add_constraint("b", "c", {5, 10})
+
+      assert Consistency.consistent?(stn)
+      refute Consistency.consistent?(STN.add_constraint(stn, "a", "c", {0, 8}))
+      assert Consistency.consistent?(STN.add_constraint(stn, "a", "c", {0, 12}))
+    end
+
+    test "tracks bounds along long chains" do
+      stn =
+        Enum.reduce(1..200, STN.new(), fn i, stn ->
+          STN.add_constraint(stn, "t#{i - 1}", "t#{i}", {1, 2})
+        end)
+
+      assert Consistency.consistent?(stn)
+      assert PathConsistency.bounds(stn.network, "t0", "t200") == {200, 400}
+      refute Consistency.consistent?(STN.add_constraint(stn, "t200", "t0", {0, 10}))
+    end
+
     test "returns false for error" do
       refute Consistency.consistent?({:error, "some error"})
     end
@@ -48,4 +70,59 @@ defmodule AriaPlanner.Planner.Temporal.STN.ConsistencyTest do
       refute Consistency.consistent?(nil)
     end
   end
+
+  describe "PathConsistency" do
+    test "keeps minimal bounds between every pair of time points" do
+      network =
+        PathConsistency.from_constraints([
+          {:start, "b", 5, 10},
+          {"b", "c", 5, 10},
+          {:start, "c", 0, 12}
+        ])
+
+      assert PathConsistency.consistent?(network)
+      assert PathConsistency.bounds(network, :start, "c") == {10, 12}
+      assert PathConsistency.bounds(network, "b", "c") == {5, 7}
+      assert PathConsistency.bounds(network, "c", :start) == {-12, -10}
+      assert PathConsistency.bounds(network, :start, "unknown") == {:neg_infinity, :infinity}
+    end
+
+    test "is rebuilt when the constraints it was built from change" do
+      stn = STN.add_constraint(STN.new(), "a", "b", {1, 5})
+      network = Consistency.network(stn)
+
+      assert network == stn.network
+      refute Consistency.network(%STN{stn | constraints: %{}}) == stn.network
+    end
+  end
+
+  describe "AriaStnSolver.solve_batch/2" do
+    test "returns each network's minimal bounds or inconsistency, in order" do
+      chain =
+        STN.new()
+        |> STN.add_constraint("a", "b", {5, 10})
+        |> STN.add_constraint("b", "c", {5, 10})
+        |> STN.add_constraint("a", "c", {0, 12})
+
+      paradox = %{{"a", "b"} => {10, 10_000}, {"b", "a"} => {10, 10_000}}
+      atoms = [{:start, :end, 1, 4}, {:end, :after, 0, :infinity}]
+
+      assert [{:consistent, solved}, {:inconsistent, _reason}, {:consistent, atoms_solved}] =
+               AriaStnSolver.solve_batch([chain, paradox, atoms], chunk_size: 2)
+
+      for from <- ["a", "b", "c"], to <- ["a", "b", "c"] do
+        assert PathConsistency.bounds(solved, from, to) == PathConsistency.bounds(chain.network, from, to)
+      end
+
+      assert PathConsistency.bounds(atoms_solved, :start, :after) == {1, :infinity}
+    end
+
+    test "reports the networks of a chunk that overran the timeout" do
+      # Large enough that one chunk cannot be solved within a millisecond
+      points = for i <- 1..1000, do: {i, i + 1, 1, 2}
+
+      assert [{:error, :timeout}, {:error, :timeout}] =
+               AriaStnSolver.solve_batch([points, points], chunk_size: 2, timeout: 1)
+    end
+  end
 end
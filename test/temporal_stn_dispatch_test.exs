@@ -0,0 +1,111 @@
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2025-present K. S. Ernest (iFire) Lee
+
+defmodule AriaPlanner.Planner.Temporal.STN.DispatchTest do
+  use ExUnit.Case, async: true
+
+  alias AriaPlanner.Planner.Temporal.STN
+  alias AriaPlanner.Planner.Temporal.STN.Dispatch
+
+  defp chain do
+    STN.new()
+    |> STN.add_constraint("origin", "a", {5, 10})
+    |> STN.add_constraint("a", "b", {2, 4})
+  end
+
+  describe "new/2" do
+    test "gives every time point its window relative to the origin" do
+      {:ok, dispatch} = STN.dispatchable(chain(), origin: "origin")
+
+      assert Dispatch.window(dispatch, "origin") == {0, 0}
+      assert Dispatch.window(dispatch, "a") == {5, 10}
+      assert Dispatch.window(dispatch, "b") == {7, 14}
+      assert Dispatch.enabled(dispatch) == ["a"]
+    end
+
+    test "drops dominated edges" do
+      stn =
+        STN.new()
+        |> STN.add_constraint("a", "b", {1, 5})
+        |> STN.add_constraint("b", "c", {1, 5})
+
+      {:ok, dispatch} = Dispatch.new(stn)
+
+      assert Enum.sort(Dispatch.edges(dispatch)) == [{"a", "b", 5}, {"b", "a", -1}, {"b", "c", 5}, {"c", "b", -1}]
+    end
+
+    test "rejects inconsistent networks" do
+      stn = %STN{STN.new() | constraints: %{{"a", "b"} => {10, 10_000}, {"b", "a"} => {10, 10_000}}}
+
+      assert {:error, _reason} = Dispatch.new(stn)
+    end
+  end
+
+  describe "observe/3" do
+    test "tightens the windows of neighbouring time points" do
+      {:ok, dispatch} = STN.dispatchable(chain(), origin: "origin")
+      {:ok, dispatch} = Dispatch.observe(dispatch, "a", 8)
+
+      assert Dispatch.window(dispatch, "a") == {8, 8}
+      assert Dispatch.window(dispatch, "b") == {10, 12}
+      assert Dispatch.executed(dispatch) == %{"origin" => 0, "a" => 8}
+    end
+
+    test "refuses observations that would break a constraint" do
+      {:ok, dispatch} = STN.dispatchable(chain(), origin: "origin")
+
+      assert Dispatch.observe(dispatch, "b", 9) == {:error, :not_enabled}
+      assert Dispatch.observe(dispatch, "a", 11) == {:error, :outside_window}
+      assert Dispatch.observe(dispatch, "origin", 0) == {:error, :already_executed}
+      assert Dispatch.observe(dispatch, "missing", 0) == {:error, :unknown_time_point}
+
+      {:ok, dispatch} = Dispatch.observe(dispatch, "a", 8)
+      assert Dispatch.observe(dispatch, "b", 13) == {:error, :outside_window}
+    end
+  end
+
+  describe "schedule/1" do
+    test "completes a schedule satisfying every constraint, rigid components included" do
+      constraints = [
+        {"a", "b", 3, 3},
+        {"b", "c", 0, 0},
+        {"c", "d", 1, 6},
+        {"a", "d", 0, 5},
+        {"e", "a", 2, :infinity},
+        {"d", "f", -2, 2}
+      ]
+
+      {:ok, dispatch} = Dispatch.new(constraints)
+      {:ok, schedule} = Dispatch.schedule(dispatch)
+
+      for {from, to, min, max} <- constraints do
+        difference = schedule[to] - schedule[from]
+        assert difference >= min
+        assert max == :infinity or difference <= max
+      end
+
+      assert schedule["e"] == 0
+      assert schedule["a"] == 2
+    end
+  end
+
+  describe "AriaStnSolver.solve_stn/1" do
+    test "tightens an STN's constraints to its minimal network" do
+      stn =
+        STN.new()
+        |> STN.add_constraint("a", "b", {0, 10})
+        |> STN.add_constraint("b", "c", {0, 10})
+        |> STN.add_constraint("a", "c", {0, 5})
+
+      assert {:ok, %STN{} = solved} = AriaStnSolver.solve_stn(stn)
+      assert solved.constraints[{"a", "b"}] == {0, 5}
+      assert solved.constraints[{"c", "b"}] == {-5, 0}
+      assert STN.consistent?(solved)
+    end
+
+    test "returns constraint lists in dispatchable form" do
+      assert {:ok, %Dispatch{} = dispatch} = AriaStnSolver.solve_stn([{:start, :end, 5, 10}])
+      assert {:ok, %{start: 0, end: 5}} = Dispatch.schedule(dispatch)
+    end
+  end
+end
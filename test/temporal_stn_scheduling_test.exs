@@ -5,7 +5,7 @@ defmodule AriaPlanner.Planner.Temporal.STN.SchedulingTest do
   use ExUnit.Case, async: true
 
   alias AriaPlanner.Planner.Temporal.STN
-  alias AriaPlanner.Planner.Temporal.STN.Scheduling
+  alias AriaPlanner.Planner.Temporal.STN.{IntervalIndex, Scheduling}
 
   describe "get_intervals/1" do
     test "returns empty list for STN with no intervals" do
@@ -148,4 +148,55 @@ defmodule AriaPlanner.Planner.Temporal.STN.SchedulingTest do
       assert gap.end_time == 10
     end
   end
+
+  describe "interval index" do
+    test "is kept up to date by solving and rescaling" do
+      stn =
+        STN.new(time_unit: :second, lod_level: :medium)
+        |> STN.add_constraint("task1_start", "task1_end", {100, 300})
+        |> STN.add_constraint("task2_start", "task2_end", {200, 200})
+        |> STN.add_constraint("task1_start", "task2_start", {0, 50})
+
+      {:ok, solved} = AriaStnSolver.solve_stn(stn)
+
+      for updated <- [solved, STN.Units.rescale_lod(stn, :low), STN.Units.convert_units(stn, :minute)] do
+        # Already in sync, so queries use it as it is instead of rebuilding it
+        assert IntervalIndex.sync(updated.intervals, updated) === updated.intervals
+        assert IntervalIndex.to_list(updated.intervals) == IntervalIndex.to_list(IntervalIndex.sync(nil, updated))
+      end
+    end
+
+    test "follows constraints added, tightened and removed" do
+      stn =
+        Enum.reduce(1..40, STN.new(), fn i, stn ->
+          STN.add_constraint(stn, "task#{i}_start", "task#{i}_end", {i, i + rem(i, 3) * 2})
+        end)
+
+      stn = STN.add_constraint(stn, "task7_start", "task7_end", {30, 30})
+      stn = STN.Operations.remove_constraint(stn, "task9_start", "task9_end")
+
+      assert IntervalIndex.to_list(stn.intervals) == IntervalIndex.to_list(IntervalIndex.sync(nil, stn))
+
+      for {query_start, query_end} <- [{0, 0}, {12, 18}, {29, 31}, {41, 60}] do
+        expected =
+          stn
+          |> Scheduling.get_intervals()
+          |> Enum.filter(&(&1.start_time <= query_end and query_start <= &1.end_time))
+
+        assert Scheduling.get_overlapping_intervals(stn, query_start, query_end) == expected
+      end
+
+      ids = stn |> Scheduling.get_overlapping_intervals(29, 31) |> Enum.map(& &1.id)
+      assert "task7" in ids
+      refute "task9" in ids
+      assert "task30" in ids
+    end
+
+    test "is rebuilt for STNs whose constraints were replaced" do
+      stn = STN.add_constraint(STN.new(), "task_start", "task_end", {10, 10})
+      stretched = %STN{stn | constraints: %{{"task_start", "task_end"} => {40, 40}}}
+
+      assert [%{end_time: 40}] = Scheduling.get_intervals(stretched)
+    end
+  end
 end
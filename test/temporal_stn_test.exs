@@ -52,4 +52,22 @@ defmodule AriaPlanner.Planner.Temporal.STNTest do
       assert STN.consistent?(stn) == true
     end
   end
+
+  describe "time point ids" do
+    test "interns each time point once and keeps its id across rebuilds" do
+      stn =
+        STN.new()
+        |> STN.add_constraint("a", "b", {1, 5})
+        |> STN.add_constraint(:start, "a", {0, 2})
+
+      assert STN.time_point_id(stn, "a") == 0
+      assert STN.time_point_id(stn, :start) == 2
+      assert STN.time_point_name(stn, 1) == "b"
+      assert STN.time_point_id(stn, "missing") == nil
+
+      doubled = Map.new(stn.constraints, fn {pair, {min, max}} -> {pair, {min * 2, max * 2}} end)
+      rescaled = %STN{stn | constraints: doubled}
+      assert STN.time_point_id(rescaled, :start) == 2
+    end
+  end
 end
@@ -207,6 +207,40 @@ defmodule AriaPlanner.Planner.Temporal.STN.UnitsTest do
       assert rescaled_stn.lod_resolution == 1000
     end
 
+    test "keeps infinite bounds infinite" do
+      stn = STN.new(time_unit: :second, lod_level: :medium)
+      stn = %{stn | constraints: %{{"start", "end"} => {150, :infinity}, {"end", "start"} => {:neg_infinity, -150}}}
+
+      rescaled_stn = Units.rescale_lod(stn, :low)
+
+      assert rescaled_stn.constraints[{"start", "end"}] == {15, :infinity}
+      assert rescaled_stn.constraints[{"end", "start"}] == {:neg_infinity, -15}
+    end
+
+    test "scales the constraints as given, without tightening them" do
+      stn =
+        STN.new(time_unit: :second, lod_level: :medium)
+        |> STN.add_constraint("a", "b", {0, 200})
+        |> STN.add_constraint("a", "c", {0, 50})
+        |> STN.add_constraint("c", "b", {0, 50})
+
+      rescaled_stn = Units.rescale_lod(stn, :low)
+
+      assert rescaled_stn.constraints[{"a", "b"}] == {0, 20}
+      assert STN.consistent?(rescaled_stn)
+    end
+
+    test "notices when rounding made the STN inconsistent" do
+      stn =
+        STN.new(time_unit: :second, lod_level: :medium)
+        |> STN.add_constraint("a", "b", {15, 15})
+        |> STN.add_constraint("b", "c", {15, 15})
+        |> STN.add_constraint("a", "c", {30, 30})
+
+      assert STN.consistent?(stn)
+      refute STN.consistent?(Units.rescale_lod(stn, :low))
+    end
+
     test "returns same STN when LOD level unchanged" do
       stn = STN.new(time_unit: :second, lod_level: :medium)
       rescaled_stn = Units.rescale_lod(stn, :medium)